@@ -1,5 +1,9 @@
 -- DuckSync PostgreSQL Schema
 -- This schema stores metadata for cache definitions and state tracking
+--
+-- sources, caches, state and table_snapshots are append-only: every write inserts a row with a
+-- newer version, deleted = TRUE marks a removed key, and readers take the latest version per key.
+-- Superseded rows are removed by periodic compaction.
 
 -- Create the ducksync schema
 CREATE SCHEMA IF NOT EXISTS ducksync;
@@ -11,14 +15,17 @@ CREATE SCHEMA IF NOT EXISTS ducksync;
 -- ducksync.sources: Snowflake account connections
 --============================================================================
 CREATE TABLE IF NOT EXISTS ducksync.sources (
-    source_name VARCHAR(255) PRIMARY KEY,
-    driver_type VARCHAR(50) NOT NULL DEFAULT 'snowflake',
-    secret_name VARCHAR(255) NOT NULL,  -- References DuckDB CREATE SECRET name
+    source_name VARCHAR(255) NOT NULL,
+    driver_type VARCHAR(50) DEFAULT 'snowflake',  -- NULL on tombstones
+    secret_name VARCHAR(255),  -- References DuckDB CREATE SECRET name
     passthrough_enabled BOOLEAN DEFAULT FALSE,
     created_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
+    version BIGINT,  -- epoch microseconds of the write, raised above the key's newest version; latest wins
+    deleted BOOLEAN DEFAULT FALSE,
+    PRIMARY KEY (source_name, version),
     
     -- Constraints
-    CONSTRAINT chk_driver_type CHECK (driver_type IN ('snowflake'))
+    CONSTRAINT chk_driver_type CHECK (driver_type IS NULL OR driver_type IN ('snowflake'))
 );
 
 -- Index for quick lookups
@@ -34,19 +41,34 @@ COMMENT ON COLUMN ducksync.sources.passthrough_enabled IS 'Allow passthrough que
 -- ducksync.caches: Query result cache definitions
 --============================================================================
 CREATE TABLE IF NOT EXISTS ducksync.caches (
-    cache_name VARCHAR(255) PRIMARY KEY,
-    source_name VARCHAR(255) NOT NULL REFERENCES ducksync.sources(source_name) ON DELETE CASCADE,
-    source_query TEXT NOT NULL,
-    monitor_tables TEXT[] NOT NULL,  -- Array of fully-qualified table names to monitor
+    cache_name VARCHAR(255) NOT NULL,
+    source_name VARCHAR(255),  -- NULL on tombstones
+    source_query TEXT,
+    monitor_tables TEXT[],  -- Array of fully-qualified table names to monitor
     ttl_seconds INTEGER,  -- NULL = no expiration (reference data)
-    invalidation_mode VARCHAR(50) NOT NULL DEFAULT 'last_altered',
+    invalidation_mode VARCHAR(50) DEFAULT 'last_altered',
     metadata_secret_name VARCHAR(255),
     created_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
+    split_column VARCHAR(255),  -- NULL = single extraction stream
+    parallelism BIGINT DEFAULT 0,  -- 0 = sized from the source row count
+    snapshot_retention VARCHAR(64),  -- DuckLake snapshot retention interval; NULL = ducksync_snapshot_retention
+    file_retention VARCHAR(64),  -- retention of unreferenced data files; NULL = ducksync_file_retention
+    sort_by TEXT,  -- ORDER BY list applied to refresh writes
+    row_group_size BIGINT,  -- Parquet rows per row group; NULL = DuckLake default
+    target_file_size VARCHAR(32),  -- NULL = ducksync_ingest_target_file_size
+    compression VARCHAR(32),  -- Parquet codec; NULL = DuckLake default
+    bloom_filter_columns TEXT[],  -- columns written with Parquet Bloom filters
+    partition_by TEXT[],  -- DuckLake partition keys, e.g. {region,year(event_date)}
+    memory_tier BOOLEAN,  -- keep an in-memory copy for low-latency reads
+    version BIGINT,
+    deleted BOOLEAN DEFAULT FALSE,
+    PRIMARY KEY (cache_name, version),
     
     -- Constraints
     CONSTRAINT chk_ttl_positive CHECK (ttl_seconds IS NULL OR ttl_seconds > 0),
-    CONSTRAINT chk_monitor_tables_not_empty CHECK (array_length(monitor_tables, 1) > 0),
-    CONSTRAINT chk_invalidation_mode CHECK (invalidation_mode IN ('last_altered', 'two_stage', 'ttl_only', 'manual'))
+    CONSTRAINT chk_monitor_tables_not_empty CHECK (deleted OR array_length(monitor_tables, 1) > 0),
+    CONSTRAINT chk_invalidation_mode CHECK (invalidation_mode IS NULL OR invalidation_mode IN ('last_altered', 'two_stage', 'ttl_only', 'manual')),
+    CONSTRAINT chk_parallelism CHECK (parallelism IS NULL OR parallelism >= 0)
 );
 
 -- Index for source lookups
@@ -71,13 +93,16 @@ ADD COLUMN IF NOT EXISTS metadata_secret_name VARCHAR(255);
 -- ducksync.state: Runtime cache state tracking
 --============================================================================
 CREATE TABLE IF NOT EXISTS ducksync.state (
-    cache_name VARCHAR(255) PRIMARY KEY REFERENCES ducksync.caches(cache_name) ON DELETE CASCADE,
+    cache_name VARCHAR(255) NOT NULL,
     last_refresh TIMESTAMP WITH TIME ZONE,
     source_state_hash TEXT,  -- JSON hash of {table_name: last_altered_timestamp}
     expires_at TIMESTAMP WITH TIME ZONE,  -- NULL if no TTL
     refresh_count INTEGER DEFAULT 0,
     last_row_count BIGINT,
-    last_duration_ms DOUBLE PRECISION
+    last_duration_ms DOUBLE PRECISION,
+    version BIGINT,
+    deleted BOOLEAN DEFAULT FALSE,
+    PRIMARY KEY (cache_name, version)
 );
 
 -- Index for expiration checks
@@ -88,7 +113,7 @@ COMMENT ON COLUMN ducksync.state.cache_name IS 'Reference to cache definition';
 COMMENT ON COLUMN ducksync.state.last_refresh IS 'Timestamp of last successful refresh';
 COMMENT ON COLUMN ducksync.state.source_state_hash IS 'Hash of source table metadata for change detection';
 COMMENT ON COLUMN ducksync.state.expires_at IS 'When cache expires (calculated from TTL)';
-COMMENT ON COLUMN ducksync.state.refresh_count IS 'Total number of refreshes performed';
+COMMENT ON COLUMN ducksync.state.refresh_count IS 'Total number of refreshes performed (carried forward by each new version)';
 COMMENT ON COLUMN ducksync.state.last_row_count IS 'Number of rows from last refresh';
 COMMENT ON COLUMN ducksync.state.last_duration_ms IS 'Duration of last refresh in milliseconds';
 
@@ -96,12 +121,13 @@ COMMENT ON COLUMN ducksync.state.last_duration_ms IS 'Duration of last refresh i
 -- ducksync.table_snapshots: Persisted Stage 1 rows/bytes snapshots
 --============================================================================
 CREATE TABLE IF NOT EXISTS ducksync.table_snapshots (
-    cache_name VARCHAR(255) NOT NULL REFERENCES ducksync.caches(cache_name) ON DELETE CASCADE,
-    source_table VARCHAR(255) NOT NULL,
-    source_rows BIGINT NOT NULL,
-    source_bytes BIGINT NOT NULL,
+    cache_name VARCHAR(255) NOT NULL,
+    source_table VARCHAR(255),  -- NULL on tombstones
+    source_rows BIGINT,
+    source_bytes BIGINT,
     snapshot_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
-    PRIMARY KEY (cache_name, source_table)
+    version BIGINT,  -- shared by all rows of one snapshot set; the newest set is current
+    deleted BOOLEAN DEFAULT FALSE
 );
 
 COMMENT ON TABLE ducksync.table_snapshots IS 'Persisted Stage 1 Snowflake SHOW TABLES rows/bytes snapshots';
@@ -110,6 +136,69 @@ COMMENT ON COLUMN ducksync.table_snapshots.source_table IS 'Fully-qualified sour
 COMMENT ON COLUMN ducksync.table_snapshots.source_rows IS 'Last observed SHOW TABLES rows value';
 COMMENT ON COLUMN ducksync.table_snapshots.source_bytes IS 'Last observed SHOW TABLES bytes value';
 
+--============================================================================
+-- ducksync.refresh_leases: Cross-node single-flight refresh leases
+--============================================================================
+CREATE TABLE IF NOT EXISTS ducksync.refresh_leases (
+    cache_name VARCHAR(255) NOT NULL,
+    owner_id VARCHAR(255) NOT NULL,
+    acquired_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
+    expires_at TIMESTAMP WITH TIME ZONE,
+    released BOOLEAN DEFAULT FALSE
+);
+
+COMMENT ON TABLE ducksync.refresh_leases IS 'Claims on in-progress refreshes; the earliest live claim per cache is the leader';
+COMMENT ON COLUMN ducksync.refresh_leases.owner_id IS 'Node/attempt holding the claim';
+COMMENT ON COLUMN ducksync.refresh_leases.expires_at IS 'Claim lapses after this time so a crashed node cannot block refreshes';
+COMMENT ON COLUMN ducksync.refresh_leases.released IS 'TRUE marks a release row that retires every claim of owner_id; rows are only appended';
+
+--============================================================================
+-- ducksync.refresh_history: One row per refresh call (appended in batches)
+--============================================================================
+CREATE TABLE IF NOT EXISTS ducksync.refresh_history (
+    cache_name VARCHAR(255) NOT NULL,
+    started_at TIMESTAMP,  -- UTC
+    refresh_trigger VARCHAR(50),  -- manual, query, scheduler, rehydrate
+    decision VARCHAR(50),  -- e.g. initial, ttl_expired, source_changed, fresh, stage1_unchanged, evicted
+    result VARCHAR(50),  -- REFRESHED, SKIPPED, ERROR, LEASE_BUSY
+    message TEXT,
+    total_ms DOUBLE PRECISION,
+    probe_ms DOUBLE PRECISION,
+    fetch_ms DOUBLE PRECISION,
+    write_ms DOUBLE PRECISION,
+    commit_ms DOUBLE PRECISION,
+    state_ms DOUBLE PRECISION,
+    rows_refreshed BIGINT,
+    bytes_written BIGINT,
+    files_created BIGINT,
+    peak_memory_bytes BIGINT
+);
+
+COMMENT ON TABLE ducksync.refresh_history IS 'Per-call refresh decisions and phase timings for capacity planning';
+COMMENT ON COLUMN ducksync.refresh_history.probe_ms IS 'Snowflake metadata probes (SHOW TABLES / last_altered)';
+COMMENT ON COLUMN ducksync.refresh_history.fetch_ms IS 'Source query streamed into the staging table';
+COMMENT ON COLUMN ducksync.refresh_history.write_ms IS 'Staged rows swapped into the live cache table';
+COMMENT ON COLUMN ducksync.refresh_history.commit_ms IS 'DuckLake commit of the swap';
+COMMENT ON COLUMN ducksync.refresh_history.state_ms IS 'State and snapshot bookkeeping';
+COMMENT ON COLUMN ducksync.refresh_history.peak_memory_bytes IS 'Peak buffer manager usage, sampled per chunk during fetch and write and after the swap';
+
+--============================================================================
+-- ducksync.usage_stats: Read counters per cache, appended as deltas by each node
+--============================================================================
+CREATE TABLE IF NOT EXISTS ducksync.usage_stats (
+    cache_name VARCHAR(255),  -- NULL for a source's passthrough queries
+    source_name VARCHAR(255),
+    scan_hits BIGINT,
+    query_hits BIGINT,
+    passthrough_misses BIGINT,
+    rows_served BIGINT,
+    bytes_avoided BIGINT,
+    flushed_at TIMESTAMP  -- UTC
+);
+
+COMMENT ON TABLE ducksync.usage_stats IS 'Counts recorded between two flushes of one node; ducksync_stats() sums them';
+COMMENT ON COLUMN ducksync.usage_stats.bytes_avoided IS 'Hits times the size of the cache data files at flush time';
+
 --============================================================================
 -- Helper Views
 --============================================================================
@@ -1,7 +1,11 @@
 #include "cleanup_manager.hpp"
 #include "duckdb/main/connection.hpp"
 #include "duckdb/main/client_context.hpp"
+#include "duckdb/main/database.hpp"
 #include "duckdb/common/exception.hpp"
+#include "duckdb/common/types/interval.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include <chrono>
 #include <sstream>
 
 namespace duckdb {
@@ -11,160 +15,292 @@ static Connection MakeConnection(ClientContext &context) {
 	return Connection(*context.db);
 }
 
-CleanupManager::CleanupManager(ClientContext &context, DuckSyncStorageManager &storage_manager)
-    : context_(context), storage_manager_(storage_manager) {
+static std::string Quote(const std::string &text) {
+	return KeywordHelper::WriteQuoted(text, '\'');
 }
 
-CleanupManager::~CleanupManager() {
+// The longest of a set of interval texts, normalized to DuckDB's interval spelling
+static std::string LongestRetention(const std::vector<std::string> &retentions) {
+	interval_t longest;
+	bool has_longest = false;
+	for (auto &retention : retentions) {
+		auto interval = Value(retention).DefaultCastAs(LogicalType::INTERVAL).GetValue<interval_t>();
+		if (!has_longest || Interval::GetMicro(interval) > Interval::GetMicro(longest)) {
+			longest = interval;
+			has_longest = true;
+		}
+	}
+	return Value::INTERVAL(longest).ToString();
 }
 
-CleanupResult CleanupManager::CleanupCache(const std::string &cache_name, const std::string &source_name) {
-	CleanupResult result;
-	result.snapshots_expired = 0;
-	result.files_cleaned = 0;
-	result.orphans_deleted = 0;
-
-	try {
-		// Run all cleanup operations
-		result.snapshots_expired = ExpireSnapshots(cache_name, source_name);
-		result.files_cleaned = CleanupOldFiles(cache_name, source_name);
-		result.orphans_deleted = DeleteOrphanedFiles(cache_name, source_name);
+CleanupManager::CleanupManager(ClientContext &context, DuckSyncMetadataManager &metadata_manager,
+                               DuckSyncStorageManager &storage_manager)
+    : context_(context), metadata_manager_(metadata_manager), storage_manager_(storage_manager) {
+}
 
-		std::ostringstream msg;
-		msg << "Cleanup completed: " << result.snapshots_expired << " snapshots expired, " << result.files_cleaned
-		    << " old files cleaned, " << result.orphans_deleted << " orphaned files deleted";
-		result.message = msg.str();
+CleanupManager::~CleanupManager() {
+}
 
-	} catch (const std::exception &e) {
-		result.message = std::string("Cleanup error: ") + e.what();
+CleanupResult CleanupManager::CleanupCache(const std::string &cache_name) {
+	CacheDefinition cache;
+	if (!metadata_manager_.GetCache(cache_name, cache)) {
+		throw InvalidInputException("Cache '%s' not found", cache_name);
 	}
 
+	// Retention is resolved across all caches, so cleaning up for one never cuts another's history
+	auto result = CleanupAll();
+	result.message = "Cleanup for '" + cache_name + "' (catalog-wide): " + result.message;
 	return result;
 }
 
 CleanupResult CleanupManager::CleanupAll() {
-	CleanupResult total_result;
-	total_result.snapshots_expired = 0;
-	total_result.files_cleaned = 0;
-	total_result.orphans_deleted = 0;
+	CleanupResult result;
 
 	if (!storage_manager_.IsAttached()) {
-		total_result.message = "DuckLake not attached, no cleanup performed";
-		return total_result;
+		result.message = "DuckLake not attached, no cleanup performed";
+		return result;
 	}
 
-	auto conn = MakeConnection(context_);
-	std::string ducklake_name = storage_manager_.GetDuckLakeName();
-
-	try {
-		// Expire old snapshots globally
-		std::ostringstream expire_sql;
-		expire_sql << "CALL ducklake_expire_snapshots('" << ducklake_name << "', older_than => INTERVAL '1 day');";
-		auto expire_result = conn.Query(expire_sql.str());
-		if (!expire_result->HasError()) {
-			total_result.snapshots_expired = expire_result->RowCount();
-		}
-
-		// Cleanup old files globally
-		std::ostringstream cleanup_sql;
-		cleanup_sql << "CALL ducklake_cleanup_old_files('" << ducklake_name << "', older_than => INTERVAL '7 days');";
-		auto cleanup_result = conn.Query(cleanup_sql.str());
-		if (!cleanup_result->HasError()) {
-			total_result.files_cleaned = cleanup_result->RowCount();
-		}
-
-		// Delete orphaned files globally
-		std::ostringstream orphan_sql;
-		orphan_sql << "CALL ducklake_delete_orphaned_files('" << ducklake_name << "');";
-		auto orphan_result = conn.Query(orphan_sql.str());
-		if (!orphan_result->HasError()) {
-			total_result.orphans_deleted = orphan_result->RowCount();
-		}
+	result.snapshot_retention = EffectiveSnapshotRetention();
+	result.file_retention = EffectiveFileRetention();
 
-		std::ostringstream msg;
-		msg << "Global cleanup completed: " << total_result.snapshots_expired << " snapshots expired, "
-		    << total_result.files_cleaned << " old files cleaned, " << total_result.orphans_deleted
-		    << " orphaned files deleted";
-		total_result.message = msg.str();
+	// Superseded metadata versions go first, so the snapshots that deleted them age out with the rest
+	metadata_manager_.CompactMetadata();
 
-	} catch (const std::exception &e) {
-		total_result.message = std::string("Global cleanup error: ") + e.what();
-	}
+	result.snapshots_expired = ExpireSnapshots(result.snapshot_retention);
+	result.files_cleaned = CleanupOldFiles(result.file_retention, result.bytes_reclaimed);
+	result.orphans_deleted = DeleteOrphanedFiles(result.file_retention, result.bytes_reclaimed);
 
-	return total_result;
+	std::ostringstream msg;
+	msg << result.snapshots_expired << " snapshots expired (older than " << result.snapshot_retention << "), "
+	    << result.files_cleaned << " old files cleaned, " << result.orphans_deleted
+	    << " orphaned files deleted (older than " << result.file_retention << "), " << result.bytes_reclaimed
+	    << " bytes reclaimed";
+	result.message = msg.str();
+	return result;
 }
 
-int64_t CleanupManager::ExpireSnapshots(const std::string &cache_name, const std::string &source_name) {
+int64_t CleanupManager::ExpireSnapshots(const std::string &older_than) {
 	if (!storage_manager_.IsAttached()) {
 		return 0;
 	}
 
 	auto conn = MakeConnection(context_);
-
-	// Get the table name
-	std::string table_name = storage_manager_.GetDuckLakeTableName(cache_name, source_name);
-
-	// Call DuckLake expire snapshots for this table
 	std::ostringstream sql;
-	sql << "CALL ducklake_expire_snapshots('" << table_name << "', "
-	    << "older_than => INTERVAL '1 day');";
+	sql << "CALL ducklake_expire_snapshots(" << Quote(storage_manager_.GetDuckLakeName())
+	    << ", older_than => now() - INTERVAL " << Quote(older_than) << ");";
 
 	auto result = conn.Query(sql.str());
 	if (result->HasError()) {
-		// DuckLake cleanup functions may not exist or table may not have snapshots
-		// This is not a fatal error
-		return 0;
+		throw IOException("Failed to expire snapshots: " + result->GetError());
 	}
-
 	return result->RowCount();
 }
 
-int64_t CleanupManager::CleanupOldFiles(const std::string &cache_name, const std::string &source_name,
-                                        int64_t older_than_days) {
+int64_t CleanupManager::CleanupOldFiles(const std::string &older_than, int64_t &bytes_reclaimed) {
 	if (!storage_manager_.IsAttached()) {
 		return 0;
 	}
 
 	auto conn = MakeConnection(context_);
-
-	// Get the table name
-	std::string table_name = storage_manager_.GetDuckLakeTableName(cache_name, source_name);
-
-	// Call DuckLake cleanup old files for this table
 	std::ostringstream sql;
-	sql << "CALL ducklake_cleanup_old_files('" << table_name << "', "
-	    << "older_than => INTERVAL '" << older_than_days << " days');";
+	sql << "CALL ducklake_cleanup_old_files(" << Quote(storage_manager_.GetDuckLakeName())
+	    << ", older_than => now() - INTERVAL " << Quote(older_than);
 
-	auto result = conn.Query(sql.str());
+	bytes_reclaimed += MeasureFiles(conn, sql.str() + ", dry_run => true);");
+	auto result = conn.Query(sql.str() + ");");
 	if (result->HasError()) {
-		// Not a fatal error if cleanup function doesn't exist
-		return 0;
+		throw IOException("Failed to clean up old files: " + result->GetError());
 	}
-
 	return result->RowCount();
 }
 
-int64_t CleanupManager::DeleteOrphanedFiles(const std::string &cache_name, const std::string &source_name) {
+int64_t CleanupManager::DeleteOrphanedFiles(const std::string &older_than, int64_t &bytes_reclaimed) {
 	if (!storage_manager_.IsAttached()) {
 		return 0;
 	}
 
+	// The age bound keeps files of in-flight staging writes, which are not yet in the catalog
 	auto conn = MakeConnection(context_);
-
-	// Get the table name
-	std::string table_name = storage_manager_.GetDuckLakeTableName(cache_name, source_name);
-
-	// Call DuckLake delete orphaned files for this table
 	std::ostringstream sql;
-	sql << "CALL ducklake_delete_orphaned_files('" << table_name << "');";
+	sql << "CALL ducklake_delete_orphaned_files(" << Quote(storage_manager_.GetDuckLakeName())
+	    << ", older_than => now() - INTERVAL " << Quote(older_than);
 
-	auto result = conn.Query(sql.str());
+	bytes_reclaimed += MeasureFiles(conn, sql.str() + ", dry_run => true);");
+	auto result = conn.Query(sql.str() + ");");
 	if (result->HasError()) {
-		// Not a fatal error if cleanup function doesn't exist
-		return 0;
+		throw IOException("Failed to delete orphaned files: " + result->GetError());
 	}
-
 	return result->RowCount();
 }
 
+int64_t CleanupManager::MeasureFiles(Connection &conn, const std::string &dry_run_sql) {
+	auto listing = conn.Query(dry_run_sql);
+	if (listing->HasError()) {
+		throw IOException("Failed to list files for cleanup: " + listing->GetError());
+	}
+
+	// read_blob without its content column only stats the files. Sizes are informational: a batch
+	// that cannot be read (e.g. a file already gone) is left out rather than failing the cleanup.
+	int64_t total_bytes = 0;
+	for (idx_t start = 0; start < listing->RowCount(); start += SIZE_PROBE_BATCH) {
+		std::ostringstream size_sql;
+		size_sql << "SELECT COALESCE(SUM(size), 0) FROM read_blob([";
+		auto end = MinValue<idx_t>(start + SIZE_PROBE_BATCH, listing->RowCount());
+		for (idx_t row = start; row < end; row++) {
+			size_sql << (row > start ? ", " : "") << Quote(listing->GetValue(0, row).ToString());
+		}
+		size_sql << "]);";
+		auto sizes = conn.Query(size_sql.str());
+		if (!sizes->HasError() && sizes->RowCount() > 0) {
+			total_bytes += sizes->GetValue(0, 0).GetValue<int64_t>();
+		}
+	}
+	return total_bytes;
+}
+
+std::string CleanupManager::GetRetentionSetting(const std::string &setting, const std::string &default_value) {
+	Value retention;
+	if (context_.TryGetCurrentSetting(setting, retention) && !retention.IsNull() && !retention.ToString().empty()) {
+		return retention.ToString();
+	}
+	return default_value;
+}
+
+std::string CleanupManager::EffectiveSnapshotRetention() {
+	auto default_retention = GetRetentionSetting("ducksync_snapshot_retention", DEFAULT_SNAPSHOT_RETENTION);
+	std::vector<std::string> retentions;
+	bool uses_default = false;
+	for (auto &cache : metadata_manager_.ListCaches()) {
+		if (cache.snapshot_retention.empty()) {
+			uses_default = true;
+		} else {
+			retentions.push_back(cache.snapshot_retention);
+		}
+	}
+	if (uses_default || retentions.empty()) {
+		retentions.push_back(default_retention);
+	}
+	return LongestRetention(retentions);
+}
+
+std::string CleanupManager::EffectiveFileRetention() {
+	auto default_retention = GetRetentionSetting("ducksync_file_retention", DEFAULT_FILE_RETENTION);
+	std::vector<std::string> retentions;
+	bool uses_default = false;
+	for (auto &cache : metadata_manager_.ListCaches()) {
+		if (cache.file_retention.empty()) {
+			uses_default = true;
+		} else {
+			retentions.push_back(cache.file_retention);
+		}
+	}
+	if (uses_default || retentions.empty()) {
+		retentions.push_back(default_retention);
+	}
+	return LongestRetention(retentions);
+}
+
+//===--------------------------------------------------------------------===//
+// MaintenanceWorker
+//===--------------------------------------------------------------------===//
+
+MaintenanceWorker::MaintenanceWorker(DatabaseInstance &db, DuckSyncMetadataManager &metadata_manager,
+                                     DuckSyncStorageManager &storage_manager, UsageStats *usage_stats)
+    : db_(db.shared_from_this()), metadata_manager_(metadata_manager), storage_manager_(storage_manager),
+      usage_stats_(usage_stats) {
+	if (usage_stats_) {
+		thread_ = std::thread(&MaintenanceWorker::Run, this);
+	}
+}
+
+MaintenanceWorker::~MaintenanceWorker() {
+	Stop();
+}
+
+void MaintenanceWorker::NotifyRefresh(idx_t every_n_refreshes) {
+	if (every_n_refreshes == 0) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (stopping_ || ++refreshes_since_cleanup_ < every_n_refreshes) {
+			return;
+		}
+		refreshes_since_cleanup_ = 0;
+		pending_ = true;
+		if (!thread_.joinable()) {
+			thread_ = std::thread(&MaintenanceWorker::Run, this);
+		}
+	}
+	cv_.notify_one();
+}
+
+bool MaintenanceWorker::Stop() {
+	bool flush;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		flush = !stopping_ && usage_stats_;
+		stopping_ = true;
+	}
+	cv_.notify_all();
+	bool joined = true;
+	if (thread_.joinable()) {
+		if (thread_.get_id() == std::this_thread::get_id()) {
+			thread_.detach();
+			joined = false;
+		} else {
+			// A cleanup already in progress runs to completion
+			thread_.join();
+		}
+	}
+	if (flush) {
+		try {
+			usage_stats_->Flush();
+		} catch (const std::exception &) {
+			// Best effort: the counts since the last flush are lost (always, once the database is closing)
+		}
+	}
+	return joined;
+}
+
+void MaintenanceWorker::Run() {
+	while (true) {
+		bool cleanup_due;
+		{
+			std::unique_lock<std::mutex> guard(lock_);
+			cv_.wait_for(guard, std::chrono::seconds(UsageStats::FLUSH_SECONDS),
+			             [&]() { return pending_ || stopping_; });
+			if (stopping_) {
+				return;
+			}
+			cleanup_due = pending_;
+			pending_ = false;
+		}
+
+		// Released at the end of the run, outside lock_: the database may close with it
+		auto db = db_.lock();
+		if (!db) {
+			return;
+		}
+		if (usage_stats_) {
+			try {
+				usage_stats_->Flush();
+			} catch (const std::exception &) {
+				// Nothing was marked flushed, so the counts go out with the next flush
+			}
+		}
+		if (!cleanup_due) {
+			continue;
+		}
+		try {
+			Connection conn(*db);
+			CleanupManager cleanup(*conn.context, metadata_manager_, storage_manager_);
+			cleanup.CleanupAll();
+		} catch (const std::exception &) {
+			// Background maintenance is best effort; the next due run tries again
+		}
+	}
+}
+
 } // namespace duckdb
@@ -5,18 +5,25 @@
 #include "metadata_manager.hpp"
 #include "storage_manager.hpp"
 #include "refresh_orchestrator.hpp"
+#include "refresh_scheduler.hpp"
+#include "ingest_channel.hpp"
 #include "query_router.hpp"
 #include "cleanup_manager.hpp"
+#include "trace_recorder.hpp"
+#include "source_emulator.hpp"
 
 #include "duckdb.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/string_util.hpp"
 #include "duckdb/function/scalar_function.hpp"
 #include "duckdb/function/table_function.hpp"
+#include "duckdb/main/config.hpp"
 #include "duckdb/parser/parsed_data/create_scalar_function_info.hpp"
 #include "duckdb/parser/parsed_data/create_table_function_info.hpp"
 #include "duckdb/catalog/catalog_entry/table_function_catalog_entry.hpp"
 #include "duckdb/parser/parser.hpp"
+#include "duckdb/parser/expression/columnref_expression.hpp"
+#include "duckdb/parser/expression/function_expression.hpp"
 #include "duckdb/parser/statement/select_statement.hpp"
 #include "duckdb/parser/tableref/basetableref.hpp"
 #include "duckdb/parser/tableref/joinref.hpp"
@@ -32,6 +39,7 @@
 #include <cctype>
 #include <unordered_set>
 #include <iostream>
+#include <map>
 
 namespace duckdb {
 
@@ -81,16 +89,33 @@ static void DuckSyncSetupStorageFunction(ClientContext &context, TableFunctionIn
 
 	// Do the actual setup work here in the execution phase
 	auto &state = GetDuckSyncState(context);
-	if (!state.storage_manager) {
-		state.storage_manager = make_uniq<DuckSyncStorageManager>(context);
+	auto state_lock = state.WriteLock();
+	// The scheduler and maintenance worker read manager state from their threads; stop them before
+	// re-pointing the managers (and replacing the local copies, which belong to the old catalog)
+	if (state.scheduler) {
+		state.scheduler->Stop();
+		state.scheduler.reset();
 	}
-	state.storage_manager->SetupStorage(bind_data.pg_connection_string, bind_data.data_path);
+	if (state.maintenance) {
+		state.maintenance->Stop();
+		state.maintenance.reset();
+	}
+	// Fresh managers, installed once set up: refreshes still running on copies of the current ones keep those
+	auto storage_manager = std::make_shared<DuckSyncStorageManager>(*context.db);
+	storage_manager->SetupStorage(context, bind_data.pg_connection_string, bind_data.data_path);
 
 	// Initialize metadata manager (uses the attached DuckLake for storage)
-	if (!state.metadata_manager) {
-		state.metadata_manager = make_uniq<DuckSyncMetadataManager>(context);
-	}
-	state.metadata_manager->Initialize(state.storage_manager->GetDuckLakeName(), bind_data.schema_name);
+	auto metadata_manager = std::make_shared<DuckSyncMetadataManager>(*context.db);
+	metadata_manager->Initialize(storage_manager->GetDuckLakeName(), bind_data.schema_name);
+	state.storage_manager = std::move(storage_manager);
+	state.metadata_manager = std::move(metadata_manager);
+	state.usage_stats = std::make_shared<UsageStats>(*state.metadata_manager, *state.storage_manager);
+	state.maintenance = std::make_shared<MaintenanceWorker>(*context.db, *state.metadata_manager,
+	                                                        *state.storage_manager, state.usage_stats.get());
+	state.memory_tier = std::make_shared<MemoryTier>(*context.db, state.usage_stats.get());
+	state.local_mirror = std::make_shared<LocalMirror>(*context.db);
+	state.storage_budget = std::make_shared<StorageBudget>(*state.metadata_manager, *state.storage_manager);
+	state.latency = std::make_shared<LatencyStats>();
 
 	state.initialized = true;
 	bind_data.done = true;
@@ -141,16 +166,33 @@ static void DuckSyncInitFunction(ClientContext &context, TableFunctionInput &dat
 
 	// Use existing DuckLake catalog
 	auto &state = GetDuckSyncState(context);
-	if (!state.storage_manager) {
-		state.storage_manager = make_uniq<DuckSyncStorageManager>(context);
+	auto state_lock = state.WriteLock();
+	// The scheduler and maintenance worker read manager state from their threads; stop them before
+	// re-pointing the managers (and replacing the local copies, which belong to the old catalog)
+	if (state.scheduler) {
+		state.scheduler->Stop();
+		state.scheduler.reset();
+	}
+	if (state.maintenance) {
+		state.maintenance->Stop();
+		state.maintenance.reset();
 	}
-	state.storage_manager->UseExistingCatalog(bind_data.catalog_name);
+	// Fresh managers, installed once set up: refreshes still running on copies of the current ones keep those
+	auto storage_manager = std::make_shared<DuckSyncStorageManager>(*context.db);
+	storage_manager->UseExistingCatalog(context, bind_data.catalog_name);
 
 	// Initialize metadata manager (creates metadata schema and tables)
-	if (!state.metadata_manager) {
-		state.metadata_manager = make_uniq<DuckSyncMetadataManager>(context);
-	}
-	state.metadata_manager->Initialize(bind_data.catalog_name, bind_data.schema_name);
+	auto metadata_manager = std::make_shared<DuckSyncMetadataManager>(*context.db);
+	metadata_manager->Initialize(bind_data.catalog_name, bind_data.schema_name);
+	state.storage_manager = std::move(storage_manager);
+	state.metadata_manager = std::move(metadata_manager);
+	state.usage_stats = std::make_shared<UsageStats>(*state.metadata_manager, *state.storage_manager);
+	state.maintenance = std::make_shared<MaintenanceWorker>(*context.db, *state.metadata_manager,
+	                                                        *state.storage_manager, state.usage_stats.get());
+	state.memory_tier = std::make_shared<MemoryTier>(*context.db, state.usage_stats.get());
+	state.local_mirror = std::make_shared<LocalMirror>(*context.db);
+	state.storage_budget = std::make_shared<StorageBudget>(*state.metadata_manager, *state.storage_manager);
+	state.latency = std::make_shared<LatencyStats>();
 
 	state.initialized = true;
 	bind_data.done = true;
@@ -213,6 +255,7 @@ static void DuckSyncAddSourceFunction(ClientContext &context, TableFunctionInput
 	}
 
 	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
 	if (!state.metadata_manager) {
 		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
 	}
@@ -242,12 +285,168 @@ struct CreateCacheBindData : public TableFunctionData {
 	bool has_ttl;
 	std::string invalidation_mode = "last_altered";
 	std::string metadata_secret_name;
+	std::string split_column;
+	int64_t parallelism = 0;
+	std::string snapshot_retention;
+	std::string file_retention;
+	std::string sort_by;
+	int64_t row_group_size = 0;
+	std::string target_file_size;
+	std::string compression;
+	std::vector<std::string> bloom_filter_columns;
+	std::vector<std::string> partition_by;
+	bool memory_tier = false;
 	bool done = false;
 
 	CreateCacheBindData() : ttl_seconds(-1), has_ttl(false) {
 	}
 };
 
+// Retention options are stored as interval text and handed to DuckLake maintenance as INTERVAL literals
+static void ValidateRetention(const std::string &parameter, const std::string &retention) {
+	Value interval;
+	string error;
+	if (!Value(retention).DefaultTryCastAs(LogicalType::INTERVAL, interval, &error)) {
+		throw InvalidInputException("%s must be an interval such as '7 days', got '%s'", parameter, retention);
+	}
+}
+
+// Size settings are parsed where they are used, on refreshes and reads; reject a bad one at SET instead
+static void ValidateSize(const std::string &setting, const Value &parameter) {
+	if (parameter.IsNull()) {
+		return;
+	}
+	try {
+		DBConfig::ParseMemoryLimit(parameter.ToString());
+	} catch (const std::exception &) {
+		throw InvalidInputException("%s must be a size such as '512MB', got '%s'", setting, parameter.ToString());
+	}
+}
+
+// SET callback: reject budgets the ingest channel could not parse at refresh time
+static void ValidateIngestMemoryBudget(ClientContext &context, SetScope scope, Value &parameter) {
+	ValidateSize("ducksync_ingest_memory_budget", parameter);
+}
+
+// SET callback: refreshes paste the target file size into the table's DuckLake options; empty keeps the default
+static void ValidateIngestTargetFileSize(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull() && !parameter.ToString().empty()) {
+		ValidateSize("ducksync_ingest_target_file_size", parameter);
+	}
+}
+
+// SET callback: every refresh parses the compaction threshold
+static void ValidateCompactionMinAvgFileSize(ClientContext &context, SetScope scope, Value &parameter) {
+	ValidateSize("ducksync_compaction_min_avg_file_size", parameter);
+}
+
+// SET callback: refreshes and routed reads parse the memory tier budget
+static void ValidateMemoryTierBudget(ClientContext &context, SetScope scope, Value &parameter) {
+	ValidateSize("ducksync_memory_tier_budget", parameter);
+}
+
+// SET callback: every refresh parses the storage budget; empty disables it
+static void ValidateStorageBudget(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull() && !parameter.ToString().empty()) {
+		ValidateSize("ducksync_storage_budget", parameter);
+	}
+}
+
+// SET callback: every routed read parses the mirror size
+static void ValidateLocalMirrorSize(ClientContext &context, SetScope scope, Value &parameter) {
+	ValidateSize("ducksync_local_mirror_size", parameter);
+}
+
+// SET callbacks for the maintenance settings, which are global so the background maintenance worker
+// and the scheduler see them
+static void ValidateSnapshotRetentionSetting(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		ValidateRetention("ducksync_snapshot_retention", parameter.ToString());
+	}
+}
+
+static void ValidateFileRetentionSetting(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull()) {
+		ValidateRetention("ducksync_file_retention", parameter.ToString());
+	}
+}
+
+static void ValidateMaintenanceInterval(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull() && parameter.GetValue<int64_t>() < 0) {
+		throw InvalidInputException("ducksync_maintenance_every_n_refreshes must be 0 (off) or a positive number");
+	}
+}
+
+// A lease that expires on creation would let every node refresh at once
+static void ValidateRefreshLeaseSeconds(ClientContext &context, SetScope scope, Value &parameter) {
+	if (!parameter.IsNull() && parameter.GetValue<int64_t>() <= 0) {
+		throw InvalidInputException("ducksync_refresh_lease_seconds must be a positive number of seconds");
+	}
+}
+
+// DuckLake partitions on a column or a year/month/day/hour transform of one
+static void ValidatePartitionKey(const std::string &key) {
+	const auto error = "partition_by entries must be a column or year/month/day/hour(column), got '" + key + "'";
+	vector<unique_ptr<ParsedExpression>> expressions;
+	try {
+		expressions = Parser::ParseExpressionList(key);
+	} catch (const std::exception &) {
+		throw InvalidInputException(error);
+	}
+	if (expressions.size() != 1) {
+		throw InvalidInputException(error);
+	}
+	auto &expression = *expressions[0];
+	if (expression.GetExpressionClass() == ExpressionClass::COLUMN_REF) {
+		return;
+	}
+	if (expression.GetExpressionClass() == ExpressionClass::FUNCTION) {
+		auto &function = expression.Cast<FunctionExpression>();
+		auto name = StringUtil::Lower(function.function_name);
+		bool is_transform = name == "year" || name == "month" || name == "day" || name == "hour";
+		if (is_transform && function.children.size() == 1 &&
+		    function.children[0]->GetExpressionClass() == ExpressionClass::COLUMN_REF) {
+			return;
+		}
+	}
+	throw InvalidInputException(error);
+}
+
+// sort_by is spliced into ORDER BY and the sizes into DuckLake options, so reject bad values up front
+static void ValidateLayoutOptions(const CreateCacheBindData &data) {
+	if (!data.sort_by.empty()) {
+		try {
+			Parser::ParseOrderList(data.sort_by);
+		} catch (const std::exception &) {
+			throw InvalidInputException("sort_by must be an ORDER BY list such as 'customer_id, event_date', got '%s'",
+			                            data.sort_by);
+		}
+	}
+	if (data.row_group_size < 0) {
+		throw InvalidInputException("row_group_size must be 0 (default) or a positive number of rows");
+	}
+	if (!data.target_file_size.empty()) {
+		try {
+			DBConfig::ParseMemoryLimit(data.target_file_size);
+		} catch (const std::exception &) {
+			throw InvalidInputException("target_file_size must be a size such as '512MB', got '%s'",
+			                            data.target_file_size);
+		}
+	}
+	for (auto &key : data.partition_by) {
+		ValidatePartitionKey(key);
+	}
+	// ducklake_add_data_files registers unpartitioned files only
+	if (!data.partition_by.empty() && !data.bloom_filter_columns.empty()) {
+		throw InvalidInputException("partition_by cannot be combined with bloom_filter_columns");
+	}
+	static const std::vector<std::string> codecs = {"uncompressed", "snappy", "gzip",   "zstd",
+	                                                "brotli",       "lz4",    "lz4_raw"};
+	if (!data.compression.empty() && std::find(codecs.begin(), codecs.end(), data.compression) == codecs.end()) {
+		throw InvalidInputException("compression must be one of: %s", StringUtil::Join(codecs, ", "));
+	}
+}
+
 static unique_ptr<FunctionData> DuckSyncCreateCacheBind(ClientContext &context, TableFunctionBindInput &input,
                                                         vector<LogicalType> &return_types, vector<string> &names) {
 	auto result = make_uniq<CreateCacheBindData>();
@@ -280,8 +479,40 @@ static unique_ptr<FunctionData> DuckSyncCreateCacheBind(ClientContext &context,
 			result->invalidation_mode = kv.second.GetValue<string>();
 		} else if (kv.first == "metadata_secret") {
 			result->metadata_secret_name = kv.second.GetValue<string>();
+		} else if (kv.first == "split_column") {
+			result->split_column = kv.second.GetValue<string>();
+		} else if (kv.first == "parallelism") {
+			result->parallelism = kv.second.GetValue<int64_t>();
+		} else if (kv.first == "snapshot_retention") {
+			result->snapshot_retention = kv.second.GetValue<string>();
+			ValidateRetention(kv.first, result->snapshot_retention);
+		} else if (kv.first == "file_retention") {
+			result->file_retention = kv.second.GetValue<string>();
+			ValidateRetention(kv.first, result->file_retention);
+		} else if (kv.first == "sort_by") {
+			result->sort_by = kv.second.GetValue<string>();
+		} else if (kv.first == "row_group_size") {
+			result->row_group_size = kv.second.GetValue<int64_t>();
+		} else if (kv.first == "target_file_size") {
+			result->target_file_size = kv.second.GetValue<string>();
+		} else if (kv.first == "compression") {
+			result->compression = StringUtil::Lower(kv.second.GetValue<string>());
+		} else if (kv.first == "bloom_filter_columns") {
+			for (auto &column : ListValue::GetChildren(kv.second)) {
+				if (column.IsNull() || column.ToString().empty()) {
+					throw InvalidInputException("bloom_filter_columns must list column names");
+				}
+				result->bloom_filter_columns.push_back(column.ToString());
+			}
+		} else if (kv.first == "partition_by") {
+			for (auto &key : ListValue::GetChildren(kv.second)) {
+				result->partition_by.push_back(key.IsNull() ? "" : key.ToString());
+			}
+		} else if (kv.first == "memory_tier") {
+			result->memory_tier = kv.second.GetValue<bool>();
 		}
 	}
+	ValidateLayoutOptions(*result);
 
 	if (result->invalidation_mode != "last_altered" && result->invalidation_mode != "two_stage" &&
 	    result->invalidation_mode != "ttl_only" && result->invalidation_mode != "manual") {
@@ -291,6 +522,12 @@ static unique_ptr<FunctionData> DuckSyncCreateCacheBind(ClientContext &context,
 		throw InvalidInputException(
 		    "ducksync_create_cache with invalidation_mode='two_stage' requires metadata_secret");
 	}
+	if (result->parallelism < 0) {
+		throw InvalidInputException("parallelism must be 0 (automatic) or a positive number of streams");
+	}
+	if (result->parallelism > 1 && result->split_column.empty()) {
+		throw InvalidInputException("parallelism greater than 1 requires split_column");
+	}
 
 	names.emplace_back("status");
 	return_types.emplace_back(LogicalType::VARCHAR);
@@ -307,6 +544,7 @@ static void DuckSyncCreateCacheFunction(ClientContext &context, TableFunctionInp
 	}
 
 	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
 	if (!state.metadata_manager) {
 		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
 	}
@@ -326,9 +564,19 @@ static void DuckSyncCreateCacheFunction(ClientContext &context, TableFunctionInp
 	cache.has_ttl = bind_data.has_ttl;
 	cache.invalidation_mode = bind_data.invalidation_mode;
 	cache.metadata_secret_name = bind_data.metadata_secret_name;
+	cache.split_column = bind_data.split_column;
+	cache.parallelism = bind_data.parallelism;
+	cache.snapshot_retention = bind_data.snapshot_retention;
+	cache.file_retention = bind_data.file_retention;
+	cache.sort_by = bind_data.sort_by;
+	cache.row_group_size = bind_data.row_group_size;
+	cache.target_file_size = bind_data.target_file_size;
+	cache.compression = bind_data.compression;
+	cache.bloom_filter_columns = bind_data.bloom_filter_columns;
+	cache.partition_by = bind_data.partition_by;
+	cache.memory_tier = bind_data.memory_tier;
 
 	state.metadata_manager->CreateCache(cache);
-	state.metadata_manager->InitializeState(bind_data.cache_name);
 	bind_data.done = true;
 
 	output.SetCardinality(1);
@@ -366,48 +614,41 @@ static unique_ptr<FunctionData> DuckSyncRefreshBind(ClientContext &context, Tabl
 	names.emplace_back("message");
 	names.emplace_back("rows_refreshed");
 	names.emplace_back("duration_ms");
+	names.emplace_back("metadata_commits");
 	return_types.emplace_back(LogicalType::VARCHAR);
 	return_types.emplace_back(LogicalType::VARCHAR);
 	return_types.emplace_back(LogicalType::BIGINT);
 	return_types.emplace_back(LogicalType::DOUBLE);
+	return_types.emplace_back(LogicalType::BIGINT);
 
 	return std::move(result);
 }
 
 static void DuckSyncRefreshFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
 	auto &bind_data = data_p.bind_data->CastNoConst<RefreshBindData>();
-	auto &state = GetDuckSyncState(context);
-
 	if (bind_data.done) {
 		output.SetCardinality(0);
 		return;
 	}
 
+	// The refresh can take minutes: it runs on copies of the managers, without holding the state
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
 	if (!state.metadata_manager || !state.storage_manager) {
 		throw InvalidInputException("DuckSync not initialized");
 	}
+	auto managers = state.Managers();
+	state_lock.unlock();
 
-	RefreshOrchestrator orchestrator(context, *state.metadata_manager, *state.storage_manager);
+	RefreshOrchestrator orchestrator(context, *managers.metadata_manager, *managers.storage_manager,
+	                                 managers.maintenance.get(), managers.memory_tier.get(),
+	                                 managers.local_mirror.get(), managers.storage_budget.get());
 	auto status = orchestrator.Refresh(bind_data.cache_name, bind_data.force);
 
 	bind_data.done = true;
 	output.SetCardinality(1);
 
-	// Convert result to string
-	std::string result_str;
-	switch (status.result) {
-	case RefreshResult::SKIPPED:
-		result_str = "SKIPPED";
-		break;
-	case RefreshResult::REFRESHED:
-		result_str = "REFRESHED";
-		break;
-	case RefreshResult::ERROR:
-		result_str = "ERROR";
-		break;
-	}
-
-	output.SetValue(0, 0, Value(result_str));
+	output.SetValue(0, 0, Value(RefreshResultToString(status.result)));
 	output.SetValue(1, 0, Value(status.message));
 
 	if (status.has_rows) {
@@ -421,6 +662,175 @@ static void DuckSyncRefreshFunction(ClientContext &context, TableFunctionInput &
 	} else {
 		output.SetValue(3, 0, Value());
 	}
+
+	output.SetValue(4, 0, Value::BIGINT(status.metrics.metadata_commits));
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_scheduler_start([workers, probe_interval, min_interval, jitter])
+// Opt-in background refresh scheduler driven by cache expiry deadlines
+//===--------------------------------------------------------------------===//
+struct SchedulerStartBindData : public TableFunctionData {
+	RefreshSchedulerConfig config;
+	bool done = false;
+};
+
+static unique_ptr<FunctionData> DuckSyncSchedulerStartBind(ClientContext &context, TableFunctionBindInput &input,
+                                                           vector<LogicalType> &return_types, vector<string> &names) {
+	auto result = make_uniq<SchedulerStartBindData>();
+
+	for (auto &kv : input.named_parameters) {
+		if (kv.first == "workers") {
+			auto workers = kv.second.GetValue<int64_t>();
+			if (workers < 1) {
+				throw InvalidInputException("ducksync_scheduler_start: workers must be at least 1");
+			}
+			result->config.worker_threads = static_cast<idx_t>(workers);
+		} else if (kv.first == "probe_interval") {
+			result->config.probe_interval_seconds = kv.second.GetValue<int64_t>();
+			if (result->config.probe_interval_seconds < 1) {
+				throw InvalidInputException("ducksync_scheduler_start: probe_interval must be at least 1 second");
+			}
+		} else if (kv.first == "min_interval") {
+			result->config.min_refresh_interval_seconds = kv.second.GetValue<int64_t>();
+			if (result->config.min_refresh_interval_seconds < 0) {
+				throw InvalidInputException("ducksync_scheduler_start: min_interval must not be negative");
+			}
+		} else if (kv.first == "jitter") {
+			result->config.jitter = kv.second.GetValue<double>();
+			if (result->config.jitter < 0 || result->config.jitter > 1) {
+				throw InvalidInputException("ducksync_scheduler_start: jitter must be between 0 and 1");
+			}
+		}
+	}
+
+	names.emplace_back("status");
+	return_types.emplace_back(LogicalType::VARCHAR);
+
+	return std::move(result);
+}
+
+static void DuckSyncSchedulerStartFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &bind_data = data_p.bind_data->CastNoConst<SchedulerStartBindData>();
+
+	if (bind_data.done) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.WriteLock();
+	if (!state.metadata_manager || !state.storage_manager) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	std::string status;
+	if (state.scheduler && state.scheduler->IsRunning()) {
+		status = "DuckSync scheduler is already running";
+	} else {
+		state.scheduler = make_uniq<RefreshScheduler>(*context.db, *state.metadata_manager, *state.storage_manager,
+		                                              bind_data.config, state.maintenance.get(),
+		                                              state.memory_tier.get(), state.local_mirror.get(),
+		                                              state.storage_budget.get());
+		state.scheduler->Start();
+		status = "DuckSync scheduler started with " + std::to_string(bind_data.config.worker_threads) + " worker(s)";
+	}
+	bind_data.done = true;
+
+	output.SetCardinality(1);
+	output.SetValue(0, 0, Value(status));
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_scheduler_stop()
+//===--------------------------------------------------------------------===//
+struct SchedulerStopBindData : public TableFunctionData {
+	bool done = false;
+};
+
+static unique_ptr<FunctionData> DuckSyncSchedulerStopBind(ClientContext &context, TableFunctionBindInput &input,
+                                                          vector<LogicalType> &return_types, vector<string> &names) {
+	names.emplace_back("status");
+	return_types.emplace_back(LogicalType::VARCHAR);
+	return make_uniq<SchedulerStopBindData>();
+}
+
+static void DuckSyncSchedulerStopFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &bind_data = data_p.bind_data->CastNoConst<SchedulerStopBindData>();
+
+	if (bind_data.done) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.WriteLock();
+	if (!state.metadata_manager || !state.storage_manager) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	std::string status = "DuckSync scheduler is not running";
+	if (state.scheduler && state.scheduler->IsRunning()) {
+		state.scheduler->Stop();
+		status = "DuckSync scheduler stopped";
+	}
+	state.scheduler.reset();
+	bind_data.done = true;
+
+	output.SetCardinality(1);
+	output.SetValue(0, 0, Value(status));
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_scheduler_status()
+// One row per scheduled cache: running first, then queued by deadline
+//===--------------------------------------------------------------------===//
+struct SchedulerStatusGlobalState : public GlobalTableFunctionState {
+	std::vector<ScheduledCacheInfo> rows;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> DuckSyncSchedulerStatusBind(ClientContext &context, TableFunctionBindInput &input,
+                                                            vector<LogicalType> &return_types, vector<string> &names) {
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (!state.metadata_manager || !state.storage_manager) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	names = {"cache_name", "status", "next_run_in_s", "runs", "last_result", "last_message", "last_duration_ms"};
+	return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::DOUBLE, LogicalType::BIGINT,
+	                LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::DOUBLE};
+	return make_uniq<TableFunctionData>();
+}
+
+static unique_ptr<GlobalTableFunctionState> DuckSyncSchedulerStatusInitGlobal(ClientContext &context,
+                                                                              TableFunctionInitInput &input) {
+	auto result = make_uniq<SchedulerStatusGlobalState>();
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (state.scheduler && state.scheduler->IsRunning()) {
+		result->rows = state.scheduler->GetStatus();
+	}
+	return std::move(result);
+}
+
+static void DuckSyncSchedulerStatusFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &gstate = data_p.global_state->Cast<SchedulerStatusGlobalState>();
+
+	idx_t count = 0;
+	while (gstate.offset < gstate.rows.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &row = gstate.rows[gstate.offset++];
+		output.SetValue(0, count, Value(row.cache_name));
+		output.SetValue(1, count, Value(row.running ? "RUNNING" : "QUEUED"));
+		output.SetValue(2, count, row.running ? Value() : Value::DOUBLE(row.next_run_seconds));
+		output.SetValue(3, count, Value::BIGINT(row.runs));
+		output.SetValue(4, count, row.has_last_run ? Value(row.last_result) : Value());
+		output.SetValue(5, count, row.has_last_run ? Value(row.last_message) : Value());
+		output.SetValue(6, count, row.has_last_run ? Value::DOUBLE(row.last_duration_ms) : Value());
+		count++;
+	}
+	output.SetCardinality(count);
 }
 
 //===--------------------------------------------------------------------===//
@@ -679,6 +1089,7 @@ static unique_ptr<FunctionData> DuckSyncServeBind(ClientContext &context, TableF
 	}
 
 	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
 	if (!state.initialized || !state.storage_manager || !state.metadata_manager) {
 		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
 	}
@@ -755,6 +1166,7 @@ static unique_ptr<FunctionData> DuckSyncStopBind(ClientContext &context, TableFu
 	}
 
 	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
 	if (!state.initialized || !state.storage_manager || !state.metadata_manager) {
 		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
 	}
@@ -801,10 +1213,132 @@ struct DuckSyncQueryBindData : public TableFunctionData {
 	std::string source_name;
 	std::string execution_query; // The actual query to run (rewritten or passthrough)
 	bool use_cache = false;      // Whether we're using cache or passthrough
+	// (cache_name, source_name) of the caches a cached query reads, for the usage counters
+	std::vector<std::pair<std::string, std::string>> served_caches;
+	TraceLink trace; // the execution span continues the bind's trace
 	vector<LogicalType> result_types;
 	vector<string> result_names;
 };
 
+// A table of a ducksync_query call and the cache that holds it, if any
+struct ResolvedTable {
+	std::string table;
+	bool cached = false;
+	CacheDefinition cache;
+	bool has_state = false;
+	CacheState state;
+	std::string freshness; // fresh, expired, never_refreshed or evicted; empty when not cached
+};
+
+// How the tables of a query resolve to caches. ducksync_query refreshes and routes from this;
+// ducksync_explain only reports it.
+struct QueryResolution {
+	std::vector<ResolvedTable> tables;
+	// Map: UPPER(original_table) -> TableRewrite for AST rewrite
+	std::unordered_map<std::string, TableRewrite> rewrites;
+	std::unordered_map<std::string, CacheDefinition> routed_caches;
+	std::vector<CacheDefinition> caches_to_refresh;
+	std::vector<CacheDefinition> caches_to_rehydrate;
+	bool all_cached = false;
+};
+
+// Reads cache definitions and state only. With stop_at_miss the first uncached table ends the
+// lookup, since the query is passed through anyway.
+static QueryResolution ResolveQueryTables(ClientContext &context, DuckSyncState &state,
+                                          const std::vector<std::string> &tables, bool stop_at_miss) {
+	QueryResolution resolution;
+	resolution.all_cached = !tables.empty();
+	for (auto &table : tables) {
+		ResolvedTable resolved;
+		resolved.table = table;
+		auto &cache = resolved.cache;
+
+		// First check if it's a cache name directly, then if it's a monitored table
+		resolved.cached = state.metadata_manager->GetCache(table, cache) ||
+		                  state.metadata_manager->GetCacheByMonitorTable(table, cache);
+		if (!resolved.cached) {
+			resolution.all_cached = false;
+			resolution.tables.push_back(std::move(resolved));
+			if (stop_at_miss) {
+				break;
+			}
+			continue;
+		}
+
+		// Check TTL - if expired, mark for refresh
+		auto &cache_state = resolved.state;
+		resolved.has_state = state.metadata_manager->GetState(cache.cache_name, cache_state);
+		resolved.freshness = "fresh";
+		if (!resolved.has_state) {
+			// Never refreshed
+			resolved.freshness = "never_refreshed";
+			resolution.caches_to_refresh.push_back(cache);
+		} else if (cache_state.IsEvicted()) {
+			// Dropped to fit the storage budget; the smart check could skip it as fresh
+			resolved.freshness = "evicted";
+			resolution.caches_to_rehydrate.push_back(cache);
+		} else if (cache.has_ttl && cache_state.HasExpiresAt()) {
+			// Check if TTL expired by comparing timestamps
+			// Get current timestamp from DuckDB and compare with expires_at
+			auto conn = Connection(*context.db);
+			auto now_result = conn.Query("SELECT CURRENT_TIMESTAMP::VARCHAR;");
+			if (!now_result->HasError() && now_result->RowCount() > 0) {
+				auto now_str = now_result->GetValue(0, 0).ToString();
+				// Simple string comparison works for ISO-format timestamps
+				if (cache_state.expires_at < now_str) {
+					resolved.freshness = "expired";
+					resolution.caches_to_refresh.push_back(cache);
+				}
+			}
+		}
+
+		// Store rewrite info for AST modification
+		// DuckLake tables are: {catalog}.{source_name}.{cache_name}
+		TableRewrite rewrite;
+		rewrite.catalog = state.storage_manager->GetDuckLakeName();
+		rewrite.schema = cache.source_name;
+		rewrite.table_name = cache.cache_name;
+		resolution.rewrites[ToUpper(table)] = rewrite;
+		resolution.routed_caches[cache.cache_name] = cache;
+		resolution.tables.push_back(std::move(resolved));
+	}
+	return resolution;
+}
+
+// Point a cache read at the memory tier or local mirror copy of its latest refresh when there is one.
+// Returns where the read is served from: memory_tier, local_mirror or ducklake. With record_read (the
+// caller has counted the read) a mirror miss queues a background copy of the files; without it nothing
+// is changed.
+static std::string RouteToLocalCopy(ClientContext &context, DuckSyncState &state, const CacheDefinition &cache,
+                                    const CacheState &cache_state, const LocalMirrorPolicy &mirror_policy,
+                                    bool record_read, TableRewrite &rewrite) {
+	HotTableRef local;
+	std::string tier = "ducklake";
+	if (state.memory_tier && state.memory_tier->Lookup(cache.cache_name, cache_state.last_refresh, local)) {
+		tier = "memory_tier";
+	}
+	if (tier == "ducklake" && state.local_mirror) {
+		bool mirrored = record_read
+		                    ? state.local_mirror->Resolve(context, cache, state.storage_manager->GetDuckLakeName(),
+		                                                  cache_state.last_refresh, mirror_policy, local)
+		                    : state.local_mirror->Peek(cache.cache_name, cache_state.last_refresh, local);
+		if (mirrored) {
+			tier = "local_mirror";
+		}
+	}
+	if (tier != "ducklake") {
+		rewrite.catalog = local.catalog;
+		rewrite.schema = local.schema;
+		rewrite.table_name = local.table;
+	}
+	return tier;
+}
+
+static std::string PassthroughQuerySQL(ClientContext &context, const std::string &sql, const SourceDefinition &source) {
+	return "SELECT * FROM " + GetSourceFunction(context) + "('" + EscapeSqlStringLiteral(sql) + "', '" +
+	       EscapeSqlStringLiteral(source.secret_name) + "')";
+}
+
 static unique_ptr<FunctionData> DuckSyncQueryBind(ClientContext &context, TableFunctionBindInput &input,
                                                   vector<LogicalType> &return_types, vector<string> &names) {
 	auto result = make_uniq<DuckSyncQueryBindData>();
@@ -817,9 +1351,15 @@ static unique_ptr<FunctionData> DuckSyncQueryBind(ClientContext &context, TableF
 	result->source_name = input.inputs[1].GetValue<string>();
 
 	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
 	if (!state.metadata_manager || !state.storage_manager) {
 		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
 	}
+	// Held by the timers, which outlive the state lock while expired caches refresh
+	auto latency = state.latency;
+	ScopedLatency bind_timer(latency.get(), LatencyStage::QUERY_BIND);
+	TraceScope trace(context, "ducksync_query");
+	trace.Set("source", result->source_name);
 
 	// Get the source configuration
 	SourceDefinition source;
@@ -828,84 +1368,92 @@ static unique_ptr<FunctionData> DuckSyncQueryBind(ClientContext &context, TableF
 	}
 
 	// Extract table references using DuckDB parser
+	ScopedLatency parse_timer(latency.get(), LatencyStage::QUERY_PARSE);
+	TraceScope parse_span("parse");
 	auto tables = ExtractTableReferences(result->sql_query);
+	parse_span.Stop();
+	parse_timer.Stop();
+	if (trace.Active()) {
+		trace.Set("tables", StringUtil::Join(tables, ","));
+	}
 
 	// Check cache coverage and TTL validity
-	// Map: UPPER(original_table) -> TableRewrite for AST rewrite
-	std::unordered_map<std::string, TableRewrite> rewrites;
-	std::vector<CacheDefinition> caches_to_refresh;
-	bool all_cached = !tables.empty();
-
-	for (auto &table : tables) {
-		CacheDefinition cache;
-		bool found = false;
-
-		// First check if it's a cache name directly
-		if (state.metadata_manager->GetCache(table, cache)) {
-			found = true;
-		}
-		// Then check if it's a monitored table
-		else if (state.metadata_manager->GetCacheByMonitorTable(table, cache)) {
-			found = true;
+	ScopedLatency lookup_timer(latency.get(), LatencyStage::QUERY_LOOKUP);
+	TraceScope lookup_span("lookup");
+	auto resolution = ResolveQueryTables(context, state, tables, true);
+	auto &rewrites = resolution.rewrites;
+	auto &routed_caches = resolution.routed_caches;
+	auto &caches_to_refresh = resolution.caches_to_refresh;
+	auto &caches_to_rehydrate = resolution.caches_to_rehydrate;
+	auto all_cached = resolution.all_cached;
+
+	lookup_span.Stop();
+	lookup_timer.Stop();
+	if (trace.Active()) {
+		std::vector<std::string> matched;
+		for (auto &entry : routed_caches) {
+			matched.push_back(entry.first);
 		}
-
-		if (found) {
-			// Check TTL - if expired, mark for refresh
-			CacheState cache_state;
-			bool needs_refresh = false;
-
-			if (!state.metadata_manager->GetState(cache.cache_name, cache_state)) {
-				// Never refreshed
-				needs_refresh = true;
-			} else if (cache.has_ttl && cache_state.HasExpiresAt()) {
-				// Check if TTL expired by comparing timestamps
-				// Get current timestamp from DuckDB and compare with expires_at
-				auto conn = Connection(*context.db);
-				auto now_result = conn.Query("SELECT CURRENT_TIMESTAMP::VARCHAR;");
-				if (!now_result->HasError() && now_result->RowCount() > 0) {
-					auto now_str = now_result->GetValue(0, 0).ToString();
-					// Simple string comparison works for ISO-format timestamps
-					needs_refresh = (cache_state.expires_at < now_str);
-				}
+		std::sort(matched.begin(), matched.end());
+		trace.Set("caches", StringUtil::Join(matched, ","));
+		trace.Set("refreshed", static_cast<int64_t>(caches_to_refresh.size()));
+		trace.Set("rehydrated", static_cast<int64_t>(caches_to_rehydrate.size()));
+	}
+
+	// Refresh any expired caches before executing query. The refreshes run on copies of the managers,
+	// without holding the state, which is taken again for routing.
+	if (!caches_to_refresh.empty() || !caches_to_rehydrate.empty()) {
+		ScopedLatency refresh_timer(latency.get(), LatencyStage::QUERY_REFRESH_WAIT);
+		{
+			auto managers = state.Managers();
+			state_lock.unlock();
+			RefreshOrchestrator orchestrator(context, *managers.metadata_manager, *managers.storage_manager,
+			                                 managers.maintenance.get(), managers.memory_tier.get(),
+			                                 managers.local_mirror.get(), managers.storage_budget.get());
+			for (auto &cache : caches_to_refresh) {
+				orchestrator.Refresh(cache.cache_name, false, RefreshTrigger::QUERY); // smart refresh
 			}
-
-			if (needs_refresh) {
-				caches_to_refresh.push_back(cache);
+			for (auto &cache : caches_to_rehydrate) {
+				orchestrator.Refresh(cache.cache_name, true, RefreshTrigger::REHYDRATE);
 			}
-
-			// Store rewrite info for AST modification
-			// DuckLake tables are: {catalog}.{source_name}.{cache_name}
-			TableRewrite rewrite;
-			rewrite.catalog = state.storage_manager->GetDuckLakeName();
-			rewrite.schema = cache.source_name;
-			rewrite.table_name = cache.cache_name;
-			rewrites[ToUpper(table)] = rewrite;
-		} else {
-			all_cached = false;
-			break;
-		}
-	}
-
-	// Refresh any expired caches before executing query
-	if (!caches_to_refresh.empty()) {
-		RefreshOrchestrator orchestrator(context, *state.metadata_manager, *state.storage_manager);
-		for (auto &cache : caches_to_refresh) {
-			orchestrator.Refresh(cache.cache_name, false); // smart refresh
 		}
+		state_lock = state.ReadLock();
 	}
 
 	// Determine execution strategy
+	ScopedLatency prepare_timer(latency.get(), LatencyStage::QUERY_PREPARE);
+	TraceScope prepare_span("prepare");
+	std::vector<std::string> served_from; // cache=tier, for the trace
 	if (all_cached && !rewrites.empty()) {
 		// Rewrite query using AST modification (safe - only modifies table references)
 		result->use_cache = true;
+		// Caches with a copy of their latest refresh in the memory tier or the local mirror are read from there
+		auto mirror_policy = GetLocalMirrorPolicy(context);
+		for (auto &entry : rewrites) {
+			auto &rewrite = entry.second;
+			auto &cache = routed_caches[rewrite.table_name];
+			CacheState cache_state;
+			if (!state.metadata_manager->GetState(cache.cache_name, cache_state)) {
+				continue;
+			}
+			if (state.usage_stats) {
+				state.usage_stats->RecordQueryHit(cache.cache_name, cache.source_name);
+			}
+			result->served_caches.emplace_back(cache.cache_name, cache.source_name);
+			auto tier = RouteToLocalCopy(context, state, cache, cache_state, mirror_policy, true, rewrite);
+			if (trace.Active()) {
+				served_from.push_back(cache.cache_name + "=" + tier);
+			}
+		}
 		result->execution_query = RewriteQueryWithAST(result->sql_query, rewrites);
 	} else {
 		// Pass through to Snowflake
 		result->use_cache = false;
-		result->execution_query = "SELECT * FROM snowflake_query('" + EscapeSqlStringLiteral(result->sql_query) +
-		                          "', '" + EscapeSqlStringLiteral(source.secret_name) + "')";
+		result->execution_query = PassthroughQuerySQL(context, result->sql_query, source);
+		if (state.usage_stats) {
+			state.usage_stats->RecordPassthrough(result->source_name);
+		}
 	}
-
 	// Use Prepare() to discover schema without executing the query
 	// This avoids double-execution (bind + init_global) which would
 	// hit Snowflake twice for passthrough queries
@@ -925,14 +1473,46 @@ static unique_ptr<FunctionData> DuckSyncQueryBind(ClientContext &context, TableF
 		result->result_types.push_back(prep_types[i]);
 		result->result_names.push_back(ducksync::ToStringName(prep_names[i]));
 	}
+	prepare_span.Stop();
+	prepare_timer.Stop();
 
+	trace.Set("route", result->use_cache ? "cache" : "passthrough");
+	if (trace.Active() && !served_from.empty()) {
+		std::sort(served_from.begin(), served_from.end());
+		trace.Set("served_from", StringUtil::Join(served_from, ","));
+	}
+	result->trace = trace.Link();
 	return std::move(result);
 }
 
 static unique_ptr<GlobalTableFunctionState> DuckSyncQueryInitGlobal(ClientContext &context,
                                                                     TableFunctionInitInput &input) {
 	auto &bind_data = input.bind_data->Cast<DuckSyncQueryBindData>();
-	return InitStreamingQueryGlobalState(context, bind_data.execution_query);
+	// The query runs without holding the state; the timer holds the latency stats it records into
+	std::shared_ptr<LatencyStats> latency;
+	std::shared_ptr<UsageStats> usage_stats;
+	{
+		auto &state = GetDuckSyncState(context);
+		auto state_lock = state.ReadLock();
+		latency = state.latency;
+		usage_stats = state.usage_stats;
+	}
+	// The result is materialized here, so this covers the whole execution
+	ScopedLatency execution_timer(latency.get(), bind_data.use_cache ? LatencyStage::CACHE_HIT_EXECUTION
+	                                                                 : LatencyStage::PASSTHROUGH_EXECUTION);
+	TraceScope trace(bind_data.trace, "execute");
+	auto global_state = InitStreamingQueryGlobalState(context, bind_data.execution_query);
+	auto &result = global_state->Cast<DuckSyncStreamingQueryGlobalState>().result;
+	auto rows = static_cast<int64_t>(result->Cast<MaterializedQueryResult>().RowCount());
+	trace.Set("rows", rows);
+	// Rows of a join cannot be attributed to one side, so every cache the query read is credited with
+	// all of them, once per call rather than per output chunk
+	if (usage_stats && rows > 0) {
+		for (auto &cache : bind_data.served_caches) {
+			usage_stats->RecordRowsServed(cache.first, cache.second, rows);
+		}
+	}
+	return global_state;
 }
 
 static void DuckSyncQueryFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
@@ -940,45 +1520,863 @@ static void DuckSyncQueryFunction(ClientContext &context, TableFunctionInput &da
 }
 
 //===--------------------------------------------------------------------===//
-// Extension Load - Using ExtensionLoader API
+// ducksync_emulated_query(sql, secret_name)
+// Offline snowflake_query() stand-in answered by attached DuckDB databases; see SourceEmulator.
+// Used as the source function with SET ducksync_source_function = 'ducksync_emulated_query'.
 //===--------------------------------------------------------------------===//
-static void LoadInternal(ExtensionLoader &loader) {
-	// Register ducksync_init (use existing DuckLake catalog)
-	// 1-arg: ducksync_init(catalog_name) - backward compatible, schema defaults to "ducksync"
-	TableFunction init_func_1("ducksync_init", {LogicalType::VARCHAR}, DuckSyncInitFunction, DuckSyncInitBind);
-	loader.RegisterFunction(init_func_1);
-	// 2-arg: ducksync_init(catalog_name, schema_name) - custom metadata schema (e.g. for GizmoSQL)
-	TableFunction init_func_2("ducksync_init", {LogicalType::VARCHAR, LogicalType::VARCHAR}, DuckSyncInitFunction,
-	                          DuckSyncInitBind);
-	loader.RegisterFunction(init_func_2);
-
-	// Register ducksync_setup_storage (full setup - attaches DuckLake)
-	// 2-arg: ducksync_setup_storage(pg_conn, data_path) - backward compatible, schema defaults to "ducksync"
-	TableFunction setup_storage_func_2("ducksync_setup_storage", {LogicalType::VARCHAR, LogicalType::VARCHAR},
-	                                   DuckSyncSetupStorageFunction, DuckSyncSetupStorageBind);
-	loader.RegisterFunction(setup_storage_func_2);
-	// 3-arg: ducksync_setup_storage(pg_conn, data_path, schema_name) - custom metadata schema
-	TableFunction setup_storage_func_3("ducksync_setup_storage",
-	                                   {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR},
-	                                   DuckSyncSetupStorageFunction, DuckSyncSetupStorageBind);
-	loader.RegisterFunction(setup_storage_func_3);
-
-	// Register ducksync_add_source
-	TableFunction add_source_func("ducksync_add_source",
-	                              {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR},
-	                              DuckSyncAddSourceFunction, DuckSyncAddSourceBind);
-	add_source_func.named_parameters["passthrough_enabled"] = LogicalType::BOOLEAN;
-	loader.RegisterFunction(add_source_func);
+struct EmulatedQueryBindData : public TableFunctionData {
+	std::string execution_query;
+};
 
-	// Register ducksync_create_cache
-	TableFunction create_cache_func(
-	    "ducksync_create_cache",
-	    {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::LIST(LogicalType::VARCHAR)},
-	    DuckSyncCreateCacheFunction, DuckSyncCreateCacheBind);
-	create_cache_func.varargs = LogicalType::BIGINT;
-	create_cache_func.named_parameters["invalidation_mode"] = LogicalType::VARCHAR;
-	create_cache_func.named_parameters["metadata_secret"] = LogicalType::VARCHAR;
-	loader.RegisterFunction(create_cache_func);
+static unique_ptr<FunctionData> DuckSyncEmulatedQueryBind(ClientContext &context, TableFunctionBindInput &input,
+                                                          vector<LogicalType> &return_types, vector<string> &names) {
+	if (input.inputs.size() < 2) {
+		throw InvalidInputException("ducksync_emulated_query requires 2 arguments: sql, secret_name");
+	}
+	auto result = make_uniq<EmulatedQueryBindData>();
+	// The secret is accepted for snowflake_query() compatibility and ignored
+	result->execution_query = SourceEmulator::Translate(context, input.inputs[0].GetValue<string>());
+
+	auto conn = Connection(*context.db);
+	auto prepared = conn.Prepare(result->execution_query);
+	if (prepared->HasError()) {
+		throw IOException("Emulated source query failed: " + prepared->GetError());
+	}
+	auto &prep_types = prepared->GetTypes();
+	auto &prep_names = prepared->GetNames();
+	for (idx_t i = 0; i < prep_types.size(); i++) {
+		return_types.push_back(prep_types[i]);
+		names.push_back(ducksync::ToStringName(prep_names[i]));
+	}
+	return std::move(result);
+}
+
+static unique_ptr<GlobalTableFunctionState> DuckSyncEmulatedQueryInitGlobal(ClientContext &context,
+                                                                            TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<EmulatedQueryBindData>();
+	return InitStreamingQueryGlobalState(context, bind_data.execution_query);
+}
+
+static void DuckSyncEmulatedQueryFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	StreamQueryResultToOutput(*data_p.global_state, output);
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_explain(sql_query, source_name)
+// How ducksync_query would route a query, without refreshing caches or contacting the warehouse
+//===--------------------------------------------------------------------===//
+struct ExplainBindData : public TableFunctionData {
+	std::string sql_query;
+	SourceDefinition source;
+};
+
+struct ExplainRow {
+	Value table_name; // NULL when the query references no tables
+	Value cache_name;
+	Value freshness;
+	std::string read_from; // memory_tier, local_mirror, ducklake or warehouse
+	Value local_bytes;
+	Value remote_bytes;
+};
+
+struct ExplainGlobalState : public GlobalTableFunctionState {
+	std::vector<ExplainRow> rows;
+	std::string route;
+	Value reason;
+	std::string execution_sql;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> DuckSyncExplainBind(ClientContext &context, TableFunctionBindInput &input,
+                                                    vector<LogicalType> &return_types, vector<string> &names) {
+	if (input.inputs.size() < 2) {
+		throw InvalidInputException("ducksync_explain requires 2 arguments: sql_query, source_name");
+	}
+
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (!state.metadata_manager || !state.storage_manager) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	auto result = make_uniq<ExplainBindData>();
+	result->sql_query = input.inputs[0].GetValue<string>();
+	auto source_name = input.inputs[1].GetValue<string>();
+	if (!state.metadata_manager->GetSource(source_name, result->source)) {
+		throw InvalidInputException("Source '" + source_name + "' not found");
+	}
+
+	names = {"table_name", "cache_name",    "freshness",   "read_from",   "route",
+	         "reason",     "execution_sql", "local_bytes", "remote_bytes"};
+	return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR,
+	                LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR,
+	                LogicalType::VARCHAR, LogicalType::BIGINT,  LogicalType::BIGINT};
+	return std::move(result);
+}
+
+// Warehouse bytes of the table at the cache's last two-stage check; NULL when not recorded
+static Value LastKnownSourceBytes(DuckSyncMetadataManager &metadata_manager, const ResolvedTable &resolved) {
+	if (!resolved.has_state) {
+		return Value();
+	}
+	for (auto &entry : metadata_manager.GetTableSnapshot(resolved.cache.cache_name)) {
+		if (ToUpper(entry.first) == ToUpper(resolved.table)) {
+			return Value::BIGINT(entry.second.bytes);
+		}
+	}
+	return Value();
+}
+
+static unique_ptr<GlobalTableFunctionState> DuckSyncExplainInitGlobal(ClientContext &context,
+                                                                      TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<ExplainBindData>();
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	auto result = make_uniq<ExplainGlobalState>();
+
+	auto tables = ExtractTableReferences(bind_data.sql_query);
+	auto resolution = ResolveQueryTables(context, state, tables, false);
+	bool use_cache = resolution.all_cached && !resolution.rewrites.empty();
+
+	if (use_cache) {
+		result->route = "cache";
+		std::vector<std::string> pending;
+		for (auto &cache : resolution.caches_to_refresh) {
+			pending.push_back(cache.cache_name);
+		}
+		for (auto &cache : resolution.caches_to_rehydrate) {
+			pending.push_back(cache.cache_name);
+		}
+		if (!pending.empty()) {
+			result->reason = Value("ducksync_query refreshes " + StringUtil::Join(pending, ", ") + " first");
+		}
+	} else {
+		result->route = "passthrough";
+		if (tables.empty()) {
+			result->reason = Value("no table references found");
+		}
+		for (auto &resolved : resolution.tables) {
+			if (!resolved.cached) {
+				result->reason = Value("table '" + resolved.table + "' has no cache");
+				break;
+			}
+		}
+	}
+
+	auto mirror_policy = GetLocalMirrorPolicy(context);
+	bool remote_ducklake = use_cache && state.storage_manager->HasRemoteDataPath();
+	for (auto &resolved : resolution.tables) {
+		ExplainRow row;
+		row.table_name = Value(resolved.table);
+		row.read_from = "warehouse";
+		row.local_bytes = Value::BIGINT(0);
+		if (resolved.cached) {
+			row.cache_name = Value(resolved.cache.cache_name);
+			row.freshness = Value(resolved.freshness);
+		}
+		if (!use_cache) {
+			if (resolved.cached) {
+				row.remote_bytes = LastKnownSourceBytes(*state.metadata_manager, resolved);
+			}
+			result->rows.push_back(std::move(row));
+			continue;
+		}
+
+		// Caches that are never refreshed or evicted are read from DuckLake once refreshed; their size is unknown
+		row.read_from = "ducklake";
+		row.local_bytes = Value();
+		if (resolved.freshness == "never_refreshed" || resolved.freshness == "evicted") {
+			result->rows.push_back(std::move(row));
+			continue;
+		}
+		auto &rewrite = resolution.rewrites[ToUpper(resolved.table)];
+		row.read_from = RouteToLocalCopy(context, state, resolved.cache, resolved.state, mirror_policy, false, rewrite);
+		int64_t file_count = 0;
+		int64_t total_bytes = 0;
+		if (state.storage_manager->GetTableFileStats(resolved.cache.cache_name, resolved.cache.source_name,
+		                                             file_count, total_bytes)) {
+			bool remote = row.read_from == "ducklake" && remote_ducklake;
+			row.local_bytes = Value::BIGINT(remote ? 0 : total_bytes);
+			row.remote_bytes = Value::BIGINT(remote ? total_bytes : 0);
+		}
+		result->rows.push_back(std::move(row));
+	}
+	if (tables.empty()) {
+		ExplainRow row;
+		row.read_from = "warehouse";
+		row.local_bytes = Value::BIGINT(0);
+		result->rows.push_back(std::move(row));
+	}
+
+	result->execution_sql = use_cache ? RewriteQueryWithAST(bind_data.sql_query, resolution.rewrites)
+	                                  : PassthroughQuerySQL(context, bind_data.sql_query, bind_data.source);
+	return std::move(result);
+}
+
+static void DuckSyncExplainFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &gstate = data_p.global_state->Cast<ExplainGlobalState>();
+
+	idx_t count = 0;
+	while (gstate.offset < gstate.rows.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &row = gstate.rows[gstate.offset++];
+		output.SetValue(0, count, row.table_name);
+		output.SetValue(1, count, row.cache_name);
+		output.SetValue(2, count, row.freshness);
+		output.SetValue(3, count, Value(row.read_from));
+		output.SetValue(4, count, Value(gstate.route));
+		output.SetValue(5, count, gstate.reason);
+		output.SetValue(6, count, Value(gstate.execution_sql));
+		output.SetValue(7, count, row.local_bytes);
+		output.SetValue(8, count, row.remote_bytes);
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_ingest_scan(channel_id)
+// Internal: drains an IngestChannel so refreshes can INSERT ... SELECT from a bounded stream
+//===--------------------------------------------------------------------===//
+struct IngestScanBindData : public TableFunctionData {
+	idx_t channel_id = 0;
+};
+
+struct IngestScanGlobalState : public GlobalTableFunctionState {
+	std::shared_ptr<IngestChannel> channel;
+
+	// One scan thread per producer, so split extractions are also written in parallel
+	idx_t MaxThreads() const override {
+		return MaxValue<idx_t>(channel->ProducerCount(), 1);
+	}
+};
+
+struct IngestScanLocalState : public LocalTableFunctionState {
+	unique_ptr<DataChunk> current_chunk; // Keep chunk alive while output references it
+};
+
+static unique_ptr<FunctionData> DuckSyncIngestScanBind(ClientContext &context, TableFunctionBindInput &input,
+                                                       vector<LogicalType> &return_types, vector<string> &names) {
+	auto result = make_uniq<IngestScanBindData>();
+	result->channel_id = static_cast<idx_t>(input.inputs[0].GetValue<int64_t>());
+
+	auto channel = IngestChannelRegistry::Get(result->channel_id);
+	if (!channel) {
+		throw InvalidInputException("ducksync_ingest_scan: no active ingest channel " +
+		                            std::to_string(result->channel_id));
+	}
+	return_types = channel->Types();
+	names = channel->Names();
+	return std::move(result);
+}
+
+static unique_ptr<GlobalTableFunctionState> DuckSyncIngestScanInitGlobal(ClientContext &context,
+                                                                         TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<IngestScanBindData>();
+	auto gstate = make_uniq<IngestScanGlobalState>();
+	gstate->channel = IngestChannelRegistry::Get(bind_data.channel_id);
+	if (!gstate->channel) {
+		throw InvalidInputException("ducksync_ingest_scan: ingest channel is no longer active");
+	}
+	return std::move(gstate);
+}
+
+static unique_ptr<LocalTableFunctionState> DuckSyncIngestScanInitLocal(ExecutionContext &context,
+                                                                       TableFunctionInitInput &input,
+                                                                       GlobalTableFunctionState *global_state) {
+	return make_uniq<IngestScanLocalState>();
+}
+
+static void DuckSyncIngestScanFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &gstate = data_p.global_state->Cast<IngestScanGlobalState>();
+	auto &lstate = data_p.local_state->Cast<IngestScanLocalState>();
+
+	lstate.current_chunk = gstate.channel->Pop();
+	if (!lstate.current_chunk) {
+		output.SetCardinality(0);
+		return;
+	}
+	output.Reference(*lstate.current_chunk);
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_refresh_history([cache_name := ...])
+// Per-cache refresh counts and p50/p95 phase timings from refresh_history
+//===--------------------------------------------------------------------===//
+struct RefreshHistoryBindData : public TableFunctionData {
+	std::string cache_name;
+};
+
+static unique_ptr<FunctionData> DuckSyncRefreshHistoryBind(ClientContext &context, TableFunctionBindInput &input,
+                                                           vector<LogicalType> &return_types, vector<string> &names) {
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (!state.metadata_manager || !state.storage_manager) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	auto result = make_uniq<RefreshHistoryBindData>();
+	for (auto &kv : input.named_parameters) {
+		if (kv.first == "cache_name") {
+			result->cache_name = kv.second.ToString();
+		}
+	}
+
+	// Must match DuckSyncMetadataManager::SummarizeRefreshHistory
+	names = {"cache_name",   "refreshes",    "skips",        "errors",       "p50_total_ms",
+	         "p95_total_ms", "p50_probe_ms", "p95_probe_ms", "p50_fetch_ms", "p95_fetch_ms",
+	         "p50_write_ms", "p95_write_ms", "p50_rows",     "rows_per_sec", "max_peak_memory_bytes",
+	         "last_started_at"};
+	return_types = {LogicalType::VARCHAR, LogicalType::BIGINT, LogicalType::BIGINT, LogicalType::BIGINT,
+	                LogicalType::DOUBLE,  LogicalType::DOUBLE, LogicalType::DOUBLE, LogicalType::DOUBLE,
+	                LogicalType::DOUBLE,  LogicalType::DOUBLE, LogicalType::DOUBLE, LogicalType::DOUBLE,
+	                LogicalType::DOUBLE,  LogicalType::DOUBLE, LogicalType::BIGINT, LogicalType::TIMESTAMP};
+	return std::move(result);
+}
+
+static unique_ptr<GlobalTableFunctionState> DuckSyncRefreshHistoryInitGlobal(ClientContext &context,
+                                                                             TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<RefreshHistoryBindData>();
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+
+	auto gstate = make_uniq<DuckSyncStreamingQueryGlobalState>();
+	gstate->result = state.metadata_manager->SummarizeRefreshHistory(bind_data.cache_name);
+	return std::move(gstate);
+}
+
+static void DuckSyncRefreshHistoryFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	StreamQueryResultToOutput(*data_p.global_state, output);
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_cleanup([cache_name])
+// DuckLake maintenance: expire old snapshots and delete unreferenced data files
+//===--------------------------------------------------------------------===//
+struct CleanupBindData : public TableFunctionData {
+	std::string cache_name; // empty = all caches
+	bool done = false;
+};
+
+static unique_ptr<FunctionData> DuckSyncCleanupBind(ClientContext &context, TableFunctionBindInput &input,
+                                                    vector<LogicalType> &return_types, vector<string> &names) {
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (!state.metadata_manager || !state.storage_manager) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	auto result = make_uniq<CleanupBindData>();
+	if (!input.inputs.empty()) {
+		result->cache_name = input.inputs[0].GetValue<string>();
+	}
+
+	names = {"snapshots_expired",  "files_cleaned",  "orphans_deleted", "bytes_reclaimed",
+	         "snapshot_retention", "file_retention", "message"};
+	return_types = {LogicalType::BIGINT,  LogicalType::BIGINT,  LogicalType::BIGINT, LogicalType::BIGINT,
+	                LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR};
+	return std::move(result);
+}
+
+static void DuckSyncCleanupFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &bind_data = data_p.bind_data->CastNoConst<CleanupBindData>();
+
+	if (bind_data.done) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	// Deleting files can take a while: it runs on copies of the managers, without holding the state
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	auto managers = state.Managers();
+	state_lock.unlock();
+	CleanupManager cleanup(context, *managers.metadata_manager, *managers.storage_manager);
+	auto result = bind_data.cache_name.empty() ? cleanup.CleanupAll() : cleanup.CleanupCache(bind_data.cache_name);
+	bind_data.done = true;
+
+	output.SetCardinality(1);
+	output.SetValue(0, 0, Value::BIGINT(result.snapshots_expired));
+	output.SetValue(1, 0, Value::BIGINT(result.files_cleaned));
+	output.SetValue(2, 0, Value::BIGINT(result.orphans_deleted));
+	output.SetValue(3, 0, Value::BIGINT(result.bytes_reclaimed));
+	output.SetValue(4, 0, result.snapshot_retention.empty() ? Value() : Value(result.snapshot_retention));
+	output.SetValue(5, 0, result.file_retention.empty() ? Value() : Value(result.file_retention));
+	output.SetValue(6, 0, Value(result.message));
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_file_stats()
+// One row per cache: data files backing its table and whether small-file compaction is due
+//===--------------------------------------------------------------------===//
+struct CacheFileStatsRow {
+	std::string cache_name;
+	std::string source_name;
+	bool has_stats = false;
+	int64_t file_count = 0;
+	int64_t total_bytes = 0;
+};
+
+struct FileStatsGlobalState : public GlobalTableFunctionState {
+	std::vector<CacheFileStatsRow> rows;
+	CompactionPolicy policy;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> DuckSyncFileStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                      vector<LogicalType> &return_types, vector<string> &names) {
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (!state.metadata_manager || !state.storage_manager) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	names = {"cache_name", "source_name", "file_count", "total_bytes", "avg_file_bytes", "compaction_due"};
+	return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::BIGINT,
+	                LogicalType::BIGINT,  LogicalType::BIGINT,  LogicalType::BOOLEAN};
+	return make_uniq<TableFunctionData>();
+}
+
+static unique_ptr<GlobalTableFunctionState> DuckSyncFileStatsInitGlobal(ClientContext &context,
+                                                                        TableFunctionInitInput &input) {
+	auto result = make_uniq<FileStatsGlobalState>();
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	result->policy = GetCompactionPolicy(context);
+	for (auto &cache : state.metadata_manager->ListCaches()) {
+		CacheFileStatsRow row;
+		row.cache_name = cache.cache_name;
+		row.source_name = cache.source_name;
+		// Caches that were never refreshed have no table yet
+		row.has_stats = state.storage_manager->GetTableFileStats(cache.cache_name, cache.source_name, row.file_count,
+		                                                         row.total_bytes);
+		result->rows.push_back(std::move(row));
+	}
+	return std::move(result);
+}
+
+static void DuckSyncFileStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &gstate = data_p.global_state->Cast<FileStatsGlobalState>();
+
+	idx_t count = 0;
+	while (gstate.offset < gstate.rows.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &row = gstate.rows[gstate.offset++];
+		output.SetValue(0, count, Value(row.cache_name));
+		output.SetValue(1, count, Value(row.source_name));
+		if (row.has_stats) {
+			output.SetValue(2, count, Value::BIGINT(row.file_count));
+			output.SetValue(3, count, Value::BIGINT(row.total_bytes));
+			output.SetValue(4, count, row.file_count > 0 ? Value::BIGINT(row.total_bytes / row.file_count) : Value());
+			output.SetValue(5, count, Value::BOOLEAN(gstate.policy.IsDue(row.file_count, row.total_bytes)));
+		} else {
+			for (idx_t col = 2; col < 6; col++) {
+				output.SetValue(col, count, Value());
+			}
+		}
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_mirror_stats()
+// The local file mirror's size and how many reads it served
+//===--------------------------------------------------------------------===//
+struct MirrorStatsBindData : public TableFunctionData {
+	bool done = false;
+};
+
+static unique_ptr<FunctionData> DuckSyncMirrorStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                        vector<LogicalType> &return_types, vector<string> &names) {
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (!state.local_mirror) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	names = {"mirror_path", "capacity_bytes", "used_bytes", "files", "hits", "misses", "hit_ratio", "bytes_saved"};
+	return_types = {LogicalType::VARCHAR, LogicalType::BIGINT, LogicalType::BIGINT, LogicalType::BIGINT,
+	                LogicalType::BIGINT,  LogicalType::BIGINT, LogicalType::DOUBLE, LogicalType::BIGINT};
+	return make_uniq<MirrorStatsBindData>();
+}
+
+static void DuckSyncMirrorStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &bind_data = data_p.bind_data->CastNoConst<MirrorStatsBindData>();
+	if (bind_data.done) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	auto stats = state.local_mirror->GetStats(GetLocalMirrorPolicy(context));
+	auto reads = stats.hits + stats.misses;
+
+	output.SetCardinality(1);
+	output.SetValue(0, 0, stats.path.empty() ? Value() : Value(stats.path));
+	output.SetValue(1, 0, Value::BIGINT(static_cast<int64_t>(stats.capacity_bytes)));
+	output.SetValue(2, 0, Value::BIGINT(static_cast<int64_t>(stats.used_bytes)));
+	output.SetValue(3, 0, Value::BIGINT(static_cast<int64_t>(stats.files)));
+	output.SetValue(4, 0, Value::BIGINT(stats.hits));
+	output.SetValue(5, 0, Value::BIGINT(stats.misses));
+	output.SetValue(6, 0, reads > 0 ? Value::DOUBLE(static_cast<double>(stats.hits) / reads) : Value());
+	output.SetValue(7, 0, Value::BIGINT(stats.bytes_saved));
+	bind_data.done = true;
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_storage()
+// One row per cache: disk usage, reads and eviction state under ducksync_storage_budget
+//===--------------------------------------------------------------------===//
+struct StorageGlobalState : public GlobalTableFunctionState {
+	std::vector<CacheStorageInfo> rows;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> DuckSyncStorageBind(ClientContext &context, TableFunctionBindInput &input,
+                                                    vector<LogicalType> &return_types, vector<string> &names) {
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (!state.storage_budget) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	names = {"cache_name", "source_name", "size_bytes", "retained_bytes", "file_count",
+	         "accesses",   "last_access", "refresh_ms", "score",          "evicted"};
+	return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR,   LogicalType::BIGINT, LogicalType::BIGINT,
+	                LogicalType::BIGINT,  LogicalType::BIGINT,    LogicalType::TIMESTAMP, LogicalType::DOUBLE,
+	                LogicalType::DOUBLE,  LogicalType::BOOLEAN};
+	return make_uniq<TableFunctionData>();
+}
+
+static unique_ptr<GlobalTableFunctionState> DuckSyncStorageInitGlobal(ClientContext &context,
+                                                                      TableFunctionInitInput &input) {
+	auto result = make_uniq<StorageGlobalState>();
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	// Reads are ranked from usage_stats, so this node's latest reads go out first
+	if (state.usage_stats) {
+		state.usage_stats->Flush();
+	}
+	result->rows = state.storage_budget->Collect();
+	// Next to be evicted first
+	std::sort(result->rows.begin(), result->rows.end(),
+	          [](const CacheStorageInfo &a, const CacheStorageInfo &b) { return a.score < b.score; });
+	return std::move(result);
+}
+
+static void DuckSyncStorageFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &gstate = data_p.global_state->Cast<StorageGlobalState>();
+
+	idx_t count = 0;
+	while (gstate.offset < gstate.rows.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &row = gstate.rows[gstate.offset++];
+		output.SetValue(0, count, Value(row.cache_name));
+		output.SetValue(1, count, Value(row.source_name));
+		output.SetValue(2, count, Value::BIGINT(row.size_bytes));
+		output.SetValue(3, count, Value::BIGINT(row.retained_bytes));
+		output.SetValue(4, count, Value::BIGINT(row.files));
+		output.SetValue(5, count, Value::BIGINT(row.accesses));
+		output.SetValue(6, count, row.has_last_access ? Value::TIMESTAMP(row.last_access) : Value());
+		output.SetValue(7, count, Value::DOUBLE(row.refresh_ms));
+		output.SetValue(8, count, Value::DOUBLE(row.score));
+		output.SetValue(9, count, Value::BOOLEAN(row.evicted));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_stats()
+// One row per cache (and per source with passthroughs): how its reads were served, across all nodes
+//===--------------------------------------------------------------------===//
+struct CacheStatsRow {
+	Value cache_name; // NULL for a source's passthrough row
+	std::string source_name;
+	int64_t scan_hits = 0;
+	int64_t query_hits = 0;
+	int64_t passthrough_misses = 0;
+	int64_t refreshes = 0;
+	int64_t skipped_refreshes = 0;
+	int64_t rows_served = 0;
+	int64_t bytes_avoided = 0;
+};
+
+struct StatsGlobalState : public GlobalTableFunctionState {
+	std::vector<CacheStatsRow> rows;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> DuckSyncStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                  vector<LogicalType> &return_types, vector<string> &names) {
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (!state.usage_stats) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	names = {"cache_name", "source_name",       "scan_hits",   "query_hits",   "passthrough_misses",
+	         "refreshes",  "skipped_refreshes", "rows_served", "bytes_avoided"};
+	return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::BIGINT,
+	                LogicalType::BIGINT,  LogicalType::BIGINT,  LogicalType::BIGINT,
+	                LogicalType::BIGINT,  LogicalType::BIGINT,  LogicalType::BIGINT};
+	return make_uniq<TableFunctionData>();
+}
+
+static unique_ptr<GlobalTableFunctionState> DuckSyncStatsInitGlobal(ClientContext &context,
+                                                                    TableFunctionInitInput &input) {
+	auto result = make_uniq<StatsGlobalState>();
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+
+	// Counts still in memory go out first, so this node's latest reads are included
+	state.usage_stats->Flush();
+
+	// Caches by name, then one passthrough row per source
+	std::map<std::pair<bool, std::string>, CacheStatsRow> rows;
+	for (auto &cache : state.metadata_manager->ListCaches()) {
+		auto &row = rows[{false, cache.cache_name}];
+		row.cache_name = Value(cache.cache_name);
+		row.source_name = cache.source_name;
+	}
+
+	// Must match DuckSyncMetadataManager::SummarizeUsageStats
+	auto usage = state.metadata_manager->SummarizeUsageStats();
+	for (idx_t i = 0; i < usage->RowCount(); i++) {
+		auto cache_name = usage->GetValue(0, i);
+		auto key = cache_name.IsNull() ? std::make_pair(true, usage->GetValue(1, i).ToString())
+		                               : std::make_pair(false, cache_name.ToString());
+		auto &row = rows[key];
+		row.cache_name = cache_name;
+		row.source_name = usage->GetValue(1, i).ToString();
+		row.scan_hits = usage->GetValue(2, i).GetValue<int64_t>();
+		row.query_hits = usage->GetValue(3, i).GetValue<int64_t>();
+		row.passthrough_misses = usage->GetValue(4, i).GetValue<int64_t>();
+		row.rows_served = usage->GetValue(5, i).GetValue<int64_t>();
+		row.bytes_avoided = usage->GetValue(6, i).GetValue<int64_t>();
+	}
+
+	// Refreshes are already counted per call in refresh_history
+	auto history = state.metadata_manager->SummarizeRefreshHistory("");
+	for (idx_t i = 0; i < history->RowCount(); i++) {
+		auto entry = rows.find({false, history->GetValue(0, i).ToString()});
+		if (entry != rows.end()) {
+			entry->second.refreshes = history->GetValue(1, i).GetValue<int64_t>();
+			entry->second.skipped_refreshes = history->GetValue(2, i).GetValue<int64_t>();
+		}
+	}
+
+	for (auto &entry : rows) {
+		result->rows.push_back(std::move(entry.second));
+	}
+	return std::move(result);
+}
+
+static void DuckSyncStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &gstate = data_p.global_state->Cast<StatsGlobalState>();
+
+	idx_t count = 0;
+	while (gstate.offset < gstate.rows.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &row = gstate.rows[gstate.offset++];
+		output.SetValue(0, count, row.cache_name);
+		output.SetValue(1, count, Value(row.source_name));
+		output.SetValue(2, count, Value::BIGINT(row.scan_hits));
+		output.SetValue(3, count, Value::BIGINT(row.query_hits));
+		output.SetValue(4, count, Value::BIGINT(row.passthrough_misses));
+		output.SetValue(5, count, Value::BIGINT(row.refreshes));
+		output.SetValue(6, count, Value::BIGINT(row.skipped_refreshes));
+		output.SetValue(7, count, Value::BIGINT(row.rows_served));
+		output.SetValue(8, count, Value::BIGINT(row.bytes_avoided));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_latency([reset := ...])
+// p50/p90/p99 per routing stage since DuckSync was initialized or last reset
+//===--------------------------------------------------------------------===//
+struct LatencyBindData : public TableFunctionData {
+	bool reset = false;
+	bool done = false;
+};
+
+static unique_ptr<FunctionData> DuckSyncLatencyBind(ClientContext &context, TableFunctionBindInput &input,
+                                                    vector<LogicalType> &return_types, vector<string> &names) {
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	if (!state.latency) {
+		throw InvalidInputException("DuckSync not initialized. Call ducksync_init or ducksync_setup_storage first.");
+	}
+
+	auto result = make_uniq<LatencyBindData>();
+	for (auto &kv : input.named_parameters) {
+		if (kv.first == "reset") {
+			result->reset = kv.second.GetValue<bool>();
+		}
+	}
+
+	names = {"stage", "count", "p50_ms", "p90_ms", "p99_ms", "max_ms", "mean_ms"};
+	return_types = {LogicalType::VARCHAR, LogicalType::BIGINT, LogicalType::DOUBLE, LogicalType::DOUBLE,
+	                LogicalType::DOUBLE,  LogicalType::DOUBLE, LogicalType::DOUBLE};
+	return std::move(result);
+}
+
+static void DuckSyncLatencyFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &bind_data = data_p.bind_data->CastNoConst<LatencyBindData>();
+	if (bind_data.done) {
+		output.SetCardinality(0);
+		return;
+	}
+
+	auto &state = GetDuckSyncState(context);
+	auto state_lock = state.ReadLock();
+	idx_t count = 0;
+	for (idx_t i = 0; i < static_cast<idx_t>(LatencyStage::COUNT); i++) {
+		auto stage = static_cast<LatencyStage>(i);
+		auto summary = state.latency->Summarize(stage);
+		output.SetValue(0, count, Value(LatencyStageToString(stage)));
+		output.SetValue(1, count, Value::BIGINT(static_cast<int64_t>(summary.count)));
+		if (summary.count > 0) {
+			output.SetValue(2, count, Value::DOUBLE(summary.p50_ms));
+			output.SetValue(3, count, Value::DOUBLE(summary.p90_ms));
+			output.SetValue(4, count, Value::DOUBLE(summary.p99_ms));
+			output.SetValue(5, count, Value::DOUBLE(summary.max_ms));
+			output.SetValue(6, count, Value::DOUBLE(summary.mean_ms));
+		} else {
+			for (idx_t col = 2; col < 7; col++) {
+				output.SetValue(col, count, Value());
+			}
+		}
+		count++;
+	}
+	// The rows above are the last view of the discarded samples
+	if (bind_data.reset) {
+		state.latency->Reset();
+	}
+	output.SetCardinality(count);
+	bind_data.done = true;
+}
+
+//===--------------------------------------------------------------------===//
+// ducksync_traces([clear := ...])
+// Spans recorded while ducksync_trace is on, oldest first; shared by all connections of the process
+//===--------------------------------------------------------------------===//
+struct TracesBindData : public TableFunctionData {
+	bool clear = false;
+};
+
+struct TracesGlobalState : public GlobalTableFunctionState {
+	std::vector<TraceSpan> rows;
+	idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> DuckSyncTracesBind(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<string> &names) {
+	auto result = make_uniq<TracesBindData>();
+	for (auto &kv : input.named_parameters) {
+		if (kv.first == "clear") {
+			result->clear = kv.second.GetValue<bool>();
+		}
+	}
+
+	names = {"trace_id",    "span_id",        "parent_id",        "name",      "started_at",
+	         "duration_ms", "metadata_reads", "metadata_commits", "attributes"};
+	return_types = {LogicalType::VARCHAR,   LogicalType::BIGINT, LogicalType::BIGINT, LogicalType::VARCHAR,
+	                LogicalType::TIMESTAMP, LogicalType::DOUBLE, LogicalType::BIGINT, LogicalType::BIGINT,
+	                LogicalType::MAP(LogicalType::VARCHAR, LogicalType::VARCHAR)};
+	return std::move(result);
+}
+
+static unique_ptr<GlobalTableFunctionState> DuckSyncTracesInitGlobal(ClientContext &context,
+                                                                     TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<TracesBindData>();
+	auto result = make_uniq<TracesGlobalState>();
+	result->rows = TraceRecorder::Snapshot();
+	// The rows above are the last view of the discarded spans
+	if (bind_data.clear) {
+		TraceRecorder::Clear();
+	}
+	return std::move(result);
+}
+
+static void DuckSyncTracesFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &gstate = data_p.global_state->Cast<TracesGlobalState>();
+
+	idx_t count = 0;
+	while (gstate.offset < gstate.rows.size() && count < STANDARD_VECTOR_SIZE) {
+		auto &row = gstate.rows[gstate.offset++];
+		vector<Value> keys;
+		vector<Value> values;
+		for (auto &attribute : row.attributes) {
+			keys.emplace_back(attribute.first);
+			values.emplace_back(attribute.second);
+		}
+		output.SetValue(0, count, Value(row.trace_id));
+		output.SetValue(1, count, Value::BIGINT(row.span_id));
+		output.SetValue(2, count, row.parent_id == 0 ? Value() : Value::BIGINT(row.parent_id));
+		output.SetValue(3, count, Value(row.name));
+		output.SetValue(4, count, Value::TIMESTAMP(row.started_at));
+		output.SetValue(5, count, Value::DOUBLE(row.duration_ms));
+		output.SetValue(6, count, Value::BIGINT(row.metadata_reads));
+		output.SetValue(7, count, Value::BIGINT(row.metadata_commits));
+		output.SetValue(8, count,
+		                Value::MAP(LogicalType::VARCHAR, LogicalType::VARCHAR, std::move(keys), std::move(values)));
+		count++;
+	}
+	output.SetCardinality(count);
+}
+
+//===--------------------------------------------------------------------===//
+// Extension Load - Using ExtensionLoader API
+//===--------------------------------------------------------------------===//
+static void LoadInternal(ExtensionLoader &loader) {
+	// Register ducksync_init (use existing DuckLake catalog)
+	// 1-arg: ducksync_init(catalog_name) - backward compatible, schema defaults to "ducksync"
+	TableFunction init_func_1("ducksync_init", {LogicalType::VARCHAR}, DuckSyncInitFunction, DuckSyncInitBind);
+	loader.RegisterFunction(init_func_1);
+	// 2-arg: ducksync_init(catalog_name, schema_name) - custom metadata schema (e.g. for GizmoSQL)
+	TableFunction init_func_2("ducksync_init", {LogicalType::VARCHAR, LogicalType::VARCHAR}, DuckSyncInitFunction,
+	                          DuckSyncInitBind);
+	loader.RegisterFunction(init_func_2);
+
+	// Register ducksync_setup_storage (full setup - attaches DuckLake)
+	// 2-arg: ducksync_setup_storage(pg_conn, data_path) - backward compatible, schema defaults to "ducksync"
+	TableFunction setup_storage_func_2("ducksync_setup_storage", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+	                                   DuckSyncSetupStorageFunction, DuckSyncSetupStorageBind);
+	loader.RegisterFunction(setup_storage_func_2);
+	// 3-arg: ducksync_setup_storage(pg_conn, data_path, schema_name) - custom metadata schema
+	TableFunction setup_storage_func_3("ducksync_setup_storage",
+	                                   {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR},
+	                                   DuckSyncSetupStorageFunction, DuckSyncSetupStorageBind);
+	loader.RegisterFunction(setup_storage_func_3);
+
+	// Register ducksync_add_source
+	TableFunction add_source_func("ducksync_add_source",
+	                              {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR},
+	                              DuckSyncAddSourceFunction, DuckSyncAddSourceBind);
+	add_source_func.named_parameters["passthrough_enabled"] = LogicalType::BOOLEAN;
+	loader.RegisterFunction(add_source_func);
+
+	// Register ducksync_create_cache
+	TableFunction create_cache_func(
+	    "ducksync_create_cache",
+	    {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::LIST(LogicalType::VARCHAR)},
+	    DuckSyncCreateCacheFunction, DuckSyncCreateCacheBind);
+	create_cache_func.varargs = LogicalType::BIGINT;
+	create_cache_func.named_parameters["invalidation_mode"] = LogicalType::VARCHAR;
+	create_cache_func.named_parameters["metadata_secret"] = LogicalType::VARCHAR;
+	create_cache_func.named_parameters["split_column"] = LogicalType::VARCHAR;
+	create_cache_func.named_parameters["parallelism"] = LogicalType::BIGINT;
+	create_cache_func.named_parameters["snapshot_retention"] = LogicalType::VARCHAR;
+	create_cache_func.named_parameters["file_retention"] = LogicalType::VARCHAR;
+	create_cache_func.named_parameters["sort_by"] = LogicalType::VARCHAR;
+	create_cache_func.named_parameters["row_group_size"] = LogicalType::BIGINT;
+	create_cache_func.named_parameters["target_file_size"] = LogicalType::VARCHAR;
+	create_cache_func.named_parameters["compression"] = LogicalType::VARCHAR;
+	create_cache_func.named_parameters["bloom_filter_columns"] = LogicalType::LIST(LogicalType::VARCHAR);
+	create_cache_func.named_parameters["partition_by"] = LogicalType::LIST(LogicalType::VARCHAR);
+	create_cache_func.named_parameters["memory_tier"] = LogicalType::BOOLEAN;
+	loader.RegisterFunction(create_cache_func);
 
 	// Register ducksync_refresh
 	TableFunction refresh_func("ducksync_refresh", {LogicalType::VARCHAR}, DuckSyncRefreshFunction,
@@ -986,6 +2384,82 @@ static void LoadInternal(ExtensionLoader &loader) {
 	refresh_func.named_parameters["force"] = LogicalType::BOOLEAN;
 	loader.RegisterFunction(refresh_func);
 
+	// Register background scheduler lifecycle and status
+	TableFunction scheduler_start_func("ducksync_scheduler_start", {}, DuckSyncSchedulerStartFunction,
+	                                   DuckSyncSchedulerStartBind);
+	scheduler_start_func.named_parameters["workers"] = LogicalType::BIGINT;
+	scheduler_start_func.named_parameters["probe_interval"] = LogicalType::BIGINT;
+	scheduler_start_func.named_parameters["min_interval"] = LogicalType::BIGINT;
+	scheduler_start_func.named_parameters["jitter"] = LogicalType::DOUBLE;
+	loader.RegisterFunction(scheduler_start_func);
+
+	TableFunction scheduler_stop_func("ducksync_scheduler_stop", {}, DuckSyncSchedulerStopFunction,
+	                                  DuckSyncSchedulerStopBind);
+	loader.RegisterFunction(scheduler_stop_func);
+
+	TableFunction scheduler_status_func("ducksync_scheduler_status", {}, DuckSyncSchedulerStatusFunction,
+	                                    DuckSyncSchedulerStatusBind, DuckSyncSchedulerStatusInitGlobal);
+	loader.RegisterFunction(scheduler_status_func);
+
+	// Register ducksync_ingest_scan (internal: source of streaming refresh inserts)
+	TableFunction ingest_scan_func("ducksync_ingest_scan", {LogicalType::BIGINT}, DuckSyncIngestScanFunction,
+	                               DuckSyncIngestScanBind, DuckSyncIngestScanInitGlobal, DuckSyncIngestScanInitLocal);
+	loader.RegisterFunction(ingest_scan_func);
+
+	// Register ducksync_refresh_history
+	TableFunction refresh_history_func("ducksync_refresh_history", {}, DuckSyncRefreshHistoryFunction,
+	                                   DuckSyncRefreshHistoryBind, DuckSyncRefreshHistoryInitGlobal);
+	refresh_history_func.named_parameters["cache_name"] = LogicalType::VARCHAR;
+	loader.RegisterFunction(refresh_history_func);
+
+	// Register ducksync_cleanup (0-arg: all caches, 1-arg: one cache)
+	TableFunction cleanup_func_0("ducksync_cleanup", {}, DuckSyncCleanupFunction, DuckSyncCleanupBind);
+	loader.RegisterFunction(cleanup_func_0);
+	TableFunction cleanup_func_1("ducksync_cleanup", {LogicalType::VARCHAR}, DuckSyncCleanupFunction,
+	                             DuckSyncCleanupBind);
+	loader.RegisterFunction(cleanup_func_1);
+
+	// Register ducksync_mirror_stats
+	TableFunction mirror_stats_func("ducksync_mirror_stats", {}, DuckSyncMirrorStatsFunction,
+	                                DuckSyncMirrorStatsBind);
+	loader.RegisterFunction(mirror_stats_func);
+
+	// Register ducksync_storage
+	TableFunction storage_func("ducksync_storage", {}, DuckSyncStorageFunction, DuckSyncStorageBind,
+	                           DuckSyncStorageInitGlobal);
+	loader.RegisterFunction(storage_func);
+
+	// Register ducksync_stats
+	TableFunction stats_func("ducksync_stats", {}, DuckSyncStatsFunction, DuckSyncStatsBind, DuckSyncStatsInitGlobal);
+	loader.RegisterFunction(stats_func);
+
+	// Register ducksync_latency
+	TableFunction latency_func("ducksync_latency", {}, DuckSyncLatencyFunction, DuckSyncLatencyBind);
+	latency_func.named_parameters["reset"] = LogicalType::BOOLEAN;
+	loader.RegisterFunction(latency_func);
+
+	// Register ducksync_traces
+	TableFunction traces_func("ducksync_traces", {}, DuckSyncTracesFunction, DuckSyncTracesBind,
+	                          DuckSyncTracesInitGlobal);
+	traces_func.named_parameters["clear"] = LogicalType::BOOLEAN;
+	loader.RegisterFunction(traces_func);
+
+	// Register ducksync_file_stats
+	TableFunction file_stats_func("ducksync_file_stats", {}, DuckSyncFileStatsFunction, DuckSyncFileStatsBind,
+	                              DuckSyncFileStatsInitGlobal);
+	loader.RegisterFunction(file_stats_func);
+
+	// Register ducksync_explain
+	TableFunction explain_func("ducksync_explain", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+	                           DuckSyncExplainFunction, DuckSyncExplainBind, DuckSyncExplainInitGlobal);
+	loader.RegisterFunction(explain_func);
+
+	// Register ducksync_emulated_query
+	TableFunction emulated_query_func("ducksync_emulated_query", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+	                                  DuckSyncEmulatedQueryFunction, DuckSyncEmulatedQueryBind,
+	                                  DuckSyncEmulatedQueryInitGlobal);
+	loader.RegisterFunction(emulated_query_func);
+
 	// Register ducksync_query (new smart routing function)
 	TableFunction query_func("ducksync_query", {LogicalType::VARCHAR, LogicalType::VARCHAR}, DuckSyncQueryFunction,
 	                         DuckSyncQueryBind, DuckSyncQueryInitGlobal);
@@ -1003,8 +2477,83 @@ static void LoadInternal(ExtensionLoader &loader) {
 	TableFunction stop_func("ducksync_stop", {LogicalType::VARCHAR}, DuckSyncStopFunction, DuckSyncStopBind);
 	loader.RegisterFunction(stop_func);
 
-	// Register replacement_scan hook
 	auto &db = loader.GetDatabaseInstance();
+
+	// Settings
+	auto &config = DBConfig::GetConfig(db);
+	config.AddExtensionOption("ducksync_refresh_lease_seconds",
+	                          "Seconds a node holds the cross-node refresh lease for a cache before other nodes may "
+	                          "take over; renewed while the refresh runs, so it only bounds how long a crashed node "
+	                          "blocks others",
+	                          LogicalType::BIGINT, Value::BIGINT(DEFAULT_REFRESH_LEASE_SECONDS),
+	                          ValidateRefreshLeaseSeconds);
+	config.AddExtensionOption("ducksync_ingest_memory_budget",
+	                          "Maximum bytes of source data buffered between the fetch and the DuckLake writer during "
+	                          "a refresh; the fetch pauses when the budget is reached",
+	                          LogicalType::VARCHAR, Value(DEFAULT_INGEST_MEMORY_BUDGET), ValidateIngestMemoryBudget);
+	config.AddExtensionOption("ducksync_ingest_target_file_size",
+	                          "Target Parquet file size for refreshed cache tables (e.g. '512MB'); empty keeps the "
+	                          "DuckLake default",
+	                          LogicalType::VARCHAR, Value(""), ValidateIngestTargetFileSize);
+	config.AddExtensionOption("ducksync_snapshot_retention",
+	                          "How long DuckLake snapshots are kept by ducksync_cleanup for caches without their own "
+	                          "snapshot_retention",
+	                          LogicalType::VARCHAR, Value(DEFAULT_SNAPSHOT_RETENTION), ValidateSnapshotRetentionSetting,
+	                          SetScope::GLOBAL);
+	config.AddExtensionOption("ducksync_file_retention",
+	                          "How long unreferenced data files are kept by ducksync_cleanup for caches without their "
+	                          "own file_retention",
+	                          LogicalType::VARCHAR, Value(DEFAULT_FILE_RETENTION), ValidateFileRetentionSetting,
+	                          SetScope::GLOBAL);
+	config.AddExtensionOption("ducksync_maintenance_every_n_refreshes",
+	                          "Run ducksync_cleanup in the background after this many refreshes that wrote new data; "
+	                          "0 disables background maintenance",
+	                          LogicalType::BIGINT, Value::BIGINT(0), ValidateMaintenanceInterval, SetScope::GLOBAL);
+	config.AddExtensionOption("ducksync_compaction_min_files",
+	                          "Merge a cache table's data files after a refresh once it has at least this many; "
+	                          "0 disables small-file compaction",
+	                          LogicalType::BIGINT, Value::BIGINT(DEFAULT_COMPACTION_MIN_FILES));
+	config.AddExtensionOption("ducksync_compaction_min_avg_file_size",
+	                          "Small-file compaction only runs while the average data file is below this size",
+	                          LogicalType::VARCHAR, Value(DEFAULT_COMPACTION_MIN_AVG_FILE_SIZE),
+	                          ValidateCompactionMinAvgFileSize);
+	config.AddExtensionOption("ducksync_memory_tier_budget",
+	                          "Memory shared by the in-memory copies of caches; loading past it evicts the least-read "
+	                          "copies",
+	                          LogicalType::VARCHAR, Value(DEFAULT_MEMORY_TIER_BUDGET), ValidateMemoryTierBudget);
+	config.AddExtensionOption("ducksync_memory_tier_auto_hits",
+	                          "Also hold a cache in memory once it has been read this many times; 0 keeps only caches "
+	                          "created with memory_tier := true",
+	                          LogicalType::BIGINT, Value::BIGINT(DEFAULT_MEMORY_TIER_AUTO_HITS));
+	config.AddExtensionOption("ducksync_local_mirror_path",
+	                          "Node-local directory mirroring the remote Parquet files of cache tables; empty disables "
+	                          "the mirror",
+	                          LogicalType::VARCHAR, Value(""));
+	config.AddExtensionOption("ducksync_local_mirror_size",
+	                          "Disk space of the local mirror; beyond it the least recently read files are deleted",
+	                          LogicalType::VARCHAR, Value(DEFAULT_LOCAL_MIRROR_SIZE), ValidateLocalMirrorSize);
+	config.AddExtensionOption("ducksync_storage_budget",
+	                          "Disk space for the data of all caches, e.g. '500GB'; refreshes past it evict the least "
+	                          "valuable caches until the next read. Empty disables the budget",
+	                          LogicalType::VARCHAR, Value(""), ValidateStorageBudget);
+	config.AddExtensionOption("ducksync_trace",
+	                          "Record spans of ducksync_query calls, replacement scans and refreshes for "
+	                          "ducksync_traces(); SET GLOBAL also traces scheduler refreshes",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+	config.AddExtensionOption("ducksync_trace_file",
+	                          "Also append each traced span to this file as a JSON line; empty keeps spans in memory "
+	                          "only",
+	                          LogicalType::VARCHAR, Value(""));
+	config.AddExtensionOption("ducksync_install_snowflake",
+	                          "Install and load the snowflake extension when DuckSync is initialized; turn off to run "
+	                          "against a local DuckLake catalog without a warehouse",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(true));
+	config.AddExtensionOption("ducksync_source_function",
+	                          "Table function that runs warehouse SQL for refreshes, invalidation probes and "
+	                          "passthrough queries; 'ducksync_emulated_query' answers from attached DuckDB databases",
+	                          LogicalType::VARCHAR, Value(DEFAULT_SOURCE_FUNCTION));
+
+	// Register replacement_scan hook
 	QueryRouter::Register(db);
 }
 
@@ -1,39 +1,97 @@
 #pragma once
 
 #include "duckdb.hpp"
+#include "metadata_manager.hpp"
 #include "storage_manager.hpp"
+#include "usage_stats.hpp"
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
 namespace duckdb {
 
+// Defaults for the ducksync_snapshot_retention / ducksync_file_retention settings
+static constexpr const char *DEFAULT_SNAPSHOT_RETENTION = "1 day";
+static constexpr const char *DEFAULT_FILE_RETENTION = "7 days";
+
 // Result of a cleanup operation
 struct CleanupResult {
-	int64_t snapshots_expired;
-	int64_t files_cleaned;
-	int64_t orphans_deleted;
+	int64_t snapshots_expired = 0;
+	int64_t files_cleaned = 0;
+	int64_t orphans_deleted = 0;
+	int64_t bytes_reclaimed = 0; // size of the deleted data files, where they could still be listed
+	std::string snapshot_retention;
+	std::string file_retention;
 	std::string message;
 };
 
-// Manages DuckLake cleanup operations
+// Manages DuckLake cleanup operations.
+// DuckLake snapshots and the files they reference are shared by every table of the catalog, so
+// maintenance is catalog-wide: it keeps history for the longest retention any cache asks for.
 class CleanupManager {
 public:
-	explicit CleanupManager(ClientContext &context, DuckSyncStorageManager &storage_manager);
+	CleanupManager(ClientContext &context, DuckSyncMetadataManager &metadata_manager,
+	               DuckSyncStorageManager &storage_manager);
 	~CleanupManager();
 
-	// Run cleanup for a specific cache
-	CleanupResult CleanupCache(const std::string &cache_name, const std::string &source_name);
+	// Run cleanup on behalf of one cache (which must exist). DuckLake maintenance is catalog-wide, so this is
+	// CleanupAll: per-cache retentions only ever lengthen the retention applied to every cache.
+	CleanupResult CleanupCache(const std::string &cache_name);
 
 	// Run cleanup for all caches
 	CleanupResult CleanupAll();
 
-	// Individual cleanup operations
-	int64_t ExpireSnapshots(const std::string &cache_name, const std::string &source_name);
-	int64_t CleanupOldFiles(const std::string &cache_name, const std::string &source_name, int64_t older_than_days = 7);
-	int64_t DeleteOrphanedFiles(const std::string &cache_name, const std::string &source_name);
+	// Individual cleanup operations; older_than is interval text such as '7 days'
+	int64_t ExpireSnapshots(const std::string &older_than);
+	int64_t CleanupOldFiles(const std::string &older_than, int64_t &bytes_reclaimed);
+	int64_t DeleteOrphanedFiles(const std::string &older_than, int64_t &bytes_reclaimed);
+
+	// Longest retention among the caches, each falling back to the ducksync_*_retention setting
+	std::string EffectiveSnapshotRetention();
+	std::string EffectiveFileRetention();
 
 private:
 	ClientContext &context_;
+	DuckSyncMetadataManager &metadata_manager_;
 	DuckSyncStorageManager &storage_manager_;
+
+	static constexpr idx_t SIZE_PROBE_BATCH = 512;
+
+	std::string GetRetentionSetting(const std::string &setting, const std::string &default_value);
+	// Total size of the files a maintenance call would delete, from its dry_run listing
+	int64_t MeasureFiles(Connection &conn, const std::string &dry_run_sql);
+};
+
+// Runs CleanupAll on a background thread after every N refreshes
+// (ducksync_maintenance_every_n_refreshes; 0 disables it). With usage_stats, the same thread also
+// flushes the read counts every UsageStats::FLUSH_SECONDS, so no read pays for the SQL.
+class MaintenanceWorker {
+public:
+	MaintenanceWorker(DatabaseInstance &db, DuckSyncMetadataManager &metadata_manager,
+	                  DuckSyncStorageManager &storage_manager, UsageStats *usage_stats = nullptr);
+	~MaintenanceWorker();
+
+	// Count one refresh that wrote new data. Without usage_stats the thread is started on the first due run.
+	void NotifyRefresh(idx_t every_n_refreshes);
+	// Stop the thread, then flush the read counts it has not flushed yet. Returns false when called on
+	// the thread itself (the database closing as its run ends), which is detached rather than joined.
+	bool Stop();
+
+private:
+	weak_ptr<DatabaseInstance> db_; // pinned by each run only, so an idle worker does not keep it open
+	DuckSyncMetadataManager &metadata_manager_;
+	DuckSyncStorageManager &storage_manager_;
+	UsageStats *usage_stats_;
+
+	std::mutex lock_;
+	std::condition_variable cv_;
+	std::thread thread_;
+	idx_t refreshes_since_cleanup_ = 0;
+	bool pending_ = false;
+	bool stopping_ = false;
+
+	void Run();
 };
 
 } // namespace duckdb
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace duckdb {
+
+// Default for the ducksync_ingest_memory_budget setting
+static constexpr const char *DEFAULT_INGEST_MEMORY_BUDGET = "256MB";
+
+// Bounded hand-off between source queries and the DuckLake writer.
+// One producer thread per source query streams chunks into the channel, and the writer drains it
+// through the ducksync_ingest_scan() table function. Once max_in_flight_bytes of chunks are queued
+// the producers block, which stops pulling from the source, so memory held between fetch and write
+// stays bounded regardless of the size of the result.
+class IngestChannel {
+public:
+	explicit IngestChannel(idx_t max_in_flight_bytes);
+	~IngestChannel();
+
+	// Start the source queries, each on its own connection and producer thread. The queries must
+	// return the same columns (e.g. disjoint ranges of one query). Returns once the result schema is
+	// known; throws if a query fails to start.
+	void Start(DatabaseInstance &db, const vector<string> &source_sqls);
+
+	// Consumer side, safe to call from several threads: the next chunk, or nullptr once every
+	// producer is done. Rethrows the first producer failure.
+	unique_ptr<DataChunk> Pop();
+
+	// Wait for the producers to exit; rethrows a producer failure
+	void Finish();
+	// Abort the source queries and stop the producers
+	void Cancel();
+
+	idx_t ProducerCount() const {
+		return producers_.size();
+	}
+	const vector<LogicalType> &Types() const {
+		return types_;
+	}
+	const vector<string> &Names() const {
+		return names_;
+	}
+	double FetchMs() const {
+		return fetch_ms_;
+	}
+	idx_t PeakInFlightBytes() const {
+		return peak_in_flight_bytes_;
+	}
+	// Highest buffer manager usage seen while chunks moved through the channel, sampled as each chunk
+	// is fetched and as the writer takes it, so it covers the whole fetch and write
+	idx_t PeakBufferMemory() const {
+		return peak_buffer_memory_.load(std::memory_order_relaxed);
+	}
+
+private:
+	idx_t max_in_flight_bytes_;
+	optional_ptr<DatabaseInstance> db_;
+	vector<unique_ptr<Connection>> connections_;
+	vector<unique_ptr<QueryResult>> results_; // one per producer
+	vector<LogicalType> types_;
+	vector<string> names_;
+
+	std::mutex lock_;
+	std::condition_variable not_full_;
+	std::condition_variable not_empty_;
+	std::deque<unique_ptr<DataChunk>> chunks_;
+	idx_t in_flight_bytes_ = 0;
+	idx_t peak_in_flight_bytes_ = 0;
+	idx_t active_producers_ = 0;
+	bool cancelled_ = false;
+	std::string error_;
+	double fetch_ms_ = 0; // slowest producer's fetch time; read after Finish()
+	std::atomic<idx_t> peak_buffer_memory_ {0};
+	vector<std::thread> producers_;
+
+	void Produce(idx_t index);
+	void SampleBufferMemory();
+	void Push(unique_ptr<DataChunk> chunk);
+};
+
+// Byte budget from the ducksync_ingest_memory_budget setting
+idx_t GetIngestMemoryBudget(ClientContext &context);
+
+// Process-wide lookup from the id passed to ducksync_ingest_scan(id) to its channel
+class IngestChannelRegistry {
+public:
+	static idx_t Register(std::shared_ptr<IngestChannel> channel);
+	static std::shared_ptr<IngestChannel> Get(idx_t id);
+	static void Unregister(idx_t id);
+};
+
+} // namespace duckdb
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace duckdb {
+
+// Stages of the read paths timed by LatencyStats
+enum class LatencyStage : uint8_t {
+	QUERY_BIND,            // all of DuckSyncQueryBind
+	QUERY_PARSE,           // extracting the table references
+	QUERY_LOOKUP,          // matching tables to caches and reading their state
+	QUERY_REFRESH_WAIT,    // refreshes run before routing; only binds that refreshed are recorded
+	QUERY_PREPARE,         // routing to local copies, rewriting and preparing the query
+	CACHE_HIT_EXECUTION,   // running a query routed to caches
+	PASSTHROUGH_EXECUTION, // running a query sent to the warehouse
+	SCAN_LOOKUP,           // DuckSyncReplacementScan, including rehydration of an evicted cache
+	COUNT
+};
+
+std::string LatencyStageToString(LatencyStage stage);
+
+struct LatencySummary {
+	uint64_t count = 0;
+	double p50_ms = 0;
+	double p90_ms = 0;
+	double p99_ms = 0;
+	double max_ms = 0;
+	double mean_ms = 0;
+};
+
+// Log-linear histogram of microsecond latencies in the style of HdrHistogram: values below
+// SUB_BUCKETS are exact, above that each power of two is split into SUB_BUCKETS buckets, so a
+// reported percentile is within 1/SUB_BUCKETS (6.25%) of the true value. Recording is a few
+// relaxed atomic increments.
+class LatencyHistogram {
+public:
+	LatencyHistogram();
+
+	void Record(uint64_t micros);
+	LatencySummary Summarize() const;
+	void Reset();
+
+private:
+	static constexpr idx_t SUB_BUCKET_BITS = 4;
+	static constexpr idx_t SUB_BUCKETS = idx_t(1) << SUB_BUCKET_BITS;
+	static constexpr idx_t BUCKET_COUNT = 64 * SUB_BUCKETS;
+
+	std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts_;
+	std::atomic<uint64_t> total_micros_;
+	std::atomic<uint64_t> max_micros_;
+
+	static idx_t BucketIndex(uint64_t micros);
+	// Highest value that falls into the bucket
+	static uint64_t BucketUpperBound(idx_t index);
+};
+
+// One histogram per LatencyStage, shared by every query of the database
+class LatencyStats {
+public:
+	void Record(LatencyStage stage, uint64_t micros) {
+		histograms_[static_cast<idx_t>(stage)].Record(micros);
+	}
+	LatencySummary Summarize(LatencyStage stage) const {
+		return histograms_[static_cast<idx_t>(stage)].Summarize();
+	}
+	void Reset();
+
+private:
+	std::array<LatencyHistogram, static_cast<idx_t>(LatencyStage::COUNT)> histograms_;
+};
+
+// Records the time from construction to Stop() or destruction into a stage; a no-op without stats
+class ScopedLatency {
+public:
+	ScopedLatency(LatencyStats *stats, LatencyStage stage)
+	    : stats_(stats), stage_(stage), start_(std::chrono::steady_clock::now()) {
+	}
+	~ScopedLatency() {
+		Stop();
+	}
+
+	void Stop() {
+		if (stats_) {
+			auto elapsed = std::chrono::steady_clock::now() - start_;
+			stats_->Record(stage_, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+			stats_ = nullptr;
+		}
+	}
+
+private:
+	LatencyStats *stats_;
+	LatencyStage stage_;
+	std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace duckdb
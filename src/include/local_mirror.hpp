@@ -0,0 +1,167 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "metadata_manager.hpp"
+#include "memory_tier.hpp"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace duckdb {
+
+// In-memory database holding one view per mirrored cache, over its local file copies
+static constexpr const char *LOCAL_MIRROR_CATALOG = "ducksync_mirror";
+
+// Default for the ducksync_local_mirror_size setting
+static constexpr const char *DEFAULT_LOCAL_MIRROR_SIZE = "10GB";
+
+struct LocalMirrorPolicy {
+	std::string path; // ducksync_local_mirror_path; empty disables the mirror
+	idx_t capacity_bytes = 0;
+
+	bool Enabled() const {
+		return !path.empty();
+	}
+};
+
+LocalMirrorPolicy GetLocalMirrorPolicy(ClientContext &context);
+
+enum class MirrorPopulate {
+	MIRRORED,
+	NOT_MIRRORABLE, // local data_path, or files with deletes or encryption
+	OVER_BUDGET,    // the cache alone is larger than ducksync_local_mirror_size
+	IN_PROGRESS     // another refresh or read is mirroring the cache
+};
+
+struct LocalMirrorStats {
+	std::string path;
+	idx_t capacity_bytes = 0;
+	idx_t used_bytes = 0;
+	idx_t files = 0;
+	int64_t hits = 0;   // reads served from local files
+	int64_t misses = 0; // reads while the mirror did not hold the cache's latest refresh
+	int64_t bytes_saved = 0;
+};
+
+// Mirrored files being read by running queries. Shared with the queries, which release their files when
+// they end, so a file evicted while it is read is deleted by its last reader instead of under it.
+struct MirrorFileReaders {
+	std::mutex lock;
+	std::unordered_map<std::string, idx_t> counts;
+	std::unordered_set<std::string> retired; // evicted while being read
+
+	void Pin(const std::vector<std::string> &files);
+	void Release(FileSystem &fs, const std::vector<std::string> &files);
+	// Delete an evicted file now, or leave it to its last reader
+	void Retire(FileSystem &fs, const std::string &path);
+	// Mirrored again before its last reader finished, so it must stay
+	void Revive(const std::string &path);
+};
+
+// Node-local copies of the remote Parquet files backing cache tables.
+// DuckLake data files are immutable, so a local copy is keyed by the remote file path and stays valid
+// for as long as it exists. Per cache, the mirror records the file set of one refresh (the manifest);
+// reads are routed to a view over the local copies only while that is still the cache's last refresh,
+// so an older version is never served. The copies share one disk budget and are evicted least
+// recently read first; evicting a file retires every manifest that contains it. Files stay on disk
+// until the queries routed to them have ended.
+class LocalMirror {
+public:
+	explicit LocalMirror(DatabaseInstance &db);
+	~LocalMirror();
+
+	// Route a read of this refresh of the cache to its local copies, which stay on disk until the
+	// context's query ends. Returns false, counting a miss, when the read has to go to DuckLake; on a
+	// miss the files are mirrored in the background, for later reads.
+	bool Resolve(ClientContext &context, const CacheDefinition &cache, const std::string &ducklake_name,
+	             const std::string &last_refresh, const LocalMirrorPolicy &policy, HotTableRef &out);
+	// Whether the mirror holds this refresh of the cache, without counting, touching or mirroring anything
+	bool Peek(const std::string &cache_name, const std::string &last_refresh, HotTableRef &out);
+
+	// Whether the cache's files for this refresh still need to be mirrored
+	bool NeedsPopulate(const std::string &cache_name, const std::string &last_refresh, const LocalMirrorPolicy &policy);
+
+	// Queue the download of this refresh's files for the background thread; a newer refresh of the
+	// same cache replaces a queued one. Used after refreshes and on read misses.
+	void SchedulePopulate(const CacheDefinition &cache, const std::string &ducklake_name,
+	                      const std::string &last_refresh, const LocalMirrorPolicy &policy);
+
+	// Download the cache table's data files as of last_refresh, then evict down to the budget.
+	// last_refresh must be read before the files are listed.
+	MirrorPopulate Populate(const CacheDefinition &cache, const std::string &ducklake_name,
+	                        const std::string &last_refresh, const LocalMirrorPolicy &policy);
+
+	LocalMirrorStats GetStats(const LocalMirrorPolicy &policy);
+
+	// Finish the background download in progress and drop the queued ones. Returns false when called on
+	// the background thread (the database closing as its download ends), which is detached rather than joined.
+	bool Stop();
+
+private:
+	struct MirroredFile {
+		idx_t bytes = 0;
+		idx_t last_read = 0; // access_clock_ value of the last read or download
+	};
+
+	struct Manifest {
+		std::string source_name;
+		std::string last_refresh; // refresh the file set belongs to; empty = not mirrored
+		std::vector<std::string> local_files;
+		idx_t bytes = 0;
+		std::string declined_refresh; // refresh that could not be mirrored; not retried
+		bool populating = false;
+	};
+
+	// A download waiting for the background thread
+	struct PendingPopulate {
+		CacheDefinition cache;
+		std::string ducklake_name;
+		std::string last_refresh;
+		LocalMirrorPolicy policy;
+	};
+
+	weak_ptr<DatabaseInstance> db_; // pinned by each download only, so an idle mirror does not keep it open
+	std::mutex lock_;
+	std::string indexed_path_; // mirror directory files_ was built from
+	std::unordered_map<std::string, MirroredFile> files_;
+	std::unordered_map<std::string, Manifest> manifests_;
+	std::unordered_set<std::string> downloading_; // temporary files of copies in progress
+	std::shared_ptr<MirrorFileReaders> readers_;
+	idx_t access_clock_ = 0;
+	int64_t hits_ = 0;
+	int64_t misses_ = 0;
+	int64_t bytes_saved_ = 0;
+
+	// Background mirroring after refreshes and read misses, one per cache, latest refresh wins
+	std::condition_variable cv_;
+	std::thread thread_;
+	std::unordered_map<std::string, PendingPopulate> pending_;
+	bool stopping_ = false;
+
+	static constexpr idx_t COPY_BUFFER_SIZE = 8 * 1024 * 1024;
+
+	// Counts the read and holds its files until the context's query ends
+	bool LookupCurrent(ClientContext &context, const std::string &cache_name, const std::string &last_refresh,
+	                   HotTableRef &out);
+	void Run();
+	// The cache table's data files with their sizes; anything but MIRRORED means leave it to DuckLake
+	static MirrorPopulate ListRemoteFiles(Connection &conn, const CacheDefinition &cache,
+	                                      const std::string &ducklake_name, idx_t capacity_bytes,
+	                                      std::vector<std::pair<std::string, idx_t>> &out);
+	// Register the files already in the mirror directory, once per directory
+	void EnsureIndexed(ClientContext &context, const std::string &path);
+	static std::string LocalFileName(FileSystem &fs, const std::string &mirror_path, const std::string &remote_path);
+	void CopyFile(FileSystem &fs, const std::string &remote_path, const std::string &local_path);
+	void CreateView(Connection &conn, const std::string &source_name, const std::string &cache_name,
+	                const std::vector<std::string> &local_files);
+	// Files to delete so the mirror fits capacity_bytes, never those of keep's manifest
+	std::vector<std::string> PickEvictions(const std::string &keep, idx_t capacity_bytes);
+};
+
+} // namespace duckdb
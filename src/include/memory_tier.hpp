@@ -0,0 +1,90 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "metadata_manager.hpp"
+#include "usage_stats.hpp"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace duckdb {
+
+// In-memory database that holds the hot copies, attached next to the DuckLake catalog
+static constexpr const char *MEMORY_TIER_CATALOG = "ducksync_hot";
+
+// Defaults for the ducksync_memory_tier_* settings
+static constexpr const char *DEFAULT_MEMORY_TIER_BUDGET = "1GB";
+static constexpr int64_t DEFAULT_MEMORY_TIER_AUTO_HITS = 0;
+
+struct MemoryTierPolicy {
+	idx_t budget_bytes = 0;
+	// Reads after which a cache without memory_tier is also held in memory; 0 = pinned caches only
+	int64_t auto_hits = DEFAULT_MEMORY_TIER_AUTO_HITS;
+};
+
+MemoryTierPolicy GetMemoryTierPolicy(ClientContext &context);
+
+enum class MemoryTierLoad {
+	LOADED,
+	OVER_BUDGET, // the cache alone is larger than ducksync_memory_tier_budget
+	IN_PROGRESS  // another refresh is loading the cache
+};
+
+// Table a query is routed to when the cache's hot copy is current
+struct HotTableRef {
+	std::string catalog;
+	std::string schema;
+	std::string table;
+};
+
+// Pinned copies of caches as in-memory DuckDB tables (ducksync_hot.<source>.<cache>).
+// A copy is loaded after a refresh of a cache that is pinned (memory_tier := true) or read at least
+// auto_hits times, and is tagged with the refresh it was copied from: routing only uses it while
+// that is still the cache's last refresh, so a stale copy falls back to DuckLake. The copies share
+// one memory budget; loading past it evicts the least-read copies, pinned caches last. Reads are
+// this node's UsageStats counts.
+class MemoryTier {
+public:
+	MemoryTier(DatabaseInstance &db, UsageStats *usage_stats);
+	~MemoryTier();
+
+	// The hot copy to scan, if one exists for exactly this refresh of the cache
+	bool Lookup(const std::string &cache_name, const std::string &last_refresh, HotTableRef &out);
+
+	// Whether the cache should be held in memory and its copy is not of this refresh
+	bool NeedsLoad(const CacheDefinition &cache, const std::string &last_refresh, const MemoryTierPolicy &policy);
+
+	// Copy the DuckLake table into memory as of last_refresh, then evict others down to the budget.
+	// last_refresh must be read before the copy, so that a concurrent refresh only makes it stale.
+	// bytes is the size of the table's DuckLake data files, which stands for the size of the copy.
+	MemoryTierLoad Load(const CacheDefinition &cache, const std::string &ducklake_table,
+	                    const std::string &last_refresh, const MemoryTierPolicy &policy, idx_t bytes);
+
+private:
+	struct HotCache {
+		std::string source_name;
+		std::string last_refresh; // refresh the copy was taken from; empty = no copy
+		idx_t bytes = 0;
+		std::string over_budget_refresh; // refresh found too large for the budget; not retried
+		bool pinned = false;
+		bool loading = false; // being copied or dropped
+	};
+
+	DatabaseInstance &db_;
+	UsageStats *usage_stats_;
+	std::mutex lock_;
+	std::unordered_map<std::string, HotCache> caches_;
+	bool attached_ = false;
+
+	Connection MakeConnection();
+	void EnsureAttached(Connection &conn);
+	static std::string HotTableName(const std::string &source_name, const std::string &cache_name);
+	void LocalReads(const std::string &cache_name, int64_t &reads, int64_t &last_read_us);
+	// Copies to drop so that used + the copy of keep fit the budget; least-read unpinned first
+	std::vector<std::string> PickVictims(const std::string &keep, idx_t budget_bytes);
+	static void DropCopy(Connection &conn, const std::string &source_name, const std::string &cache_name);
+};
+
+} // namespace duckdb
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "duckdb.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -25,6 +28,25 @@ struct CacheDefinition {
 	std::string invalidation_mode = "last_altered";
 	std::string metadata_secret_name;
 	std::string created_at;
+	// Parallel extraction: the source query is split into disjoint ranges of split_column.
+	// parallelism = 0 picks the stream count from the source size.
+	std::string split_column;
+	int64_t parallelism = 0;
+	// DuckLake maintenance retention (interval text); empty = the ducksync_*_retention setting
+	std::string snapshot_retention;
+	std::string file_retention;
+	// Write layout: ORDER BY list for the refresh insert and Parquet options for the cache table.
+	// Empty / 0 keep the DuckLake defaults (target_file_size falls back to the ingest setting).
+	std::string sort_by;
+	int64_t row_group_size = 0;
+	std::string target_file_size;
+	std::string compression;
+	// Columns that get Parquet Bloom filters for equality lookups
+	std::vector<std::string> bloom_filter_columns;
+	// DuckLake partition keys of the cache table, e.g. region or year(event_date)
+	std::vector<std::string> partition_by;
+	// Keep an in-memory copy of the cache for low-latency reads
+	bool memory_tier = false;
 };
 
 struct CacheState {
@@ -32,6 +54,7 @@ struct CacheState {
 	std::string last_refresh;
 	std::string source_state_hash;
 	std::string expires_at;
+	int64_t refresh_count = 0;
 
 	bool HasLastRefresh() const {
 		return !last_refresh.empty();
@@ -42,6 +65,10 @@ struct CacheState {
 	bool HasExpiresAt() const {
 		return !expires_at.empty();
 	}
+	// Refreshed before, but its data was dropped to stay within the storage budget
+	bool IsEvicted() const {
+		return !HasLastRefresh() && refresh_count > 0;
+	}
 };
 
 struct TableSnapshot {
@@ -49,11 +76,55 @@ struct TableSnapshot {
 	int64_t bytes;
 };
 
+// One row of refresh_history: a single refresh call with its decision and per-phase cost
+struct RefreshHistoryEntry {
+	std::string cache_name;
+	std::string started_at;
+	std::string trigger;
+	std::string decision;
+	std::string result;
+	std::string message;
+	double total_ms = 0;
+	double probe_ms = 0;
+	double fetch_ms = 0;
+	double write_ms = 0;
+	double commit_ms = 0;
+	double state_ms = 0;
+	int64_t rows = 0;
+	int64_t bytes_written = 0;
+	int64_t files_created = 0;
+	int64_t peak_memory_bytes = 0;
+};
+
+// One row of usage_stats: counts one node recorded for a cache (or, with cache_name empty, for a
+// source's passthroughs) between two flushes
+struct UsageStatsEntry {
+	std::string cache_name;
+	std::string source_name;
+	int64_t scan_hits = 0;
+	int64_t query_hits = 0;
+	int64_t passthrough_misses = 0;
+	int64_t rows_served = 0;
+	int64_t bytes_avoided = 0;
+};
+
+// Reads of one cache across all nodes, as flushed to usage_stats
+struct CacheReads {
+	int64_t reads = 0;
+	bool has_last_read = false;
+	timestamp_t last_read; // the last flush that carried a read of the cache
+	double hours_idle = 0; // since the last read or, for a cache never read, since its last refresh
+};
+
 // Manages DuckSync metadata stored in the DuckLake catalog (PostgreSQL)
-// All queries run through the attached DuckLake connection
+// All queries run through the attached DuckLake connection.
+// sources, caches, state and table_snapshots are append-only: a write adds a row with a newer
+// version (deleted = true hides the key) and readers take the latest version per key, so an
+// update is one INSERT instead of a DELETE+INSERT pair. CompactMetadata drops superseded rows.
 class DuckSyncMetadataManager {
 public:
-	explicit DuckSyncMetadataManager(ClientContext &context);
+	explicit DuckSyncMetadataManager(DatabaseInstance &db);
+	~DuckSyncMetadataManager();
 
 	// Initialize schema in the DuckLake catalog schema_name defaults to "ducksync" for backward compatibility.
 	void Initialize(const std::string &ducklake_name, const std::string &schema_name = "ducksync");
@@ -64,7 +135,8 @@ public:
 	std::vector<SourceDefinition> ListSources();
 	void DeleteSource(const std::string &source_name);
 
-	// Cache CRUD
+	// Cache CRUD. Creating and deleting a cache each take one metadata commit, covering its definition,
+	// state and snapshot set.
 	void CreateCache(const CacheDefinition &cache);
 	bool GetCache(const std::string &cache_name, CacheDefinition &out);
 	bool GetCacheByMonitorTable(const std::string &table_name, CacheDefinition &out);
@@ -75,23 +147,90 @@ public:
 	std::string GetDuckLakeName() const {
 		return ducklake_name_;
 	}
+	std::string GetSchemaName() const {
+		return schema_name_;
+	}
 
 	// State operations
-	void InitializeState(const std::string &cache_name);
-	void UpdateState(const CacheState &state);
+	// Appends a new state version. With snapshots, the cache's snapshot set is replaced in the same
+	// transaction, so a refresh records everything in one DuckLake commit.
+	void UpdateState(const CacheState &state,
+	                 const std::unordered_map<std::string, TableSnapshot> *snapshots = nullptr);
 	bool GetState(const std::string &cache_name, CacheState &out);
-	void SaveTableSnapshot(const std::string &cache_name, const std::string &source_table, int64_t source_rows,
-	                       int64_t source_bytes);
+	// Replaces the cache's whole snapshot set
+	void SaveTableSnapshots(const std::string &cache_name,
+	                        const std::unordered_map<std::string, TableSnapshot> &snapshots);
 	std::unordered_map<std::string, TableSnapshot> GetTableSnapshot(const std::string &cache_name);
-	void DeleteTableSnapshots(const std::string &cache_name);
+	// Appends a state version without last_refresh (refresh_count unchanged) and drops the snapshot
+	// set, in one commit; see CacheState::IsEvicted
+	void MarkEvicted(const std::string &cache_name);
+
+	// Metadata commits made so far by the calling thread (for per-refresh accounting)
+	static idx_t ThreadCommitCount();
+	// Metadata lookups (sources, caches, state, snapshots, lease holders) made so far by the calling thread
+	static idx_t ThreadReadCount();
+
+	// Remove superseded versions and tombstones, roll usage_stats up per day and apply the refresh_history
+	// retention; runs automatically every COMPACT_EVERY_N_WRITES state updates
+	void CompactMetadata();
+
+	// Cross-node refresh leases: one live row per cache marks the node currently refreshing it.
+	// Returns true when owner_id holds the lease; otherwise holder is set to the current owner.
+	bool TryAcquireRefreshLease(const std::string &cache_name, const std::string &owner_id, int64_t lease_seconds,
+	                            std::string &holder);
+	// Extend a held lease by another lease_seconds; returns false when owner_id no longer holds it
+	bool RenewRefreshLease(const std::string &cache_name, const std::string &owner_id, int64_t lease_seconds);
+	bool GetRefreshLeaseHolder(const std::string &cache_name, std::string &holder);
+	void ReleaseRefreshLease(const std::string &cache_name, const std::string &owner_id);
+
+	// Refresh history is buffered and appended in batches so that hot refresh loops
+	// do not pay a catalog commit per call. Safe to call from scheduler workers.
+	void AppendRefreshHistory(const RefreshHistoryEntry &entry);
+	void FlushRefreshHistory();
+	// Per-cache p50/p95 summary; cache_name empty = all caches
+	unique_ptr<MaterializedQueryResult> SummarizeRefreshHistory(const std::string &cache_name);
+
+	// Usage counters are appended as per-flush deltas and summed on read
+	void AppendUsageStats(const std::vector<UsageStatsEntry> &entries);
+	// Totals per (cache_name, source_name); passthrough rows have a NULL cache_name
+	unique_ptr<MaterializedQueryResult> SummarizeUsageStats();
+	// Reads per cache with state, for ranking caches by use
+	std::unordered_map<std::string, CacheReads> GetCacheReads();
 
 private:
-	ClientContext &context_;
+	DatabaseInstance &db_;
 	std::string ducklake_name_; // e.g., "my_lake" - the attached DuckLake
 	std::string schema_name_;   // e.g., "ducksync" (default) - metadata schema within the catalog
 	bool initialized_;
 
+	static constexpr idx_t HISTORY_BATCH_SIZE = 32;
+	static constexpr int64_t HISTORY_FLUSH_SECONDS = 30;
+	std::mutex history_lock_;
+	std::vector<RefreshHistoryEntry> pending_history_;
+	std::chrono::steady_clock::time_point oldest_pending_;
+
+	static constexpr idx_t COMPACT_EVERY_N_WRITES = 256;
+	std::atomic<idx_t> writes_since_compaction_ {0};
+	// refresh_history keeps this many days, and beyond that the latest HISTORY_KEEP_PER_CACHE rows per cache
+	static constexpr int64_t HISTORY_RETENTION_DAYS = 30;
+	static constexpr int64_t HISTORY_KEEP_PER_CACHE = 100;
+
+	void FlushRefreshHistoryLocked();
 	void ExecuteSQL(const std::string &sql);
+	void AddColumnIfMissing(const std::string &table, const std::string &column, const std::string &type);
+	// Subquery of the latest, non-deleted version of each key of a versioned table
+	std::string CurrentRowsSQL(const std::string &table, const std::string &key) const;
+	// Version for a new row of key $key_param: the writer's clock ($clock_param), raised above the
+	// newest version of the key already visible
+	std::string VersionSQL(const std::string &table, const std::string &key, idx_t key_param, idx_t clock_param) const;
+	void AppendTombstone(Connection &conn, const std::string &table, const std::string &key,
+	                     const std::string &value);
+	void AppendLeaseClaim(const std::string &cache_name, const std::string &owner_id, int64_t lease_seconds);
+	void AppendState(Connection &conn, const CacheState &state, bool counts_refresh = true);
+	// First state version of a new cache; a cache re-created under the same name keeps its state
+	void AppendInitialState(Connection &conn, const std::string &cache_name);
+	void AppendSnapshotSet(Connection &conn, const std::string &cache_name,
+	                       const std::unordered_map<std::string, TableSnapshot> &snapshots);
 	unique_ptr<MaterializedQueryResult> QuerySQL(const std::string &sql);
 
 	// Full table name: ducklake_name.ducksync.table_name
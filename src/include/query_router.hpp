@@ -3,26 +3,123 @@
 #include "duckdb.hpp"
 #include "metadata_manager.hpp"
 #include "storage_manager.hpp"
+#include "refresh_scheduler.hpp"
+#include "cleanup_manager.hpp"
+#include "memory_tier.hpp"
+#include "local_mirror.hpp"
+#include "storage_budget.hpp"
+#include "usage_stats.hpp"
+#include "latency_stats.hpp"
+#include <cstdint>
 #include <memory>
+#include <shared_mutex>
 #include <string>
 
 namespace duckdb {
 
-struct DuckSyncState : public ClientContextState {
-	std::unique_ptr<DuckSyncMetadataManager> metadata_manager;
-	std::unique_ptr<DuckSyncStorageManager> storage_manager;
+// A shared or exclusive hold of a DuckSyncState, released on destruction or unlock(). Holds are
+// re-entrant per thread: a thread that already holds the state (e.g. a replacement scan inside the
+// query of a DuckSync function) gets a lock that owns nothing, as locking a std::shared_mutex twice
+// from one thread is undefined behavior.
+class DuckSyncStateLock {
+public:
+	enum class Mode : uint8_t { SHARED, EXCLUSIVE, ROUTING };
+
+	// An exclusive lock inside a shared hold of the same thread throws: it cannot be upgraded.
+	// ROUTING waits like SHARED, but does not hold while this thread has the state exclusively.
+	DuckSyncStateLock(std::shared_mutex &mutex, Mode mode);
+	~DuckSyncStateLock();
+	DuckSyncStateLock(DuckSyncStateLock &&other) noexcept;
+	DuckSyncStateLock &operator=(DuckSyncStateLock &&other) noexcept;
+	DuckSyncStateLock(const DuckSyncStateLock &) = delete;
+	DuckSyncStateLock &operator=(const DuckSyncStateLock &) = delete;
+
+	// Whether the thread holds the state, through this lock or an enclosing one
+	bool owns_lock() const {
+		return holds_;
+	}
+	// Release the hold; a no-op for a lock inside an enclosing hold
+	void unlock();
+
+private:
+	std::shared_mutex *mutex_;
+	bool owns_ = false;  // took the mutex, and releases it
+	bool holds_ = false; // owns_, or nested in an enclosing hold
+	bool exclusive_ = false;
+};
+
+// Owning copies of the state's managers, taken under ReadLock(). They stay valid after the lock is
+// released, so refreshes and cleanups run without blocking ducksync_init or the scheduler functions.
+// Members are destroyed in the same order as DuckSyncState's.
+struct DuckSyncManagers {
+	std::shared_ptr<DuckSyncMetadataManager> metadata_manager;
+	std::shared_ptr<DuckSyncStorageManager> storage_manager;
+	std::shared_ptr<UsageStats> usage_stats;
+	std::shared_ptr<MaintenanceWorker> maintenance;
+	std::shared_ptr<MemoryTier> memory_tier;
+	std::shared_ptr<LocalMirror> local_mirror;
+	std::shared_ptr<StorageBudget> storage_budget;
+};
+
+// DuckSync state of one database, shared by all of its connections (including Quack sessions), so a
+// single ducksync_init serves every connection. Table functions hold ReadLock() while they use the
+// managers; ducksync_init and ducksync_setup_storage hold WriteLock() while they replace them.
+struct DuckSyncState {
+	std::shared_ptr<DuckSyncMetadataManager> metadata_manager;
+	std::shared_ptr<DuckSyncStorageManager> storage_manager;
+	// Before the maintenance worker that flushes it and the memory tier that reads it
+	std::shared_ptr<UsageStats> usage_stats;
+	std::shared_ptr<MaintenanceWorker> maintenance;
+	std::shared_ptr<MemoryTier> memory_tier;
+	std::shared_ptr<LocalMirror> local_mirror;
+	std::shared_ptr<StorageBudget> storage_budget;
+	std::shared_ptr<LatencyStats> latency;
+	// Declared after the managers, maintenance worker, local copies and storage budget it references so
+	// it is stopped before they are destroyed
+	std::unique_ptr<RefreshScheduler> scheduler;
 	std::string postgres_connection_string;
 	bool initialized = false;
 
-	void QueryEnd() override {
+	DuckSyncStateLock ReadLock() {
+		return DuckSyncStateLock(lock, DuckSyncStateLock::Mode::SHARED);
+	}
+	DuckSyncStateLock WriteLock() {
+		return DuckSyncStateLock(lock, DuckSyncStateLock::Mode::EXCLUSIVE);
 	}
+	// Shared access for the replacement scan: waits for a ducksync_init on another connection, so a read
+	// is never silently left unrouted, but fails inside this thread's own ducksync_init, whose queries
+	// must not be routed while the managers are re-pointed.
+	DuckSyncStateLock RoutingLock() {
+		return DuckSyncStateLock(lock, DuckSyncStateLock::Mode::ROUTING);
+	}
+
+	// Call under ReadLock()
+	DuckSyncManagers Managers() const;
+
+	// Stop the scheduler, the local mirror and the maintenance worker, for the database closing. Returns
+	// false when called on one of their threads, which is detached rather than joined: the state must then
+	// outlive that thread.
+	bool StopBackground();
+
+private:
+	std::shared_mutex lock;
 };
 
+struct ReplacementScanInput;
+class TableRef;
+
 class QueryRouter {
 public:
 	static void Register(DatabaseInstance &db);
+	// The replacement scan: where a read of the table in input is routed, or nullptr when no cache
+	// monitors it. Public for the lookup benchmark.
+	static unique_ptr<TableRef> ResolveTable(ClientContext &context, ReplacementScanInput &input);
 };
 
+// The database's state, created on first use. It lives in the database's object cache, so it lasts as
+// long as the database and is destroyed with it, stopping its scheduler and background workers.
 DuckSyncState &GetDuckSyncState(ClientContext &context);
+// The database's state if a DuckSync function created it, without creating it
+std::shared_ptr<DuckSyncState> LookupDuckSyncState(DatabaseInstance &db);
 
 } // namespace duckdb
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "refresh_orchestrator.hpp"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace duckdb {
+
+// Process-wide single-flight for cache refreshes.
+// The first caller for a key becomes the leader and runs the refresh; concurrent callers for the
+// same key (other connections, Quack clients, scheduler workers) block until it finishes and
+// share its status instead of issuing the same warehouse query again.
+// Cross-node coordination is handled separately by the refresh lease in the metadata schema.
+class RefreshCoordinator {
+public:
+	static RefreshStatus RunSingleFlight(const std::string &key, const std::function<RefreshStatus()> &refresh);
+
+	// Unique owner id for one cross-node lease attempt: a random per-process prefix plus a sequence
+	static std::string NewLeaseOwner();
+};
+
+// Keeps a held cross-node refresh lease alive: a background thread renews it every third of the
+// lease period until the heartbeat is destroyed, so a refresh may outlast ducksync_refresh_lease_seconds.
+class RefreshLeaseHeartbeat {
+public:
+	RefreshLeaseHeartbeat(DuckSyncMetadataManager &metadata_manager, std::string cache_name, std::string owner_id,
+	                      int64_t lease_seconds);
+	~RefreshLeaseHeartbeat();
+
+private:
+	DuckSyncMetadataManager &metadata_manager_;
+	std::string cache_name_;
+	std::string owner_id_;
+	int64_t lease_seconds_;
+
+	std::mutex lock_;
+	std::condition_variable stop_cv_;
+	bool stopping_ = false;
+	std::thread thread_;
+
+	void Run();
+};
+
+} // namespace duckdb
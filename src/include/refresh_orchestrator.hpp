@@ -3,6 +3,11 @@
 #include "duckdb.hpp"
 #include "metadata_manager.hpp"
 #include "storage_manager.hpp"
+#include "cleanup_manager.hpp"
+#include "memory_tier.hpp"
+#include "local_mirror.hpp"
+#include "storage_budget.hpp"
+#include <chrono>
 #include <string>
 #include <memory>
 #include <unordered_map>
@@ -11,9 +16,35 @@ namespace duckdb {
 
 // Result of a refresh operation
 enum class RefreshResult {
-	SKIPPED,   // No refresh needed (data is fresh)
-	REFRESHED, // Data was refreshed
-	ERROR      // Error occurred during refresh
+	SKIPPED,    // No refresh needed (data is fresh)
+	REFRESHED,  // Data was refreshed
+	ERROR,      // Error occurred during refresh
+	LEASE_BUSY  // Another node holds the refresh lease; nothing was refreshed by this call
+};
+
+std::string RefreshResultToString(RefreshResult result);
+
+// Who asked for a refresh; recorded in refresh_history
+enum class RefreshTrigger {
+	MANUAL,   // ducksync_refresh()
+	QUERY,     // ducksync_query() refreshing expired caches before routing
+	SCHEDULER, // background RefreshScheduler
+	REHYDRATE  // a read of a cache evicted by the storage budget
+};
+
+std::string RefreshTriggerToString(RefreshTrigger trigger);
+
+// Per-phase cost of one refresh call. Phases that did not run stay at zero.
+struct RefreshMetrics {
+	double probe_ms = 0;  // Snowflake metadata probes (Stage 1 SHOW TABLES, Stage 2 last_altered)
+	double fetch_ms = 0;  // pulling chunks from the source query (overlaps write)
+	double write_ms = 0;  // staging table writes, the swap into the live table and any file compaction
+	double commit_ms = 0; // DuckLake commit of the swap
+	double state_ms = 0;  // state and snapshot bookkeeping
+	int64_t bytes_written = 0;
+	int64_t files_created = 0;
+	idx_t peak_memory_bytes = 0; // buffer manager usage, sampled per chunk during fetch and write and after the swap
+	int64_t metadata_commits = 0; // metadata catalog commits (leases, snapshots, state)
 };
 
 struct RefreshStatus {
@@ -23,12 +54,24 @@ struct RefreshStatus {
 	double duration_ms;
 	bool has_rows;
 	bool has_duration;
+	// Why the smart check refreshed or skipped, e.g. ttl_expired, source_changed, fresh
+	std::string decision;
+	RefreshMetrics metrics;
 
 	RefreshStatus()
 	    : result(RefreshResult::ERROR), rows_refreshed(0), duration_ms(0), has_rows(false), has_duration(false) {
 	}
 };
 
+// Default for the ducksync_refresh_lease_seconds setting; must exceed the longest expected refresh
+static constexpr int64_t DEFAULT_REFRESH_LEASE_SECONDS = 600;
+
+// Default for the ducksync_source_function setting: the table function that runs warehouse SQL
+static constexpr const char *DEFAULT_SOURCE_FUNCTION = "snowflake_query";
+
+// The ducksync_source_function table function, quoted for splicing into SQL
+std::string GetSourceFunction(ClientContext &context);
+
 struct RowsBytesSnapshot {
 	int64_t rows;
 	int64_t bytes;
@@ -37,22 +80,80 @@ struct RowsBytesSnapshot {
 // Orchestrates smart refresh logic for DuckSync
 class RefreshOrchestrator {
 public:
+	// maintenance, when given, is told about every refresh that wrote new data; memory_tier and
+	// local_mirror, when given, are brought up to the cache's latest refresh after each refresh;
+	// storage_budget, when given, evicts other caches when a refresh leaves the total over budget
 	RefreshOrchestrator(ClientContext &context, DuckSyncMetadataManager &metadata_manager,
-	                    DuckSyncStorageManager &storage_manager);
+	                    DuckSyncStorageManager &storage_manager, MaintenanceWorker *maintenance = nullptr,
+	                    MemoryTier *memory_tier = nullptr, LocalMirror *local_mirror = nullptr,
+	                    StorageBudget *storage_budget = nullptr);
 	~RefreshOrchestrator();
 
 	// Main refresh function
-	RefreshStatus Refresh(const std::string &cache_name, bool force = false);
+	RefreshStatus Refresh(const std::string &cache_name, bool force = false,
+	                      RefreshTrigger trigger = RefreshTrigger::MANUAL);
 
 private:
 	ClientContext &context_;
 	DuckSyncMetadataManager &metadata_manager_;
 	DuckSyncStorageManager &storage_manager_;
+	MaintenanceWorker *maintenance_;
+	MemoryTier *memory_tier_;
+	LocalMirror *local_mirror_;
+	StorageBudget *storage_budget_;
+	RefreshMetrics metrics_;      // accumulated by the phases of the refresh in progress
+	std::string split_fallback_;  // why a split_column refresh was fetched as one stream; empty otherwise
+	std::string source_function_; // ducksync_source_function, e.g. snowflake_query
+
+	// Followers waiting for a leader poll with exponential backoff between these bounds, for at most
+	// the lease duration: by then the leader has finished or its lease has lapsed
+	static constexpr int64_t LEASE_POLL_INTERVAL_MS = 500;
+	static constexpr int64_t MAX_LEASE_POLL_INTERVAL_MS = 8000;
+	// Automatic split_column parallelism: one stream per this many source rows, capped
+	static constexpr int64_t ROWS_PER_EXTRACT_STREAM = 2000000;
+	static constexpr idx_t MAX_AUTO_EXTRACT_STREAMS = 8;
+
+	// Smart check; runs as the single in-flight refresh for this cache within the process
+	RefreshStatus RefreshInternal(const std::string &cache_name, bool force);
+
+	// Take the cross-node refresh lease, then execute. When another node holds it, forced refreshes and
+	// caches with data return LEASE_BUSY (the current contents stay readable); an empty cache waits for
+	// the leader's result, up to the lease duration.
+	RefreshStatus RefreshUnderLease(const CacheDefinition &cache, const SourceDefinition &source,
+	                                const CacheState &observed_state, bool force, const std::string &decision,
+	                                std::chrono::high_resolution_clock::time_point start_time);
+
+	// Merge the fresh table's small files when the compaction policy says so; runs under the lease.
+	// Best effort: the refresh already committed, so a failure is only noted in the status message.
+	void CompactIfDue(const CacheDefinition &cache, RefreshStatus &status);
+
+	// Bring the memory tier copy and the local file mirror of the cache up to its latest refresh.
+	// Runs after refreshes and skips alike; best effort, noted in the status message.
+	void UpdateLocalCopies(const std::string &cache_name, RefreshStatus &status);
+
+	// Evict other caches until the total fits ducksync_storage_budget; best effort, like the above
+	void EnforceStorageBudget(const std::string &cache_name, RefreshStatus &status);
+
+	// Execute the source query and record the new state and snapshots
+	RefreshStatus ExecuteAndRecord(const CacheDefinition &cache, const SourceDefinition &source,
+	                               std::chrono::high_resolution_clock::time_point start_time);
+
+	int64_t GetLeaseSeconds();
+	std::string GetIngestTargetFileSize();
+	// DuckLake table options and partitioning from the cache's layout settings
+	TableLayout BuildTableLayout(const CacheDefinition &cache);
+	ParquetFileOptions BuildParquetFileOptions(const CacheDefinition &cache, const vector<string> &names,
+	                                           const vector<LogicalType> &types);
+	static void CheckBloomFilterColumns(const CacheDefinition &cache, const vector<string> &names);
+	idx_t GetMaintenanceInterval();
+	void SampleMemory();
+	void RecordHistory(const std::string &cache_name, RefreshTrigger trigger, const std::string &started_at,
+	                   double total_ms, const RefreshStatus &status);
 
 	// Check if TTL has expired
 	bool IsTTLExpired(const CacheState &state, const CacheDefinition &cache);
 
-	// Query Snowflake for table metadata
+	// Query the source for table metadata
 	std::unordered_map<std::string, std::string> GetSourceTableMetadata(const std::string &secret_name,
 	                                                                    const std::vector<std::string> &monitor_tables);
 
@@ -65,8 +166,14 @@ private:
 	// Execute source query and write to DuckLake
 	int64_t ExecuteRefresh(const CacheDefinition &cache, const SourceDefinition &source);
 
-	// Update cache state after refresh
-	void UpdateCacheState(const std::string &cache_name, const std::string &state_hash, const CacheDefinition &cache);
+	// Source function statements covering the source query: one, or one per disjoint range of the
+	// cache's split_column
+	vector<string> BuildSourceQueries(const CacheDefinition &cache, const SourceDefinition &source);
+	static idx_t AutoParallelism(int64_t source_rows);
+
+	// Update cache state after refresh, together with the Stage 1 snapshot set when given
+	void UpdateCacheState(const std::string &cache_name, const std::string &state_hash, const CacheDefinition &cache,
+	                      const std::unordered_map<std::string, TableSnapshot> *snapshots = nullptr);
 };
 
 } // namespace duckdb
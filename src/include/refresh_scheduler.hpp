@@ -0,0 +1,131 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "metadata_manager.hpp"
+#include "storage_manager.hpp"
+#include "cleanup_manager.hpp"
+#include "memory_tier.hpp"
+#include "local_mirror.hpp"
+#include "storage_budget.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace duckdb {
+
+struct RefreshSchedulerConfig {
+	idx_t worker_threads = 1;
+	// Caches without a TTL deadline (or with a long one) are probed at least this often
+	int64_t probe_interval_seconds = 300;
+	// Never run the same cache twice within this window
+	int64_t min_refresh_interval_seconds = 60;
+	// Fraction of each delay added at random so caches sharing a TTL do not expire together
+	double jitter = 0.1;
+	// How often the cache list is reloaded to pick up created/deleted caches
+	int64_t rescan_interval_seconds = 60;
+};
+
+// Snapshot of one scheduled cache, as reported by ducksync_scheduler_status()
+struct ScheduledCacheInfo {
+	std::string cache_name;
+	bool running = false;
+	double next_run_seconds = 0; // relative to now; negative when overdue
+	int64_t runs = 0;
+	std::string last_result;
+	std::string last_message;
+	double last_duration_ms = 0;
+	bool has_last_run = false;
+};
+
+// Opt-in background scheduler: keeps a min-heap of caches ordered by their next deadline
+// (TTL expiry or next freshness probe) and runs smart refreshes on worker threads.
+class RefreshScheduler {
+public:
+	RefreshScheduler(DatabaseInstance &db, DuckSyncMetadataManager &metadata_manager,
+	                 DuckSyncStorageManager &storage_manager, RefreshSchedulerConfig config,
+	                 MaintenanceWorker *maintenance = nullptr, MemoryTier *memory_tier = nullptr,
+	                 LocalMirror *local_mirror = nullptr, StorageBudget *storage_budget = nullptr);
+	~RefreshScheduler();
+
+	void Start();
+	// Returns false when called on a worker (the database closing as its run ends), which is detached
+	// rather than joined
+	bool Stop();
+
+	bool IsRunning() const {
+		return running_;
+	}
+	const RefreshSchedulerConfig &GetConfig() const {
+		return config_;
+	}
+
+	std::vector<ScheduledCacheInfo> GetStatus();
+
+private:
+	using SchedulerClock = std::chrono::steady_clock;
+
+	struct QueueEntry {
+		SchedulerClock::time_point due;
+		std::string cache_name;
+		uint64_t generation;
+
+		bool operator>(const QueueEntry &other) const {
+			return due > other.due;
+		}
+	};
+
+	struct CacheSchedule {
+		uint64_t generation = 0;
+		SchedulerClock::time_point due;
+		bool running = false;
+		bool has_last_run = false;
+		SchedulerClock::time_point last_run_start;
+		int64_t runs = 0;
+		std::string last_result;
+		std::string last_message;
+		double last_duration_ms = 0;
+	};
+
+	RefreshSchedulerConfig config_;
+	weak_ptr<DatabaseInstance> db_; // pinned by each run only, so idle workers do not keep it open
+	DuckSyncMetadataManager &metadata_manager_;
+	DuckSyncStorageManager &storage_manager_;
+	MaintenanceWorker *maintenance_;
+	MemoryTier *memory_tier_;
+	LocalMirror *local_mirror_;
+	StorageBudget *storage_budget_;
+
+	std::mutex lock_;
+	std::condition_variable cv_;
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue_;
+	std::unordered_map<std::string, CacheSchedule> schedules_;
+	std::vector<std::thread> workers_;
+	SchedulerClock::time_point next_rescan_;
+	bool stopping_ = false;
+	std::atomic<bool> running_ {false};
+	std::mt19937_64 rng_;
+
+	void WorkerLoop();
+	void Rescan(std::unique_lock<std::mutex> &lock);
+	void RunCache(std::unique_lock<std::mutex> &lock, const std::string &cache_name);
+
+	// Compute the next deadline for a cache from its definition and persisted state.
+	// Returns false when the cache should not be scheduled at all (manual, or ttl_only without a TTL).
+	bool ComputeNextDelay(const CacheDefinition &cache, double &delay_seconds);
+	double SecondsUntil(const std::string &timestamp);
+
+	// Must be called with lock_ held
+	void Enqueue(const std::string &cache_name, CacheSchedule &schedule, double delay_seconds);
+	double ApplyJitter(double delay_seconds);
+};
+
+} // namespace duckdb
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include <string>
+
+namespace duckdb {
+
+class ClientContext;
+
+// Offline stand-in for snowflake_query(), behind ducksync_emulated_query(). Warehouse databases are
+// DuckDB databases attached under the same names, so source queries run unchanged; the metadata
+// statements DuckSync sends for invalidation are answered from duckdb_tables():
+//   SHOW TABLES LIKE '<table>' IN SCHEMA <db>.<schema>   name, database_name, schema_name, kind, rows, bytes
+//   <db>.information_schema.tables                        table_catalog, table_schema, table_name,
+//                                                          last_altered, row_count, bytes
+// Names are reported upper-cased, as Snowflake folds unquoted identifiers. bytes is an estimate
+// (rows x columns x 8). last_altered is the time the emulator first saw the table's current row
+// count and definition, so inserts, deletes and DDL move it but an UPDATE that keeps the row count
+// does not.
+class SourceEmulator {
+public:
+	// Local DuckDB SQL answering a statement written for the warehouse
+	static std::string Translate(ClientContext &context, const std::string &sql);
+	// Statements translated since start-up: the warehouse round trips a real source would have served
+	static idx_t QueryCount();
+	// Forget the last_altered times seen so far
+	static void Reset();
+};
+
+} // namespace duckdb
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include "metadata_manager.hpp"
+#include "storage_manager.hpp"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace duckdb {
+
+struct StorageBudgetPolicy {
+	idx_t budget_bytes = 0; // ducksync_storage_budget; 0 = unlimited
+
+	bool Enabled() const {
+		return budget_bytes > 0;
+	}
+};
+
+StorageBudgetPolicy GetStorageBudgetPolicy(ClientContext &context);
+
+// Refresh cost assumed for a cache without refresh history
+static constexpr double DEFAULT_REFRESH_COST_MS = 1000;
+
+// One row of ducksync_storage()
+struct CacheStorageInfo {
+	std::string cache_name;
+	std::string source_name;
+	int64_t files = 0;
+	int64_t size_bytes = 0;     // every file DuckLake still holds for the cache
+	int64_t retained_bytes = 0; // the part from earlier refreshes or dropped versions, kept for retention
+	int64_t accesses = 0;
+	bool has_last_access = false;
+	timestamp_t last_access;
+	double refresh_ms = 0; // p50 of the cache's refreshes, or DEFAULT_REFRESH_COST_MS
+	double score = 0;      // value kept per byte of disk; the lowest is evicted first
+	bool evicted = false;
+};
+
+// Keeps the DuckLake data of all caches within one disk budget. Sizes count every file DuckLake still
+// holds for a cache, including those kept for the snapshot retention. When a refresh pushes the total
+// over ducksync_storage_budget, the caches that are cheapest to lose (rarely and long ago read, quick
+// to refresh, large) have their table dropped and their state marked evicted. Definitions stay, and
+// the next read rehydrates the cache with a forced refresh. Reads are the usage_stats counts flushed
+// by every node, so all nodes rank caches alike.
+class StorageBudget {
+public:
+	StorageBudget(DuckSyncMetadataManager &metadata_manager, DuckSyncStorageManager &storage_manager);
+	~StorageBudget();
+
+	// Size, access stats and score of every cache. Without refresh costs, refresh history is not read
+	// (which flushes its buffer) and every cache is scored with DEFAULT_REFRESH_COST_MS.
+	std::vector<CacheStorageInfo> Collect(bool with_refresh_costs = true);
+
+	// Evict the lowest-scoring caches until the rest fit the budget, never keep (the cache just
+	// refreshed). Caches being refreshed elsewhere are skipped. After an eviction, snapshots and files
+	// past their retention are cleaned up. Returns the evicted cache names.
+	std::vector<std::string> Enforce(ClientContext &context, const StorageBudgetPolicy &policy,
+	                                 const std::string &keep, int64_t lease_seconds);
+
+private:
+	DuckSyncMetadataManager &metadata_manager_;
+	DuckSyncStorageManager &storage_manager_;
+	std::mutex enforce_lock_; // one eviction round at a time
+
+	// (1 + reads) * (1 + refresh seconds) / ((1 + hours since the last read) * (1 + size in MB))
+	static double Score(int64_t accesses, double hours_idle, double refresh_ms, int64_t size_bytes);
+	// Record the eviction and drop the table under the cache's refresh lease; false if it is held
+	bool Evict(const std::string &cache_name, const std::string &source_name, int64_t lease_seconds);
+};
+
+} // namespace duckdb
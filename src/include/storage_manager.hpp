@@ -1,10 +1,58 @@
 #pragma once
 
 #include "duckdb.hpp"
+#include "duckdb/storage/storage_info.hpp"
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace duckdb {
 
+// Time spent in each half of putting a refresh's rows in place
+struct StagedSwapTimings {
+	double write_ms = 0;  // rows written into the live table, or the staging table renamed into place
+	double commit_ms = 0; // DuckLake commit making the new version visible
+};
+
+// Defaults for the ducksync_compaction_* settings
+static constexpr int64_t DEFAULT_COMPACTION_MIN_FILES = 16;
+static constexpr const char *DEFAULT_COMPACTION_MIN_AVG_FILE_SIZE = "16MB";
+
+// When a cache table has accumulated enough small files to be worth merging
+struct CompactionPolicy {
+	int64_t min_files = DEFAULT_COMPACTION_MIN_FILES; // 0 disables compaction
+	idx_t min_avg_file_bytes = 0;
+
+	// Due when the table has at least min_files files averaging below min_avg_file_bytes
+	bool IsDue(int64_t file_count, int64_t total_bytes) const;
+};
+
+CompactionPolicy GetCompactionPolicy(ClientContext &context);
+
+// DuckLake options set on a cache table before it is written: option name -> SQL literal
+using TableOptions = std::vector<std::pair<std::string, std::string>>;
+
+// Physical layout of a cache table, applied when it is created and kept across refreshes
+struct TableLayout {
+	TableOptions options;
+	// DuckLake partition keys: columns or year/month/day/hour(column); empty = unpartitioned
+	std::vector<std::string> partition_by;
+};
+
+// Parquet writer settings for files DuckSync writes itself (see WriteBloomFilteredFiles)
+struct ParquetFileOptions {
+	idx_t row_group_size = DEFAULT_ROW_GROUP_SIZE;
+	std::string compression;      // empty = DuckDB default
+	std::string target_file_size; // empty = DEFAULT_BLOOM_FILE_SIZE
+	// A Bloom filter column holds strings or blobs, whose dictionary needs MAX_STRING_DICTIONARY_PAGE_BYTES
+	bool string_bloom_filters = false;
+};
+
+static constexpr const char *DEFAULT_BLOOM_FILE_SIZE = "512MB";
+static constexpr double BLOOM_FILTER_FALSE_POSITIVE_RATIO = 0.01;
+// Room for a dictionary of long unique strings (e.g. hashes) across a whole row group
+static constexpr idx_t MAX_STRING_DICTIONARY_PAGE_BYTES = 256ULL * 1024 * 1024;
+
 struct StorageConfig {
 	std::string pg_connection_string; // PostgreSQL for DuckLake catalog
 	std::string data_path;            // S3 or local path for parquet files
@@ -13,14 +61,14 @@ struct StorageConfig {
 // Manages DuckLake attachment and cache data storage
 class DuckSyncStorageManager {
 public:
-	explicit DuckSyncStorageManager(ClientContext &context);
+	explicit DuckSyncStorageManager(DatabaseInstance &db);
 	~DuckSyncStorageManager();
 
-	// Setup storage by attaching DuckLake (full setup)
-	void SetupStorage(const std::string &pg_connection_string, const std::string &data_path);
+	// Setup storage by attaching DuckLake (full setup). Settings are read from context, the calling connection.
+	void SetupStorage(ClientContext &context, const std::string &pg_connection_string, const std::string &data_path);
 
 	// Use an existing DuckLake catalog (simpler init)
-	void UseExistingCatalog(const std::string &catalog_name);
+	void UseExistingCatalog(ClientContext &context, const std::string &catalog_name);
 
 	// Get the DuckLake catalog name (for use in queries)
 	const std::string &GetDuckLakeName() const {
@@ -38,23 +86,84 @@ public:
 
 	// Table operations
 	bool TableExists(const std::string &cache_name, const std::string &source_name);
-	void CreateCacheTable(const std::string &cache_name, const std::string &source_name,
-	                      const std::string &query_result);
-	void WriteQueryResult(const std::string &cache_name, const std::string &source_name,
-	                      MaterializedQueryResult &result);
 
 	// Get fully qualified table name for a cache
 	std::string GetDuckLakeTableName(const std::string &cache_name, const std::string &source_name);
 
+	// Whether the live cache table exists with exactly these columns, so a refresh can write into it
+	bool HasSameColumns(const std::string &cache_name, const std::string &source_name, const vector<string> &names,
+	                    const vector<LogicalType> &types);
+	// Replace the live table's rows with those of select_sql in one transaction: DELETE and INSERT
+	// commit together, so readers see the previous version until then and every row is written once.
+	// The table keeps its identity (partitioning, options, snapshot history). rows is set to the count.
+	StagedSwapTimings ReplaceTableContents(const std::string &cache_name, const std::string &source_name,
+	                                       const std::string &select_sql, const TableLayout &layout, int64_t &rows);
+
+	// Refreshes that change the columns (or write their own files) go to a staging table next to the
+	// live table, which is then renamed into place
+	std::string GetStagingTableName(const std::string &cache_name, const std::string &source_name);
+	void CreateStagingTable(const std::string &cache_name, const std::string &source_name,
+	                        const vector<string> &names, const vector<LogicalType> &types, const TableLayout &layout);
+
+	// Write the rows of select_sql as Parquet files with Bloom filters under the cache's data directory;
+	// files is set to their paths. Returns the row count. DuckLake's writer has no Bloom filter settings,
+	// and DuckDB only writes a filter for a dictionary-encoded column chunk, so the dictionary limits are
+	// raised to hold a whole row group. Until registered, the files are orphans for ducksync_cleanup.
+	int64_t WriteBloomFilteredFiles(const std::string &cache_name, const std::string &source_name,
+	                                const std::string &select_sql, const ParquetFileOptions &options,
+	                                std::vector<std::string> &files);
+	// Register written files as the staging table's data in one commit (ducklake_add_data_files, which
+	// hands ownership of the files to DuckLake)
+	StagedSwapTimings AddStagedFiles(const std::string &cache_name, const std::string &source_name,
+	                                 const std::vector<std::string> &files);
+	// Like ReplaceTableContents, for written files: the live table's rows are deleted and the files
+	// registered as its data in one transaction, so the table keeps its identity
+	StagedSwapTimings ReplaceTableFiles(const std::string &cache_name, const std::string &source_name,
+	                                    const std::vector<std::string> &files, const TableLayout &layout);
+
+	// Atomically replace the live cache table with the staging table in one DuckLake commit: the old
+	// table is dropped and the staging table renamed, so no rows are copied
+	StagedSwapTimings SwapStagedTable(const std::string &cache_name, const std::string &source_name);
+	void DropStagingTable(const std::string &cache_name, const std::string &source_name);
+	// Drop the live cache table; its files are deleted by cleanup once no snapshot references them
+	void DropCacheTable(const std::string &cache_name, const std::string &source_name);
+
+	// Data files currently backing a cache table (from ducklake_list_files); false if unavailable
+	bool GetTableFileStats(const std::string &cache_name, const std::string &source_name, int64_t &file_count,
+	                       int64_t &total_bytes);
+	// Every data and delete file DuckLake still holds for the cache, including those of earlier refreshes
+	// and dropped versions of the table kept for the snapshot retention; retained_bytes is that part.
+	// From the DuckLake catalog tables; false if unavailable.
+	bool GetTableDiskUsage(const std::string &cache_name, const std::string &source_name, int64_t &file_count,
+	                       int64_t &total_bytes, int64_t &retained_bytes);
+	// Whether DuckLake keeps its data files on remote storage (S3, GCS, ...) rather than on this node
+	bool HasRemoteDataPath();
+
+	// Rewrite a cache table's small adjacent data files into larger ones (ducklake_merge_adjacent_files).
+	// Callers must hold the cache's refresh lease so no refresh replaces the table meanwhile.
+	void MergeAdjacentFiles(const std::string &cache_name, const std::string &source_name);
+
 private:
-	ClientContext &context_;
+	DatabaseInstance &db_;
 	StorageConfig config_;
 	bool ducklake_attached_;
 	std::string ducklake_name_; // Name of the attached DuckLake catalog
 
 	Connection GetConnection();
-	void InstallRequiredExtensions();
-	void AttachDuckLake();
+	void InstallRequiredExtensions(ClientContext &context);
+	void AttachDuckLake(ClientContext &context);
+	static std::string PartitionSQL(const std::string &table_name, const std::vector<std::string> &partition_by);
+	// Partition keys of the live table, normalized; false when DuckLake's catalog cannot be read
+	bool GetPartitionKeys(Connection &conn, const std::string &cache_name, const std::string &source_name,
+	                      std::vector<std::string> &keys);
+	// Table-scoped DuckLake option (CALL <catalog>.set_option); value_sql is a SQL literal
+	std::string SetOptionSQL(const std::string &table_name, const std::string &source_name, const std::string &option,
+	                         const std::string &value_sql) const;
+	// Register a Parquet file as a table's data (CALL ducklake_add_data_files)
+	std::string AddDataFileSQL(const std::string &table_name, const std::string &source_name,
+	                           const std::string &file) const;
+	// DuckLake data_path of the attached catalog, with a trailing separator
+	std::string GetDataPath(Connection &conn);
 };
 
 } // namespace duckdb
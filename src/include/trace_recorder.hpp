@@ -0,0 +1,90 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace duckdb {
+
+class ClientContext;
+
+// One timed step of a traced ducksync_query call, replacement scan or refresh
+struct TraceSpan {
+	std::string trace_id;
+	int64_t span_id = 0;
+	int64_t parent_id = 0; // 0 for the root span of a trace
+	std::string name;
+	timestamp_t started_at;
+	double duration_ms = 0;
+	// Metadata lookups and commits made on the span's thread while it was open, children included
+	int64_t metadata_reads = 0;
+	int64_t metadata_commits = 0;
+	std::vector<std::pair<std::string, std::string>> attributes;
+
+	// One line of the ducksync_trace_file output
+	std::string ToJSON() const;
+};
+
+// Process-wide ring buffer of the last CAPACITY finished spans, read by ducksync_traces(). It is not
+// per connection so refreshes run by the scheduler land next to the queries that waited on them.
+class TraceRecorder {
+public:
+	static constexpr idx_t CAPACITY = 4096;
+
+	// Keep the span and, when file is set, append it to that JSON lines file. The file is kept open and
+	// flushed after outermost spans, the last of their thread's part of a trace. Never throws.
+	static void Record(TraceSpan span, const std::string &file, bool outermost);
+	// Buffered spans, oldest first
+	static std::vector<TraceSpan> Snapshot();
+	static void Clear();
+};
+
+// Where a span continues a trace whose open spans have already closed
+struct TraceLink {
+	std::string trace_id; // empty when the operation was not traced
+	int64_t span_id = 0;
+	std::string file;
+};
+
+// RAII span, recorded when it goes out of scope. Spans opened while another is open on the same
+// thread become its children. Untraced code pays a thread_local read per span, plus one setting
+// lookup per operation that can start a trace; attribute values that are costly to build should be
+// guarded by Active().
+class TraceScope {
+public:
+	// Joins the trace open on this thread, or starts one when ducksync_trace is on
+	TraceScope(ClientContext &context, const char *name);
+	// Only ever a child: does nothing unless a trace is open on this thread
+	explicit TraceScope(const char *name);
+	// Continues the trace of link, e.g. the execution of a ducksync_query call after its bind
+	TraceScope(const TraceLink &link, const char *name);
+	~TraceScope();
+
+	TraceScope(const TraceScope &) = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+
+	bool Active() const {
+		return active_;
+	}
+	void Set(const std::string &key, const std::string &value);
+	void Set(const std::string &key, const char *value);
+	void Set(const std::string &key, int64_t value);
+	TraceLink Link() const;
+	// Record the span before the end of its scope; only valid for the innermost open span
+	void Stop();
+
+private:
+	bool active_ = false;
+	TraceScope *previous_ = nullptr;
+	std::string file_;
+	TraceSpan span_;
+	std::chrono::steady_clock::time_point start_;
+	idx_t reads_before_ = 0;
+	idx_t commits_before_ = 0;
+
+	void Open(const std::string &trace_id, int64_t parent_id, const std::string &file, const char *name);
+};
+
+} // namespace duckdb
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "metadata_manager.hpp"
+#include "storage_manager.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace duckdb {
+
+// Per-cache counts of how reads were served, recorded on the query path without SQL. These are the
+// only read counters: the memory tier ranks its copies by them, and the storage budget by what they
+// flushed. Counters are relaxed atomics in one slot per cache (per source for passthroughs) that only
+// grow; recording takes the slot table's lock shared, and only the first record of a cache takes it
+// exclusively. The maintenance worker appends what was counted since the last flush to the usage_stats
+// metadata table every FLUSH_SECONDS, so several nodes can append to it without conflicts.
+class UsageStats {
+public:
+	UsageStats(DuckSyncMetadataManager &metadata_manager, DuckSyncStorageManager &storage_manager);
+	~UsageStats();
+
+	static constexpr int64_t FLUSH_SECONDS = 60;
+
+	// A replacement scan routed to the cache
+	void RecordScanHit(const std::string &cache_name, const std::string &source_name);
+	// A ducksync_query call answered from the cache
+	void RecordQueryHit(const std::string &cache_name, const std::string &source_name);
+	// A ducksync_query call sent to the warehouse
+	void RecordPassthrough(const std::string &source_name);
+	// Rows returned by a ducksync_query call that read the cache; a join credits each of its caches
+	void RecordRowsServed(const std::string &cache_name, const std::string &source_name, int64_t rows);
+
+	// Routed reads (scan and query hits) of the cache on this node since DuckSync was initialized, and the
+	// steady clock time of the last one in microseconds; both zero for a cache not read yet
+	void LocalReads(const std::string &cache_name, int64_t &reads, int64_t &last_read_us);
+
+	// Append the counts recorded since the last flush, if any. Bytes avoided are estimated here, as the
+	// hits times the size of the cache's data files. That assumes every read scans the whole cache, so it is
+	// an upper bound for reads that filter or project.
+	void Flush();
+
+private:
+	struct Counters {
+		explicit Counters(std::string source_name_p) : source_name(std::move(source_name_p)) {
+		}
+		const std::string source_name;
+		std::atomic<int64_t> scan_hits {0};
+		std::atomic<int64_t> query_hits {0};
+		std::atomic<int64_t> passthrough_misses {0};
+		std::atomic<int64_t> rows_served {0};
+		std::atomic<int64_t> last_read_us {0};
+		UsageStatsEntry flushed; // totals already appended; guarded by flush_lock_
+	};
+
+	DuckSyncMetadataManager &metadata_manager_;
+	DuckSyncStorageManager &storage_manager_;
+	std::shared_mutex lock_;
+	std::unordered_map<std::string, std::unique_ptr<Counters>> caches_;
+	std::unordered_map<std::string, std::unique_ptr<Counters>> passthrough_; // by source
+	std::atomic<bool> dirty_ {false};
+	std::mutex flush_lock_; // one flush at a time
+
+	Counters &Slot(std::unordered_map<std::string, std::unique_ptr<Counters>> &slots, const std::string &key,
+	               const std::string &source_name);
+	static int64_t NowMicros();
+};
+
+} // namespace duckdb
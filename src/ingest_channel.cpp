@@ -0,0 +1,223 @@
+#include "ingest_channel.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace duckdb {
+
+IngestChannel::IngestChannel(idx_t max_in_flight_bytes) : max_in_flight_bytes_(max_in_flight_bytes) {
+}
+
+IngestChannel::~IngestChannel() {
+	Cancel();
+}
+
+void IngestChannel::Start(DatabaseInstance &db, const vector<string> &source_sqls) {
+	// Stream each result instead of materializing it; rows are only pulled as the channel drains
+	db_ = &db;
+	auto fetch_start = std::chrono::high_resolution_clock::now();
+	for (auto &source_sql : source_sqls) {
+		auto connection = make_uniq<Connection>(db);
+		auto result = connection->SendQuery(source_sql);
+		if (result->HasError()) {
+			throw IOException("Failed to start source query: " + result->GetError());
+		}
+		if (results_.empty()) {
+			types_ = result->types;
+			names_ = result->names;
+		} else if (result->types != types_) {
+			throw IOException("Split source queries returned different column types");
+		}
+		connections_.push_back(std::move(connection));
+		results_.push_back(std::move(result));
+	}
+	fetch_ms_ +=
+	    std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - fetch_start).count();
+
+	active_producers_ = results_.size();
+	for (idx_t i = 0; i < results_.size(); i++) {
+		producers_.emplace_back(&IngestChannel::Produce, this, i);
+	}
+}
+
+void IngestChannel::Produce(idx_t index) {
+	auto &result = results_[index];
+	std::string error;
+	double fetch_ms = 0;
+	try {
+		while (true) {
+			{
+				std::lock_guard<std::mutex> guard(lock_);
+				if (cancelled_) {
+					break;
+				}
+			}
+
+			auto fetch_start = std::chrono::high_resolution_clock::now();
+			auto chunk = result->Fetch();
+			fetch_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() -
+			                                                      fetch_start)
+			                .count();
+			if (!chunk || chunk->size() == 0) {
+				break;
+			}
+			Push(std::move(chunk));
+		}
+		if (result->HasError()) {
+			error = result->GetError();
+		}
+	} catch (const std::exception &e) {
+		error = e.what();
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		// Producers overlap, so the slowest one approximates the fetch wall time
+		fetch_ms_ = std::max(fetch_ms_, fetch_ms);
+		if (!cancelled_ && error_.empty()) {
+			error_ = error;
+		}
+		active_producers_--;
+	}
+	not_empty_.notify_all();
+}
+
+void IngestChannel::SampleBufferMemory() {
+	if (!db_) {
+		return;
+	}
+	auto used = BufferManager::GetBufferManager(*db_).GetUsedMemory();
+	auto peak = peak_buffer_memory_.load(std::memory_order_relaxed);
+	while (used > peak && !peak_buffer_memory_.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+	}
+}
+
+void IngestChannel::Push(unique_ptr<DataChunk> chunk) {
+	SampleBufferMemory();
+	auto chunk_bytes = chunk->GetAllocationSize();
+
+	std::unique_lock<std::mutex> guard(lock_);
+	// Always admit a chunk into an empty channel so a single oversized chunk cannot deadlock
+	not_full_.wait(guard, [&]() {
+		return cancelled_ || chunks_.empty() || in_flight_bytes_ + chunk_bytes <= max_in_flight_bytes_;
+	});
+	if (cancelled_) {
+		return;
+	}
+
+	in_flight_bytes_ += chunk_bytes;
+	peak_in_flight_bytes_ = std::max(peak_in_flight_bytes_, in_flight_bytes_);
+	chunks_.push_back(std::move(chunk));
+	guard.unlock();
+	not_empty_.notify_one();
+}
+
+unique_ptr<DataChunk> IngestChannel::Pop() {
+	std::unique_lock<std::mutex> guard(lock_);
+	not_empty_.wait(guard,
+	                [&]() { return !chunks_.empty() || active_producers_ == 0 || cancelled_ || !error_.empty(); });
+
+	// Fail fast: the remaining producers are stopped by the caller's Cancel()
+	if (!error_.empty()) {
+		throw IOException("Source query failed during ingest: " + error_);
+	}
+	if (chunks_.empty()) {
+		return nullptr;
+	}
+
+	auto chunk = std::move(chunks_.front());
+	chunks_.pop_front();
+	in_flight_bytes_ -= std::min(in_flight_bytes_, chunk->GetAllocationSize());
+	guard.unlock();
+	not_full_.notify_one();
+	// The writer holds the previous chunk's output buffers at this point
+	SampleBufferMemory();
+	return chunk;
+}
+
+void IngestChannel::Finish() {
+	for (auto &producer : producers_) {
+		if (producer.joinable()) {
+			producer.join();
+		}
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	if (!error_.empty()) {
+		throw IOException("Source query failed during ingest: " + error_);
+	}
+}
+
+void IngestChannel::Cancel() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (active_producers_ == 0 && cancelled_) {
+			return;
+		}
+		cancelled_ = true;
+		chunks_.clear();
+		in_flight_bytes_ = 0;
+	}
+	not_full_.notify_all();
+	not_empty_.notify_all();
+
+	// Unblock producers waiting on the source
+	for (auto &connection : connections_) {
+		connection->Interrupt();
+	}
+	for (auto &producer : producers_) {
+		if (producer.joinable()) {
+			producer.join();
+		}
+	}
+}
+
+idx_t GetIngestMemoryBudget(ClientContext &context) {
+	Value budget;
+	if (context.TryGetCurrentSetting("ducksync_ingest_memory_budget", budget) && !budget.IsNull()) {
+		return DBConfig::ParseMemoryLimit(budget.ToString());
+	}
+	return DBConfig::ParseMemoryLimit(DEFAULT_INGEST_MEMORY_BUDGET);
+}
+
+//===--------------------------------------------------------------------===//
+// IngestChannelRegistry
+//===--------------------------------------------------------------------===//
+
+static std::mutex &RegistryLock() {
+	static std::mutex lock;
+	return lock;
+}
+
+static std::unordered_map<idx_t, std::shared_ptr<IngestChannel>> &RegisteredChannels() {
+	static std::unordered_map<idx_t, std::shared_ptr<IngestChannel>> channels;
+	return channels;
+}
+
+idx_t IngestChannelRegistry::Register(std::shared_ptr<IngestChannel> channel) {
+	static idx_t next_id = 0;
+	std::lock_guard<std::mutex> guard(RegistryLock());
+	auto id = ++next_id;
+	RegisteredChannels()[id] = std::move(channel);
+	return id;
+}
+
+std::shared_ptr<IngestChannel> IngestChannelRegistry::Get(idx_t id) {
+	std::lock_guard<std::mutex> guard(RegistryLock());
+	auto &channels = RegisteredChannels();
+	auto entry = channels.find(id);
+	if (entry == channels.end()) {
+		return nullptr;
+	}
+	return entry->second;
+}
+
+void IngestChannelRegistry::Unregister(idx_t id) {
+	std::lock_guard<std::mutex> guard(RegistryLock());
+	RegisteredChannels().erase(id);
+}
+
+} // namespace duckdb
@@ -0,0 +1,111 @@
+#include "latency_stats.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace duckdb {
+
+std::string LatencyStageToString(LatencyStage stage) {
+	switch (stage) {
+	case LatencyStage::QUERY_BIND:
+		return "query_bind";
+	case LatencyStage::QUERY_PARSE:
+		return "query_parse";
+	case LatencyStage::QUERY_LOOKUP:
+		return "query_lookup";
+	case LatencyStage::QUERY_REFRESH_WAIT:
+		return "query_refresh_wait";
+	case LatencyStage::QUERY_PREPARE:
+		return "query_prepare";
+	case LatencyStage::CACHE_HIT_EXECUTION:
+		return "cache_hit_execution";
+	case LatencyStage::PASSTHROUGH_EXECUTION:
+		return "passthrough_execution";
+	case LatencyStage::SCAN_LOOKUP:
+		return "scan_lookup";
+	case LatencyStage::COUNT:
+		break;
+	}
+	return "unknown";
+}
+
+LatencyHistogram::LatencyHistogram() {
+	Reset();
+}
+
+idx_t LatencyHistogram::BucketIndex(uint64_t micros) {
+	if (micros < SUB_BUCKETS) {
+		return static_cast<idx_t>(micros);
+	}
+	idx_t msb = 0;
+	for (auto value = micros; value > 1; value >>= 1) {
+		msb++;
+	}
+	// The SUB_BUCKET_BITS bits below the most significant one pick the bucket within its power of two
+	auto shift = msb - SUB_BUCKET_BITS;
+	auto sub_bucket = static_cast<idx_t>(micros >> shift) & (SUB_BUCKETS - 1);
+	return std::min<idx_t>((shift + 1) * SUB_BUCKETS + sub_bucket, BUCKET_COUNT - 1);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(idx_t index) {
+	if (index < SUB_BUCKETS) {
+		return index;
+	}
+	auto shift = index / SUB_BUCKETS - 1;
+	auto sub_bucket = index % SUB_BUCKETS;
+	return ((static_cast<uint64_t>(SUB_BUCKETS + sub_bucket + 1)) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t micros) {
+	counts_[BucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+	total_micros_.fetch_add(micros, std::memory_order_relaxed);
+	auto max = max_micros_.load(std::memory_order_relaxed);
+	while (micros > max && !max_micros_.compare_exchange_weak(max, micros, std::memory_order_relaxed)) {
+	}
+}
+
+LatencySummary LatencyHistogram::Summarize() const {
+	LatencySummary summary;
+	std::array<uint64_t, BUCKET_COUNT> counts;
+	for (idx_t i = 0; i < BUCKET_COUNT; i++) {
+		counts[i] = counts_[i].load(std::memory_order_relaxed);
+		summary.count += counts[i];
+	}
+	if (summary.count == 0) {
+		return summary;
+	}
+
+	auto max_micros = max_micros_.load(std::memory_order_relaxed);
+	auto percentile = [&](double quantile) {
+		auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * summary.count)));
+		uint64_t seen = 0;
+		for (idx_t i = 0; i < BUCKET_COUNT; i++) {
+			seen += counts[i];
+			if (seen >= rank) {
+				return static_cast<double>(std::min(BucketUpperBound(i), max_micros)) / 1000.0;
+			}
+		}
+		return static_cast<double>(max_micros) / 1000.0;
+	};
+	summary.p50_ms = percentile(0.5);
+	summary.p90_ms = percentile(0.9);
+	summary.p99_ms = percentile(0.99);
+	summary.max_ms = static_cast<double>(max_micros) / 1000.0;
+	summary.mean_ms = static_cast<double>(total_micros_.load(std::memory_order_relaxed)) / summary.count / 1000.0;
+	return summary;
+}
+
+void LatencyHistogram::Reset() {
+	for (auto &count : counts_) {
+		count.store(0, std::memory_order_relaxed);
+	}
+	total_micros_.store(0, std::memory_order_relaxed);
+	max_micros_.store(0, std::memory_order_relaxed);
+}
+
+void LatencyStats::Reset() {
+	for (auto &histogram : histograms_) {
+		histogram.Reset();
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,564 @@
+#include "local_mirror.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/uuid.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include <openssl/sha.h>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace duckdb {
+
+LocalMirrorPolicy GetLocalMirrorPolicy(ClientContext &context) {
+	LocalMirrorPolicy policy;
+	Value setting;
+	if (context.TryGetCurrentSetting("ducksync_local_mirror_path", setting) && !setting.IsNull()) {
+		policy.path = setting.ToString();
+	}
+	auto size = std::string(DEFAULT_LOCAL_MIRROR_SIZE);
+	if (context.TryGetCurrentSetting("ducksync_local_mirror_size", setting) && !setting.IsNull()) {
+		size = setting.ToString();
+	}
+	policy.capacity_bytes = DBConfig::ParseMemoryLimit(size);
+	return policy;
+}
+
+// A file already gone is fine: it is no longer counted either way
+static void RemoveQuietly(FileSystem &fs, const std::string &path) {
+	try {
+		fs.RemoveFile(path);
+	} catch (const std::exception &) {
+	}
+}
+
+void MirrorFileReaders::Pin(const std::vector<std::string> &files) {
+	std::lock_guard<std::mutex> guard(lock);
+	for (auto &file : files) {
+		counts[file]++;
+	}
+}
+
+void MirrorFileReaders::Release(FileSystem &fs, const std::vector<std::string> &files) {
+	std::vector<std::string> unread;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for (auto &file : files) {
+			auto entry = counts.find(file);
+			if (entry == counts.end() || --entry->second > 0) {
+				continue;
+			}
+			counts.erase(entry);
+			if (retired.erase(file) > 0) {
+				unread.push_back(file);
+			}
+		}
+	}
+	for (auto &file : unread) {
+		RemoveQuietly(fs, file);
+	}
+}
+
+void MirrorFileReaders::Retire(FileSystem &fs, const std::string &path) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (counts.find(path) != counts.end()) {
+			retired.insert(path);
+			return;
+		}
+	}
+	RemoveQuietly(fs, path);
+}
+
+void MirrorFileReaders::Revive(const std::string &path) {
+	std::lock_guard<std::mutex> guard(lock);
+	retired.erase(path);
+}
+
+// The mirrored files a query was routed to, released when the query ends
+struct MirrorReadPins : public ClientContextState {
+	struct Pin {
+		std::shared_ptr<MirrorFileReaders> readers;
+		std::vector<std::string> files;
+	};
+	std::vector<Pin> pins;
+
+	void QueryEnd(ClientContext &context) override {
+		auto &fs = FileSystem::GetFileSystem(context);
+		for (auto &pin : pins) {
+			pin.readers->Release(fs, pin.files);
+		}
+		pins.clear();
+	}
+};
+
+static constexpr const char *MIRROR_READ_PINS_KEY = "ducksync_mirror_read_pins";
+
+LocalMirror::LocalMirror(DatabaseInstance &db)
+    : db_(db.shared_from_this()), readers_(std::make_shared<MirrorFileReaders>()) {
+}
+
+LocalMirror::~LocalMirror() {
+	Stop();
+}
+
+bool LocalMirror::Stop() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		stopping_ = true;
+		pending_.clear();
+	}
+	cv_.notify_all();
+	if (!thread_.joinable()) {
+		return true;
+	}
+	if (thread_.get_id() == std::this_thread::get_id()) {
+		thread_.detach();
+		return false;
+	}
+	thread_.join();
+	return true;
+}
+
+bool LocalMirror::Resolve(ClientContext &context, const CacheDefinition &cache, const std::string &ducklake_name,
+                          const std::string &last_refresh, const LocalMirrorPolicy &policy, HotTableRef &out) {
+	if (!policy.Enabled() || last_refresh.empty()) {
+		return false;
+	}
+	if (LookupCurrent(context, cache.cache_name, last_refresh, out)) {
+		return true;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		misses_++;
+	}
+	// First read of this refresh on this node: it goes to DuckLake while the files are copied for later reads
+	if (NeedsPopulate(cache.cache_name, last_refresh, policy)) {
+		SchedulePopulate(cache, ducklake_name, last_refresh, policy);
+	}
+	return false;
+}
+
+void LocalMirror::SchedulePopulate(const CacheDefinition &cache, const std::string &ducklake_name,
+                                   const std::string &last_refresh, const LocalMirrorPolicy &policy) {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (stopping_) {
+			return;
+		}
+		auto &pending = pending_[cache.cache_name];
+		pending.cache = cache;
+		pending.ducklake_name = ducklake_name;
+		pending.last_refresh = last_refresh;
+		pending.policy = policy;
+		if (!thread_.joinable()) {
+			thread_ = std::thread(&LocalMirror::Run, this);
+		}
+	}
+	cv_.notify_one();
+}
+
+void LocalMirror::Run() {
+	while (true) {
+		PendingPopulate next;
+		{
+			std::unique_lock<std::mutex> guard(lock_);
+			cv_.wait(guard, [&]() { return !pending_.empty() || stopping_; });
+			if (stopping_) {
+				return;
+			}
+			auto entry = pending_.begin();
+			next = std::move(entry->second);
+			pending_.erase(entry);
+		}
+
+		// Released at the end of the download, outside lock_: the database may close with it
+		auto db = db_.lock();
+		if (!db) {
+			return;
+		}
+		try {
+			Populate(next.cache, next.ducklake_name, next.last_refresh, next.policy);
+		} catch (const std::exception &) {
+			// Best effort: the refresh is declined, so its reads stay on DuckLake
+		}
+	}
+}
+
+bool LocalMirror::Peek(const std::string &cache_name, const std::string &last_refresh, HotTableRef &out) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto entry = manifests_.find(cache_name);
+	if (entry == manifests_.end() || entry->second.last_refresh.empty() || entry->second.last_refresh != last_refresh) {
+		return false;
+	}
+	out.catalog = LOCAL_MIRROR_CATALOG;
+	out.schema = entry->second.source_name;
+	out.table = cache_name;
+	return true;
+}
+
+bool LocalMirror::LookupCurrent(ClientContext &context, const std::string &cache_name,
+                                const std::string &last_refresh, HotTableRef &out) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto entry = manifests_.find(cache_name);
+	if (entry == manifests_.end() || entry->second.last_refresh.empty() || entry->second.last_refresh != last_refresh) {
+		return false;
+	}
+	auto &manifest = entry->second;
+	hits_++;
+	bytes_saved_ += static_cast<int64_t>(manifest.bytes);
+	access_clock_++;
+	for (auto &local_file : manifest.local_files) {
+		files_[local_file].last_read = access_clock_;
+	}
+	// Taken under lock_, so an eviction after this point leaves the files to the query
+	readers_->Pin(manifest.local_files);
+	auto pins = context.registered_state->GetOrCreate<MirrorReadPins>(MIRROR_READ_PINS_KEY);
+	pins->pins.push_back(MirrorReadPins::Pin {readers_, manifest.local_files});
+	out.catalog = LOCAL_MIRROR_CATALOG;
+	out.schema = manifest.source_name;
+	out.table = cache_name;
+	return true;
+}
+
+bool LocalMirror::NeedsPopulate(const std::string &cache_name, const std::string &last_refresh,
+                                const LocalMirrorPolicy &policy) {
+	if (!policy.Enabled() || last_refresh.empty()) {
+		return false;
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	auto entry = manifests_.find(cache_name);
+	if (entry == manifests_.end()) {
+		return true;
+	}
+	auto &manifest = entry->second;
+	return !manifest.populating && manifest.last_refresh != last_refresh && manifest.declined_refresh != last_refresh;
+}
+
+MirrorPopulate LocalMirror::Populate(const CacheDefinition &cache, const std::string &ducklake_name,
+                                     const std::string &last_refresh, const LocalMirrorPolicy &policy) {
+	if (!policy.Enabled() || last_refresh.empty()) {
+		return MirrorPopulate::NOT_MIRRORABLE;
+	}
+	auto db = db_.lock();
+	if (!db) {
+		return MirrorPopulate::NOT_MIRRORABLE;
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		auto &manifest = manifests_[cache.cache_name];
+		if (manifest.populating) {
+			return MirrorPopulate::IN_PROGRESS;
+		}
+		// The previous file set is being replaced, so it stops being routed to
+		manifest.populating = true;
+		manifest.source_name = cache.source_name;
+		manifest.last_refresh.clear();
+		manifest.local_files.clear();
+		manifest.bytes = 0;
+	}
+
+	Connection conn(*db);
+	auto outcome = MirrorPopulate::MIRRORED;
+	try {
+		EnsureIndexed(*conn.context, policy.path);
+		auto &fs = FileSystem::GetFileSystem(*conn.context);
+
+		std::vector<std::pair<std::string, idx_t>> remote_files;
+		outcome = ListRemoteFiles(conn, cache, ducklake_name, policy.capacity_bytes, remote_files);
+		for (idx_t i = 0; i < remote_files.size() && outcome == MirrorPopulate::MIRRORED; i++) {
+			auto &remote_path = remote_files[i].first;
+			auto bytes = remote_files[i].second;
+			auto local_path = LocalFileName(fs, policy.path, remote_path);
+			bool present;
+			{
+				// A present file joins the manifest right away, so it cannot be evicted before it is used
+				std::lock_guard<std::mutex> guard(lock_);
+				auto existing = files_.find(local_path);
+				present = existing != files_.end() && existing->second.bytes == bytes;
+				if (present) {
+					existing->second.last_read = ++access_clock_;
+					auto &manifest = manifests_[cache.cache_name];
+					manifest.local_files.push_back(local_path);
+					manifest.bytes += bytes;
+				}
+			}
+			if (present) {
+				continue;
+			}
+			CopyFile(fs, remote_path, local_path);
+			std::lock_guard<std::mutex> guard(lock_);
+			// Evicted earlier but still read by a query: the fresh copy must outlive that query
+			readers_->Revive(local_path);
+			auto &file = files_[local_path];
+			file.bytes = bytes;
+			file.last_read = ++access_clock_;
+			auto &manifest = manifests_[cache.cache_name];
+			manifest.local_files.push_back(local_path);
+			manifest.bytes += bytes;
+		}
+		if (outcome == MirrorPopulate::MIRRORED) {
+			std::vector<std::string> local_files;
+			{
+				std::lock_guard<std::mutex> guard(lock_);
+				local_files = manifests_[cache.cache_name].local_files;
+			}
+			CreateView(conn, cache.source_name, cache.cache_name, local_files);
+		}
+	} catch (...) {
+		std::lock_guard<std::mutex> guard(lock_);
+		auto &manifest = manifests_[cache.cache_name];
+		manifest.populating = false;
+		manifest.local_files.clear();
+		manifest.bytes = 0;
+		manifest.declined_refresh = last_refresh;
+		throw;
+	}
+
+	auto &fs = FileSystem::GetFileSystem(*conn.context);
+	std::lock_guard<std::mutex> guard(lock_);
+	auto &manifest = manifests_[cache.cache_name];
+	manifest.populating = false;
+	if (outcome != MirrorPopulate::MIRRORED) {
+		// Not retried until the cache is refreshed again
+		manifest.local_files.clear();
+		manifest.bytes = 0;
+		manifest.declined_refresh = last_refresh;
+		return outcome;
+	}
+	manifest.last_refresh = last_refresh;
+	manifest.declined_refresh.clear();
+	// Removed under lock_, so a concurrent populate cannot count an evicted file as present; files that
+	// running queries still read are removed when the last of them ends
+	for (auto &local_path : PickEvictions(cache.cache_name, policy.capacity_bytes)) {
+		readers_->Retire(fs, local_path);
+	}
+	return MirrorPopulate::MIRRORED;
+}
+
+MirrorPopulate LocalMirror::ListRemoteFiles(Connection &conn, const CacheDefinition &cache,
+                                            const std::string &ducklake_name, idx_t capacity_bytes,
+                                            std::vector<std::pair<std::string, idx_t>> &out) {
+	std::ostringstream sql;
+	sql << "SELECT data_file, data_file_size_bytes, delete_file IS NOT NULL OR data_file_encryption_key IS NOT NULL "
+	    << "FROM ducklake_list_files(" << KeywordHelper::WriteQuoted(ducklake_name, '\'') << ", "
+	    << KeywordHelper::WriteQuoted(cache.cache_name, '\'') << ", schema => "
+	    << KeywordHelper::WriteQuoted(cache.source_name, '\'') << ");";
+	auto listing = conn.Query(sql.str());
+	if (listing->HasError()) {
+		throw IOException("Failed to list data files of " + cache.cache_name + ": " + listing->GetError());
+	}
+
+	// Files with deletes or encryption cannot be read back as plain Parquet, and local files are
+	// not worth copying
+	idx_t total_bytes = 0;
+	for (idx_t row = 0; row < listing->RowCount(); row++) {
+		auto remote_path = listing->GetValue(0, row).ToString();
+		if (listing->GetValue(2, row).GetValue<bool>() || !FileSystem::IsRemoteFile(remote_path)) {
+			return MirrorPopulate::NOT_MIRRORABLE;
+		}
+		auto bytes = static_cast<idx_t>(listing->GetValue(1, row).GetValue<int64_t>());
+		total_bytes += bytes;
+		out.emplace_back(remote_path, bytes);
+	}
+	if (out.empty()) {
+		return MirrorPopulate::NOT_MIRRORABLE;
+	}
+	return total_bytes > capacity_bytes ? MirrorPopulate::OVER_BUDGET : MirrorPopulate::MIRRORED;
+}
+
+void LocalMirror::EnsureIndexed(ClientContext &context, const std::string &path) {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (indexed_path_ == path) {
+			return;
+		}
+	}
+
+	auto &fs = FileSystem::GetFileSystem(context);
+	if (!fs.DirectoryExists(path)) {
+		fs.CreateDirectory(path);
+	}
+	// Copies left by an earlier process are reused; interrupted downloads are removed, but not the
+	// downloads this process has in progress
+	std::unordered_map<std::string, MirroredFile> existing;
+	std::vector<std::string> partial;
+	fs.ListFiles(path, [&](const std::string &name, bool is_directory) {
+		if (is_directory) {
+			return;
+		}
+		auto local_path = fs.JoinPath(path, name);
+		if (StringUtil::EndsWith(name, ".tmp")) {
+			partial.push_back(local_path);
+		} else if (StringUtil::EndsWith(name, ".parquet")) {
+			auto handle = fs.OpenFile(local_path, FileFlags::FILE_FLAGS_READ);
+			existing[local_path].bytes = static_cast<idx_t>(handle->GetFileSize());
+		}
+	});
+
+	std::lock_guard<std::mutex> guard(lock_);
+	for (auto &local_path : partial) {
+		if (downloading_.find(local_path) == downloading_.end()) {
+			RemoveQuietly(fs, local_path);
+		}
+	}
+	if (indexed_path_ == path) {
+		return;
+	}
+	// Manifests refer to files of the previous directory
+	indexed_path_ = path;
+	files_ = std::move(existing);
+	for (auto &entry : manifests_) {
+		if (!entry.second.populating) {
+			entry.second.last_refresh.clear();
+			entry.second.local_files.clear();
+			entry.second.bytes = 0;
+		}
+	}
+}
+
+std::string LocalMirror::LocalFileName(FileSystem &fs, const std::string &mirror_path,
+                                       const std::string &remote_path) {
+	// DuckLake file names are unique per table; the SHA-256 of the path keeps them unique across catalogs
+	// and, unlike std::hash, gives the same name in every build, so copies are found again after a restart
+	auto slash = remote_path.find_last_of("/\\");
+	auto base_name = slash == std::string::npos ? remote_path : remote_path.substr(slash + 1);
+	unsigned char hash[SHA256_DIGEST_LENGTH];
+	SHA256(reinterpret_cast<const unsigned char *>(remote_path.c_str()), remote_path.length(), hash);
+	std::ostringstream name;
+	name << std::hex << std::setfill('0');
+	for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+		name << std::setw(2) << static_cast<int>(hash[i]);
+	}
+	name << "-" << base_name;
+	return fs.JoinPath(mirror_path, name.str());
+}
+
+void LocalMirror::CopyFile(FileSystem &fs, const std::string &remote_path, const std::string &local_path) {
+	// Written under a temporary name and renamed, so a partial copy is never picked up
+	auto temp_path = local_path + "." + UUID::ToString(UUID::GenerateRandomUUID()) + ".tmp";
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		downloading_.insert(temp_path);
+	}
+	try {
+		auto source = fs.OpenFile(remote_path, FileFlags::FILE_FLAGS_READ);
+		auto target = fs.OpenFile(temp_path, FileFlags::FILE_FLAGS_WRITE | FileFlags::FILE_FLAGS_FILE_CREATE_NEW);
+		std::vector<char> buffer(COPY_BUFFER_SIZE);
+		while (true) {
+			auto read = source->Read(buffer.data(), buffer.size());
+			if (read <= 0) {
+				break;
+			}
+			target->Write(buffer.data(), static_cast<idx_t>(read));
+		}
+		target->Sync();
+		target.reset();
+		fs.MoveFile(temp_path, local_path);
+	} catch (...) {
+		try {
+			fs.RemoveFile(temp_path);
+		} catch (const std::exception &) {
+			// Never created
+		}
+		std::lock_guard<std::mutex> guard(lock_);
+		downloading_.erase(temp_path);
+		throw;
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	downloading_.erase(temp_path);
+}
+
+void LocalMirror::CreateView(Connection &conn, const std::string &source_name, const std::string &cache_name,
+                             const std::vector<std::string> &local_files) {
+	std::ostringstream view;
+	view << "CREATE OR REPLACE VIEW " << LOCAL_MIRROR_CATALOG << "." << source_name << "." << cache_name
+	     << " AS SELECT * FROM read_parquet([";
+	for (idx_t i = 0; i < local_files.size(); i++) {
+		view << (i > 0 ? ", " : "") << KeywordHelper::WriteQuoted(local_files[i], '\'');
+	}
+	view << "]);";
+
+	auto catalog = std::string(LOCAL_MIRROR_CATALOG);
+	for (auto &sql : {"ATTACH IF NOT EXISTS ':memory:' AS " + catalog + ";",
+	                  "CREATE SCHEMA IF NOT EXISTS " + catalog + "." + source_name + ";", view.str()}) {
+		auto result = conn.Query(sql);
+		if (result->HasError()) {
+			throw IOException("Failed to create local mirror view for " + cache_name + ": " + result->GetError());
+		}
+	}
+}
+
+std::vector<std::string> LocalMirror::PickEvictions(const std::string &keep, idx_t capacity_bytes) {
+	idx_t used = 0;
+	for (auto &file : files_) {
+		used += file.second.bytes;
+	}
+	if (used <= capacity_bytes) {
+		return {};
+	}
+
+	std::unordered_set<std::string> in_use;
+	for (auto &entry : manifests_) {
+		if (entry.first == keep || entry.second.populating) {
+			in_use.insert(entry.second.local_files.begin(), entry.second.local_files.end());
+		}
+	}
+	std::vector<std::pair<idx_t, std::string>> candidates;
+	for (auto &file : files_) {
+		if (in_use.find(file.first) == in_use.end()) {
+			candidates.emplace_back(file.second.last_read, file.first);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	std::vector<std::string> evicted;
+	std::unordered_set<std::string> evicted_set;
+	for (auto &candidate : candidates) {
+		if (used <= capacity_bytes) {
+			break;
+		}
+		used -= files_[candidate.second].bytes;
+		files_.erase(candidate.second);
+		evicted.push_back(candidate.second);
+		evicted_set.insert(candidate.second);
+	}
+
+	// A manifest missing any of its files can no longer be routed to
+	for (auto &entry : manifests_) {
+		auto &manifest = entry.second;
+		for (auto &local_file : manifest.local_files) {
+			if (evicted_set.find(local_file) != evicted_set.end()) {
+				manifest.last_refresh.clear();
+				manifest.local_files.clear();
+				manifest.bytes = 0;
+				break;
+			}
+		}
+	}
+	return evicted;
+}
+
+LocalMirrorStats LocalMirror::GetStats(const LocalMirrorPolicy &policy) {
+	LocalMirrorStats stats;
+	stats.path = policy.path;
+	stats.capacity_bytes = policy.capacity_bytes;
+	std::lock_guard<std::mutex> guard(lock_);
+	for (auto &file : files_) {
+		stats.used_bytes += file.second.bytes;
+	}
+	stats.files = files_.size();
+	stats.hits = hits_;
+	stats.misses = misses_;
+	stats.bytes_saved = bytes_saved_;
+	return stats;
+}
+
+} // namespace duckdb
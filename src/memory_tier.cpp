@@ -0,0 +1,213 @@
+#include "memory_tier.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/common/exception.hpp"
+
+namespace duckdb {
+
+MemoryTierPolicy GetMemoryTierPolicy(ClientContext &context) {
+	MemoryTierPolicy policy;
+	Value setting;
+	auto budget = std::string(DEFAULT_MEMORY_TIER_BUDGET);
+	if (context.TryGetCurrentSetting("ducksync_memory_tier_budget", setting) && !setting.IsNull()) {
+		budget = setting.ToString();
+	}
+	policy.budget_bytes = DBConfig::ParseMemoryLimit(budget);
+	if (context.TryGetCurrentSetting("ducksync_memory_tier_auto_hits", setting) && !setting.IsNull()) {
+		policy.auto_hits = setting.GetValue<int64_t>();
+	}
+	return policy;
+}
+
+MemoryTier::MemoryTier(DatabaseInstance &db, UsageStats *usage_stats) : db_(db), usage_stats_(usage_stats) {
+}
+
+MemoryTier::~MemoryTier() {
+}
+
+Connection MemoryTier::MakeConnection() {
+	return Connection(db_);
+}
+
+void MemoryTier::EnsureAttached(Connection &conn) {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (attached_) {
+			return;
+		}
+	}
+	auto result = conn.Query(std::string("ATTACH IF NOT EXISTS ':memory:' AS ") + MEMORY_TIER_CATALOG + ";");
+	if (result->HasError()) {
+		throw IOException("Failed to attach the memory tier database: " + result->GetError());
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	attached_ = true;
+}
+
+std::string MemoryTier::HotTableName(const std::string &source_name, const std::string &cache_name) {
+	return std::string(MEMORY_TIER_CATALOG) + "." + source_name + "." + cache_name;
+}
+
+void MemoryTier::LocalReads(const std::string &cache_name, int64_t &reads, int64_t &last_read_us) {
+	reads = 0;
+	last_read_us = 0;
+	if (usage_stats_) {
+		usage_stats_->LocalReads(cache_name, reads, last_read_us);
+	}
+}
+
+bool MemoryTier::Lookup(const std::string &cache_name, const std::string &last_refresh, HotTableRef &out) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto entry = caches_.find(cache_name);
+	if (entry == caches_.end() || entry->second.last_refresh.empty() || entry->second.last_refresh != last_refresh) {
+		return false;
+	}
+	out.catalog = MEMORY_TIER_CATALOG;
+	out.schema = entry->second.source_name;
+	out.table = cache_name;
+	return true;
+}
+
+bool MemoryTier::NeedsLoad(const CacheDefinition &cache, const std::string &last_refresh,
+                           const MemoryTierPolicy &policy) {
+	if (last_refresh.empty()) {
+		return false;
+	}
+	std::lock_guard<std::mutex> guard(lock_);
+	auto entry = caches_.find(cache.cache_name);
+	if (entry == caches_.end()) {
+		return cache.memory_tier;
+	}
+	auto &hot = entry->second;
+	int64_t hits;
+	int64_t last_hit;
+	LocalReads(cache.cache_name, hits, last_hit);
+	bool wanted = cache.memory_tier || (policy.auto_hits > 0 && hits >= policy.auto_hits);
+	return wanted && !hot.loading && hot.last_refresh != last_refresh && hot.over_budget_refresh != last_refresh;
+}
+
+MemoryTierLoad MemoryTier::Load(const CacheDefinition &cache, const std::string &ducklake_table,
+                                const std::string &last_refresh, const MemoryTierPolicy &policy, idx_t bytes) {
+	bool fits = bytes <= policy.budget_bytes;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		auto &entry = caches_[cache.cache_name];
+		if (entry.loading) {
+			return MemoryTierLoad::IN_PROGRESS;
+		}
+		entry.pinned = cache.memory_tier;
+		entry.source_name = cache.source_name;
+		if (!fits) {
+			// Not copied, and not retried until the cache is refreshed again
+			entry.last_refresh.clear();
+			entry.bytes = 0;
+			entry.over_budget_refresh = last_refresh;
+		} else {
+			entry.loading = true;
+		}
+	}
+
+	auto conn = MakeConnection();
+	if (!fits) {
+		// An earlier copy of the cache may still be held
+		DropCopy(conn, cache.source_name, cache.cache_name);
+		return MemoryTierLoad::OVER_BUDGET;
+	}
+
+	auto table_name = HotTableName(cache.source_name, cache.cache_name);
+	try {
+		EnsureAttached(conn);
+		auto schema_result = conn.Query(std::string("CREATE SCHEMA IF NOT EXISTS ") + MEMORY_TIER_CATALOG + "." +
+		                                cache.source_name + ";");
+		if (schema_result->HasError()) {
+			throw IOException("Failed to create memory tier schema: " + schema_result->GetError());
+		}
+		// Replaced in one transaction, so queries already reading the previous copy are unaffected
+		auto copy_result =
+		    conn.Query("CREATE OR REPLACE TABLE " + table_name + " AS SELECT * FROM " + ducklake_table + ";");
+		if (copy_result->HasError()) {
+			throw IOException("Failed to copy cache '%s' into memory: %s", cache.cache_name, copy_result->GetError());
+		}
+	} catch (...) {
+		std::lock_guard<std::mutex> guard(lock_);
+		auto &entry = caches_[cache.cache_name];
+		entry.loading = false;
+		entry.last_refresh.clear();
+		entry.bytes = 0;
+		throw;
+	}
+
+	std::vector<std::string> victims;
+	std::unordered_map<std::string, std::string> victim_sources;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		auto &entry = caches_[cache.cache_name];
+		entry.loading = false;
+		entry.last_refresh = last_refresh;
+		entry.bytes = bytes;
+		entry.over_budget_refresh.clear();
+		victims = PickVictims(cache.cache_name, policy.budget_bytes);
+		for (auto &victim : victims) {
+			victim_sources[victim] = caches_[victim].source_name;
+		}
+	}
+
+	for (auto &victim : victims) {
+		DropCopy(conn, victim_sources[victim], victim);
+		std::lock_guard<std::mutex> guard(lock_);
+		caches_[victim].loading = false;
+	}
+	return MemoryTierLoad::LOADED;
+}
+
+std::vector<std::string> MemoryTier::PickVictims(const std::string &keep, idx_t budget_bytes) {
+	idx_t used = 0;
+	for (auto &entry : caches_) {
+		used += entry.second.last_refresh.empty() ? 0 : entry.second.bytes;
+	}
+
+	std::vector<std::string> victims;
+	while (used > budget_bytes) {
+		HotCache *victim = nullptr;
+		const std::string *victim_name = nullptr;
+		int64_t victim_hits = 0;
+		int64_t victim_last_hit = 0;
+		for (auto &entry : caches_) {
+			auto &hot = entry.second;
+			if (entry.first == keep || hot.last_refresh.empty() || hot.loading) {
+				continue;
+			}
+			int64_t hits;
+			int64_t last_hit;
+			LocalReads(entry.first, hits, last_hit);
+			bool less_used = !victim || hot.pinned < victim->pinned;
+			if (victim && hot.pinned == victim->pinned) {
+				less_used = hits < victim_hits || (hits == victim_hits && last_hit < victim_last_hit);
+			}
+			if (less_used) {
+				victim = &hot;
+				victim_name = &entry.first;
+				victim_hits = hits;
+				victim_last_hit = last_hit;
+			}
+		}
+		if (!victim) {
+			break;
+		}
+		// Routing stops at once; loading keeps a reload from racing the DROP
+		used -= victim->bytes;
+		victim->last_refresh.clear();
+		victim->bytes = 0;
+		victim->loading = true;
+		victims.push_back(*victim_name);
+	}
+	return victims;
+}
+
+void MemoryTier::DropCopy(Connection &conn, const std::string &source_name, const std::string &cache_name) {
+	// Best effort: an undropped copy is unreachable, since routing no longer points at it
+	conn.Query("DROP TABLE IF EXISTS " + HotTableName(source_name, cache_name) + ";");
+}
+
+} // namespace duckdb
@@ -1,10 +1,20 @@
 #include "metadata_manager.hpp"
 #include "duckdb/main/connection.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include <atomic>
 #include <sstream>
 
 namespace duckdb {
 
-DuckSyncMetadataManager::DuckSyncMetadataManager(ClientContext &context) : context_(context), initialized_(false) {
+DuckSyncMetadataManager::DuckSyncMetadataManager(DatabaseInstance &db) : db_(db), initialized_(false) {
+}
+
+DuckSyncMetadataManager::~DuckSyncMetadataManager() {
+	try {
+		FlushRefreshHistory();
+	} catch (...) {
+		// Best effort: history is diagnostic and must not throw during teardown
+	}
 }
 
 std::string DuckSyncMetadataManager::TableName(const std::string &table) const {
@@ -13,7 +23,7 @@ std::string DuckSyncMetadataManager::TableName(const std::string &table) const {
 }
 
 void DuckSyncMetadataManager::ExecuteSQL(const std::string &sql) {
-	Connection conn(*context_.db);
+	Connection conn(db_);
 	auto result = conn.Query(sql);
 	if (result->HasError()) {
 		throw InternalException("DuckSync SQL error: %s\nQuery: %s", result->GetError().c_str(), sql.c_str());
@@ -21,7 +31,7 @@ void DuckSyncMetadataManager::ExecuteSQL(const std::string &sql) {
 }
 
 unique_ptr<MaterializedQueryResult> DuckSyncMetadataManager::QuerySQL(const std::string &sql) {
-	Connection conn(*context_.db);
+	Connection conn(db_);
 	auto result = conn.Query(sql);
 	if (result->HasError()) {
 		throw InternalException("DuckSync SQL error: %s\nQuery: %s", result->GetError().c_str(), sql.c_str());
@@ -29,6 +39,80 @@ unique_ptr<MaterializedQueryResult> DuckSyncMetadataManager::QuerySQL(const std:
 	return unique_ptr<MaterializedQueryResult>(static_cast<MaterializedQueryResult *>(result.release()));
 }
 
+// Microseconds since epoch, strictly increasing within the process; see VersionSQL for other nodes
+static int64_t NextMetadataVersion() {
+	static std::atomic<int64_t> last_version {0};
+	auto now = Timestamp::GetEpochMicroSeconds(Timestamp::GetCurrentTimestamp());
+	auto previous = last_version.load();
+	int64_t next;
+	do {
+		next = MaxValue<int64_t>(now, previous + 1);
+	} while (!last_version.compare_exchange_weak(previous, next));
+	return next;
+}
+
+// Node clocks drift, so the clock alone does not order writes from different nodes. Each version is
+// also above the newest version of the key visible to the writer, so a write that follows another
+// always supersedes it, whatever the writers' clocks say.
+std::string DuckSyncMetadataManager::VersionSQL(const std::string &table, const std::string &key, idx_t key_param,
+                                                idx_t clock_param) const {
+	return "GREATEST($" + std::to_string(clock_param) + ", COALESCE((SELECT MAX(version) FROM " + TableName(table) +
+	       " WHERE " + key + " = $" + std::to_string(key_param) + "), 0) + 1)";
+}
+
+std::string DuckSyncMetadataManager::CurrentRowsSQL(const std::string &table, const std::string &key) const {
+	return "(SELECT * FROM (SELECT * FROM " + TableName(table) + " QUALIFY rank() OVER (PARTITION BY " + key +
+	       " ORDER BY version DESC NULLS LAST) = 1) WHERE deleted IS NOT TRUE) AS current_" + table;
+}
+
+// Metadata commits made by the calling thread; a refresh runs on one thread, so the difference
+// across it is that refresh's commit count
+static thread_local idx_t thread_metadata_commits = 0;
+
+static void NoteCommit() {
+	thread_metadata_commits++;
+}
+
+idx_t DuckSyncMetadataManager::ThreadCommitCount() {
+	return thread_metadata_commits;
+}
+
+// Metadata lookups made by the calling thread, counted the same way for traces
+static thread_local idx_t thread_metadata_reads = 0;
+
+static void NoteRead() {
+	thread_metadata_reads++;
+}
+
+idx_t DuckSyncMetadataManager::ThreadReadCount() {
+	return thread_metadata_reads;
+}
+
+void DuckSyncMetadataManager::AppendTombstone(Connection &conn, const std::string &table, const std::string &key,
+                                              const std::string &value) {
+	auto stmt = conn.Prepare("INSERT INTO " + TableName(table) + " (" + key + ", version, deleted) SELECT $1, " +
+	                         VersionSQL(table, key, 1, 2) + ", true");
+	auto result = stmt->Execute(value, Value::BIGINT(NextMetadataVersion()));
+	if (result->HasError()) {
+		throw InternalException("Failed to delete from %s: %s", table.c_str(), result->GetError().c_str());
+	}
+}
+
+void DuckSyncMetadataManager::AddColumnIfMissing(const std::string &table, const std::string &column,
+                                                 const std::string &type) {
+	Connection conn(db_);
+	auto stmt = conn.Prepare("SELECT 1 FROM information_schema.columns WHERE table_catalog = $1 AND table_schema = $2 "
+	                         "AND table_name = $3 AND column_name = $4");
+	vector<Value> params = {Value(ducklake_name_), Value(schema_name_), Value(table), Value(column)};
+	auto result = stmt->Execute(params, false);
+	if (result->HasError()) {
+		throw InternalException("Failed to inspect %s columns: %s", table.c_str(), result->GetError().c_str());
+	}
+	if (result->Cast<MaterializedQueryResult>().RowCount() == 0) {
+		ExecuteSQL("ALTER TABLE " + TableName(table) + " ADD COLUMN " + column + " " + type + ";");
+	}
+}
+
 void DuckSyncMetadataManager::Initialize(const std::string &ducklake_name, const std::string &schema_name) {
 	if (initialized_) {
 		return;
@@ -47,7 +131,9 @@ void DuckSyncMetadataManager::Initialize(const std::string &ducklake_name, const
 	            << "driver_type VARCHAR, "
 	            << "secret_name VARCHAR, "
 	            << "passthrough_enabled BOOLEAN, "
-	            << "created_at TIMESTAMP"
+	            << "created_at TIMESTAMP, "
+	            << "version BIGINT, "
+	            << "deleted BOOLEAN"
 	            << ");";
 	ExecuteSQL(sources_sql.str());
 
@@ -61,7 +147,20 @@ void DuckSyncMetadataManager::Initialize(const std::string &ducklake_name, const
 	           << "ttl_seconds BIGINT, "
 	           << "invalidation_mode VARCHAR, "
 	           << "metadata_secret_name VARCHAR, "
-	           << "created_at TIMESTAMP"
+	           << "created_at TIMESTAMP, "
+	           << "split_column VARCHAR, "
+	           << "parallelism BIGINT, "
+	           << "snapshot_retention VARCHAR, "
+	           << "file_retention VARCHAR, "
+	           << "sort_by VARCHAR, "
+	           << "row_group_size BIGINT, "
+	           << "target_file_size VARCHAR, "
+	           << "compression VARCHAR, "
+	           << "bloom_filter_columns VARCHAR[], "
+	           << "partition_by VARCHAR[], "
+	           << "memory_tier BOOLEAN, "
+	           << "version BIGINT, "
+	           << "deleted BOOLEAN"
 	           << ");";
 	ExecuteSQL(caches_sql.str());
 
@@ -72,7 +171,9 @@ void DuckSyncMetadataManager::Initialize(const std::string &ducklake_name, const
 	          << "last_refresh TIMESTAMP, "
 	          << "source_state_hash VARCHAR, "
 	          << "expires_at TIMESTAMP, "
-	          << "refresh_count BIGINT"
+	          << "refresh_count BIGINT, "
+	          << "version BIGINT, "
+	          << "deleted BOOLEAN"
 	          << ");";
 	ExecuteSQL(state_sql.str());
 
@@ -82,10 +183,75 @@ void DuckSyncMetadataManager::Initialize(const std::string &ducklake_name, const
 	              << "source_table VARCHAR, "
 	              << "source_rows BIGINT, "
 	              << "source_bytes BIGINT, "
-	              << "snapshot_at TIMESTAMP"
+	              << "snapshot_at TIMESTAMP, "
+	              << "version BIGINT, "
+	              << "deleted BOOLEAN"
 	              << ");";
 	ExecuteSQL(snapshots_sql.str());
 
+	// Catalogs created by earlier versions lack the extraction, retention, layout and versioning columns;
+	// their rows read as version NULL, which any newer write supersedes
+	AddColumnIfMissing("caches", "split_column", "VARCHAR");
+	AddColumnIfMissing("caches", "parallelism", "BIGINT");
+	AddColumnIfMissing("caches", "snapshot_retention", "VARCHAR");
+	AddColumnIfMissing("caches", "file_retention", "VARCHAR");
+	AddColumnIfMissing("caches", "sort_by", "VARCHAR");
+	AddColumnIfMissing("caches", "row_group_size", "BIGINT");
+	AddColumnIfMissing("caches", "target_file_size", "VARCHAR");
+	AddColumnIfMissing("caches", "compression", "VARCHAR");
+	AddColumnIfMissing("caches", "bloom_filter_columns", "VARCHAR[]");
+	AddColumnIfMissing("caches", "partition_by", "VARCHAR[]");
+	AddColumnIfMissing("caches", "memory_tier", "BOOLEAN");
+	for (auto table : {"sources", "caches", "state", "table_snapshots"}) {
+		AddColumnIfMissing(table, "version", "BIGINT");
+		AddColumnIfMissing(table, "deleted", "BOOLEAN");
+	}
+
+	std::ostringstream leases_sql;
+	leases_sql << "CREATE TABLE IF NOT EXISTS " << TableName("refresh_leases") << " ("
+	           << "cache_name VARCHAR, "
+	           << "owner_id VARCHAR, "
+	           << "acquired_at TIMESTAMP, "
+	           << "expires_at TIMESTAMP, "
+	           << "released BOOLEAN"
+	           << ");";
+	ExecuteSQL(leases_sql.str());
+	AddColumnIfMissing("refresh_leases", "released", "BOOLEAN");
+
+	std::ostringstream history_sql;
+	history_sql << "CREATE TABLE IF NOT EXISTS " << TableName("refresh_history") << " ("
+	            << "cache_name VARCHAR, "
+	            << "started_at TIMESTAMP, "
+	            << "refresh_trigger VARCHAR, "
+	            << "decision VARCHAR, "
+	            << "result VARCHAR, "
+	            << "message VARCHAR, "
+	            << "total_ms DOUBLE, "
+	            << "probe_ms DOUBLE, "
+	            << "fetch_ms DOUBLE, "
+	            << "write_ms DOUBLE, "
+	            << "commit_ms DOUBLE, "
+	            << "state_ms DOUBLE, "
+	            << "rows_refreshed BIGINT, "
+	            << "bytes_written BIGINT, "
+	            << "files_created BIGINT, "
+	            << "peak_memory_bytes BIGINT"
+	            << ");";
+	ExecuteSQL(history_sql.str());
+
+	std::ostringstream usage_sql;
+	usage_sql << "CREATE TABLE IF NOT EXISTS " << TableName("usage_stats") << " ("
+	          << "cache_name VARCHAR, "
+	          << "source_name VARCHAR, "
+	          << "scan_hits BIGINT, "
+	          << "query_hits BIGINT, "
+	          << "passthrough_misses BIGINT, "
+	          << "rows_served BIGINT, "
+	          << "bytes_avoided BIGINT, "
+	          << "flushed_at TIMESTAMP"
+	          << ");";
+	ExecuteSQL(usage_sql.str());
+
 	initialized_ = true;
 }
 
@@ -98,34 +264,32 @@ void DuckSyncMetadataManager::CreateSource(const SourceDefinition &source) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
 
-	Connection conn(*context_.db);
+	Connection conn(db_);
 
-	// DuckLake doesn't support ON CONFLICT, so delete then insert
-	auto delete_stmt = conn.Prepare("DELETE FROM " + TableName("sources") + " WHERE source_name = $1");
-	auto delete_result = delete_stmt->Execute(source.source_name);
-	if (delete_result->HasError()) {
-		throw InternalException("Failed to delete existing source: %s", delete_result->GetError().c_str());
-	}
-
-	auto insert_stmt = conn.Prepare("INSERT INTO " + TableName("sources") +
-	                                " (source_name, driver_type, secret_name, passthrough_enabled, created_at) "
-	                                "VALUES ($1, $2, $3, $4, CURRENT_TIMESTAMP)");
-	auto insert_result =
-	    insert_stmt->Execute(source.source_name, source.driver_type, source.secret_name, source.passthrough_enabled);
+	// A newer version supersedes any existing definition; no DELETE needed
+	auto insert_stmt =
+	    conn.Prepare("INSERT INTO " + TableName("sources") +
+	                 " (source_name, driver_type, secret_name, passthrough_enabled, created_at, version, deleted) "
+	                 "SELECT $1, $2, $3, $4, CURRENT_TIMESTAMP, " +
+	                 VersionSQL("sources", "source_name", 1, 5) + ", false");
+	auto insert_result = insert_stmt->Execute(source.source_name, source.driver_type, source.secret_name,
+	                                          source.passthrough_enabled, Value::BIGINT(NextMetadataVersion()));
 	if (insert_result->HasError()) {
 		throw InternalException("Failed to create source: %s", insert_result->GetError().c_str());
 	}
+	NoteCommit();
 }
 
 bool DuckSyncMetadataManager::GetSource(const std::string &source_name, SourceDefinition &out) {
 	if (!initialized_) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
+	NoteRead();
 
-	Connection conn(*context_.db);
+	Connection conn(db_);
 	auto stmt = conn.Prepare("SELECT source_name, driver_type, secret_name, passthrough_enabled, created_at "
 	                         "FROM " +
-	                         TableName("sources") + " WHERE source_name = $1");
+	                         CurrentRowsSQL("sources", "source_name") + " WHERE source_name = $1");
 	vector<Value> params = {Value(source_name)};
 	auto result = stmt->Execute(params, false);
 	if (result->HasError()) {
@@ -150,12 +314,13 @@ std::vector<SourceDefinition> DuckSyncMetadataManager::ListSources() {
 	if (!initialized_) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
+	NoteRead();
 
 	std::vector<SourceDefinition> sources;
 
 	std::ostringstream sql;
 	sql << "SELECT source_name, driver_type, secret_name, passthrough_enabled, created_at "
-	    << "FROM " << TableName("sources") << " ORDER BY source_name;";
+	    << "FROM " << CurrentRowsSQL("sources", "source_name") << " ORDER BY source_name;";
 
 	auto result = QuerySQL(sql.str());
 
@@ -177,30 +342,42 @@ void DuckSyncMetadataManager::DeleteSource(const std::string &source_name) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
 
-	Connection conn(*context_.db);
-	auto stmt = conn.Prepare("DELETE FROM " + TableName("sources") + " WHERE source_name = $1");
-	auto result = stmt->Execute(source_name);
-	if (result->HasError()) {
-		throw InternalException("Failed to delete source: %s", result->GetError().c_str());
-	}
+	Connection conn(db_);
+	AppendTombstone(conn, "sources", "source_name", source_name);
+	NoteCommit();
 }
 
 //===--------------------------------------------------------------------===//
 // Cache Operations
 //===--------------------------------------------------------------------===//
 
+// NULL for an empty list, so unset options read back as unset
+static Value OptionalStringList(const std::vector<std::string> &items) {
+	if (items.empty()) {
+		return Value(LogicalType::LIST(LogicalType::VARCHAR));
+	}
+	vector<Value> values;
+	for (const auto &item : items) {
+		values.push_back(Value(item));
+	}
+	return Value::LIST(LogicalType::VARCHAR, values);
+}
+
+static std::vector<std::string> ReadStringList(const Value &value) {
+	std::vector<std::string> items;
+	if (!value.IsNull() && value.type().id() == LogicalTypeId::LIST) {
+		for (auto &child : ListValue::GetChildren(value)) {
+			items.push_back(child.ToString());
+		}
+	}
+	return items;
+}
+
 void DuckSyncMetadataManager::CreateCache(const CacheDefinition &cache) {
 	if (!initialized_) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
 
-	Connection conn(*context_.db);
-
-	// DuckLake doesn't support ON CONFLICT, so delete then insert
-	auto delete_stmt = conn.Prepare("DELETE FROM " + TableName("caches") + " WHERE cache_name = $1");
-	delete_stmt->Execute(cache.cache_name);
-	DeleteTableSnapshots(cache.cache_name);
-
 	// Build monitor_tables as DuckDB LIST value
 	vector<Value> table_values;
 	for (const auto &table : cache.monitor_tables) {
@@ -208,51 +385,87 @@ void DuckSyncMetadataManager::CreateCache(const CacheDefinition &cache) {
 	}
 	Value tables_list = Value::LIST(LogicalType::VARCHAR, table_values);
 
+	// Definition, initial state and the reset of the snapshot set land in one DuckLake commit
+	Connection conn(db_);
+	auto begin_result = conn.Query("BEGIN TRANSACTION;");
+	if (begin_result->HasError()) {
+		throw InternalException("Failed to create cache: %s", begin_result->GetError().c_str());
+	}
+	try {
+		// A newer version supersedes any existing definition; stale snapshots must not carry over
+		AppendTombstone(conn, "table_snapshots", "cache_name", cache.cache_name);
+	} catch (...) {
+		conn.Query("ROLLBACK;");
+		throw;
+	}
+
 	// Use prepared statement for safe parameter binding
 	auto insert_stmt = conn.Prepare("INSERT INTO " + TableName("caches") +
 	                                " (cache_name, source_name, source_query, monitor_tables, ttl_seconds, "
-	                                "invalidation_mode, metadata_secret_name, created_at) "
-	                                "VALUES ($1, $2, $3, $4, $5, $6, $7, CURRENT_TIMESTAMP)");
+	                                "invalidation_mode, metadata_secret_name, created_at, split_column, parallelism, "
+	                                "snapshot_retention, file_retention, sort_by, row_group_size, target_file_size, "
+	                                "compression, bloom_filter_columns, partition_by, memory_tier, version, deleted) "
+	                                "SELECT $1, $2, $3, $4, $5, $6, $7, CURRENT_TIMESTAMP, $8, $9, $10, $11, $12, "
+	                                "$13, $14, $15, $16, $17, $18, " +
+	                                VersionSQL("caches", "cache_name", 1, 19) + ", false");
 
 	Value ttl_value = cache.has_ttl ? Value::BIGINT(cache.ttl_seconds) : Value(LogicalType::BIGINT);
 	Value metadata_secret_value =
 	    cache.metadata_secret_name.empty() ? Value(LogicalType::VARCHAR) : Value(cache.metadata_secret_name);
 
-	auto result = insert_stmt->Execute(cache.cache_name, cache.source_name, cache.source_query, tables_list, ttl_value,
-	                                   cache.invalidation_mode, metadata_secret_value);
+	Value split_column_value = cache.split_column.empty() ? Value(LogicalType::VARCHAR) : Value(cache.split_column);
+	Value snapshot_retention_value =
+	    cache.snapshot_retention.empty() ? Value(LogicalType::VARCHAR) : Value(cache.snapshot_retention);
+	Value file_retention_value =
+	    cache.file_retention.empty() ? Value(LogicalType::VARCHAR) : Value(cache.file_retention);
+	Value sort_by_value = cache.sort_by.empty() ? Value(LogicalType::VARCHAR) : Value(cache.sort_by);
+	Value row_group_size_value =
+	    cache.row_group_size > 0 ? Value::BIGINT(cache.row_group_size) : Value(LogicalType::BIGINT);
+	Value target_file_size_value =
+	    cache.target_file_size.empty() ? Value(LogicalType::VARCHAR) : Value(cache.target_file_size);
+	Value compression_value = cache.compression.empty() ? Value(LogicalType::VARCHAR) : Value(cache.compression);
+	Value bloom_filter_value = OptionalStringList(cache.bloom_filter_columns);
+	Value partition_by_value = OptionalStringList(cache.partition_by);
+
+	auto result = insert_stmt->Execute(cache.cache_name, cache.source_name, cache.source_query, tables_list,
+	                                   ttl_value, cache.invalidation_mode, metadata_secret_value, split_column_value,
+	                                   Value::BIGINT(cache.parallelism), snapshot_retention_value,
+	                                   file_retention_value, sort_by_value, row_group_size_value,
+	                                   target_file_size_value, compression_value, bloom_filter_value,
+	                                   partition_by_value, Value::BOOLEAN(cache.memory_tier),
+	                                   Value::BIGINT(NextMetadataVersion()));
 	if (result->HasError()) {
+		conn.Query("ROLLBACK;");
 		throw InternalException("Failed to create cache: %s", result->GetError().c_str());
 	}
-}
-
-bool DuckSyncMetadataManager::GetCache(const std::string &cache_name, CacheDefinition &out) {
-	if (!initialized_) {
-		throw InternalException("DuckSyncMetadataManager not initialized");
+	try {
+		AppendInitialState(conn, cache.cache_name);
+	} catch (...) {
+		conn.Query("ROLLBACK;");
+		throw;
 	}
-
-	Connection conn(*context_.db);
-	auto stmt =
-	    conn.Prepare("SELECT cache_name, source_name, source_query, monitor_tables, ttl_seconds, invalidation_mode, "
-	                 "metadata_secret_name, created_at FROM " +
-	                 TableName("caches") + " WHERE cache_name = $1");
-	vector<Value> params = {Value(cache_name)};
-	auto result = stmt->Execute(params, false);
-	if (result->HasError()) {
-		throw InternalException("Failed to get cache: %s", result->GetError().c_str());
+	auto commit_result = conn.Query("COMMIT;");
+	if (commit_result->HasError()) {
+		throw InternalException("Failed to commit cache creation: %s", commit_result->GetError().c_str());
 	}
+	NoteCommit();
+}
 
-	auto &materialized = result->Cast<MaterializedQueryResult>();
-	if (materialized.RowCount() == 0) {
-		return false;
-	}
+// Column order read by ReadCacheRow
+static constexpr const char *CACHE_COLUMNS = "cache_name, source_name, source_query, monitor_tables, ttl_seconds, "
+                                             "invalidation_mode, metadata_secret_name, created_at, split_column, "
+                                             "parallelism, snapshot_retention, file_retention, sort_by, "
+                                             "row_group_size, target_file_size, compression, bloom_filter_columns, "
+                                             "partition_by, memory_tier";
 
-	out.cache_name = materialized.GetValue(0, 0).ToString();
-	out.source_name = materialized.GetValue(1, 0).ToString();
-	out.source_query = materialized.GetValue(2, 0).ToString();
+static void ReadCacheRow(MaterializedQueryResult &result, idx_t row, CacheDefinition &out) {
+	out.cache_name = result.GetValue(0, row).ToString();
+	out.source_name = result.GetValue(1, row).ToString();
+	out.source_query = result.GetValue(2, row).ToString();
 
 	// Parse monitor_tables from list
 	out.monitor_tables.clear();
-	auto tables_value = materialized.GetValue(3, 0);
+	auto tables_value = result.GetValue(3, row);
 	if (tables_value.type().id() == LogicalTypeId::LIST) {
 		auto &list_children = ListValue::GetChildren(tables_value);
 		for (auto &child : list_children) {
@@ -260,7 +473,7 @@ bool DuckSyncMetadataManager::GetCache(const std::string &cache_name, CacheDefin
 		}
 	}
 
-	auto ttl_value = materialized.GetValue(4, 0);
+	auto ttl_value = result.GetValue(4, row);
 	if (!ttl_value.IsNull()) {
 		out.ttl_seconds = ttl_value.GetValue<int64_t>();
 		out.has_ttl = true;
@@ -269,14 +482,66 @@ bool DuckSyncMetadataManager::GetCache(const std::string &cache_name, CacheDefin
 		out.has_ttl = false;
 	}
 
-	auto invalidation_mode = materialized.GetValue(5, 0);
+	auto invalidation_mode = result.GetValue(5, row);
 	out.invalidation_mode = invalidation_mode.IsNull() ? "last_altered" : invalidation_mode.ToString();
 
-	auto metadata_secret_name = materialized.GetValue(6, 0);
+	auto metadata_secret_name = result.GetValue(6, row);
 	out.metadata_secret_name = metadata_secret_name.IsNull() ? "" : metadata_secret_name.ToString();
 
-	out.created_at = materialized.GetValue(7, 0).ToString();
+	out.created_at = result.GetValue(7, row).ToString();
+
+	auto split_column = result.GetValue(8, row);
+	out.split_column = split_column.IsNull() ? "" : split_column.ToString();
+
+	auto parallelism = result.GetValue(9, row);
+	out.parallelism = parallelism.IsNull() ? 0 : parallelism.GetValue<int64_t>();
+
+	auto snapshot_retention = result.GetValue(10, row);
+	out.snapshot_retention = snapshot_retention.IsNull() ? "" : snapshot_retention.ToString();
+
+	auto file_retention = result.GetValue(11, row);
+	out.file_retention = file_retention.IsNull() ? "" : file_retention.ToString();
+
+	auto sort_by = result.GetValue(12, row);
+	out.sort_by = sort_by.IsNull() ? "" : sort_by.ToString();
 
+	auto row_group_size = result.GetValue(13, row);
+	out.row_group_size = row_group_size.IsNull() ? 0 : row_group_size.GetValue<int64_t>();
+
+	auto target_file_size = result.GetValue(14, row);
+	out.target_file_size = target_file_size.IsNull() ? "" : target_file_size.ToString();
+
+	auto compression = result.GetValue(15, row);
+	out.compression = compression.IsNull() ? "" : compression.ToString();
+
+	out.bloom_filter_columns = ReadStringList(result.GetValue(16, row));
+	out.partition_by = ReadStringList(result.GetValue(17, row));
+
+	auto memory_tier = result.GetValue(18, row);
+	out.memory_tier = !memory_tier.IsNull() && memory_tier.GetValue<bool>();
+}
+
+bool DuckSyncMetadataManager::GetCache(const std::string &cache_name, CacheDefinition &out) {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+	NoteRead();
+
+	Connection conn(db_);
+	auto stmt = conn.Prepare(std::string("SELECT ") + CACHE_COLUMNS + " FROM " +
+	                         CurrentRowsSQL("caches", "cache_name") + " WHERE cache_name = $1");
+	vector<Value> params = {Value(cache_name)};
+	auto result = stmt->Execute(params, false);
+	if (result->HasError()) {
+		throw InternalException("Failed to get cache: %s", result->GetError().c_str());
+	}
+
+	auto &materialized = result->Cast<MaterializedQueryResult>();
+	if (materialized.RowCount() == 0) {
+		return false;
+	}
+
+	ReadCacheRow(materialized, 0, out);
 	return true;
 }
 
@@ -309,46 +574,18 @@ std::vector<CacheDefinition> DuckSyncMetadataManager::ListCaches() {
 	if (!initialized_) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
+	NoteRead();
 
 	std::vector<CacheDefinition> caches;
 
 	std::ostringstream sql;
-	sql << "SELECT cache_name, source_name, source_query, monitor_tables, ttl_seconds, invalidation_mode, "
-	       "metadata_secret_name, created_at "
-	    << "FROM " << TableName("caches") << " ORDER BY cache_name;";
+	sql << "SELECT " << CACHE_COLUMNS << " FROM " << CurrentRowsSQL("caches", "cache_name") << " ORDER BY cache_name;";
 
 	auto result = QuerySQL(sql.str());
 
 	for (idx_t row = 0; row < result->RowCount(); row++) {
 		CacheDefinition cache;
-		cache.cache_name = result->GetValue(0, row).ToString();
-		cache.source_name = result->GetValue(1, row).ToString();
-		cache.source_query = result->GetValue(2, row).ToString();
-
-		auto tables_value = result->GetValue(3, row);
-		if (tables_value.type().id() == LogicalTypeId::LIST) {
-			auto &list_children = ListValue::GetChildren(tables_value);
-			for (auto &child : list_children) {
-				cache.monitor_tables.push_back(child.ToString());
-			}
-		}
-
-		auto ttl_value = result->GetValue(4, row);
-		if (!ttl_value.IsNull()) {
-			cache.ttl_seconds = ttl_value.GetValue<int64_t>();
-			cache.has_ttl = true;
-		} else {
-			cache.ttl_seconds = 0;
-			cache.has_ttl = false;
-		}
-
-		auto invalidation_mode = result->GetValue(5, row);
-		cache.invalidation_mode = invalidation_mode.IsNull() ? "last_altered" : invalidation_mode.ToString();
-
-		auto metadata_secret_name = result->GetValue(6, row);
-		cache.metadata_secret_name = metadata_secret_name.IsNull() ? "" : metadata_secret_name.ToString();
-
-		cache.created_at = result->GetValue(7, row).ToString();
+		ReadCacheRow(*result, row, cache);
 		caches.push_back(cache);
 	}
 
@@ -360,91 +597,188 @@ void DuckSyncMetadataManager::DeleteCache(const std::string &cache_name) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
 
-	DeleteTableSnapshots(cache_name);
-	Connection conn(*context_.db);
-	auto stmt = conn.Prepare("DELETE FROM " + TableName("caches") + " WHERE cache_name = $1");
-	auto result = stmt->Execute(cache_name);
-	if (result->HasError()) {
-		throw InternalException("Failed to delete cache: %s", result->GetError().c_str());
+	// Definition, state and snapshot set are tombstoned in one DuckLake commit
+	Connection conn(db_);
+	auto begin_result = conn.Query("BEGIN TRANSACTION;");
+	if (begin_result->HasError()) {
+		throw InternalException("Failed to delete cache: %s", begin_result->GetError().c_str());
+	}
+	try {
+		AppendTombstone(conn, "table_snapshots", "cache_name", cache_name);
+		AppendTombstone(conn, "state", "cache_name", cache_name);
+		AppendTombstone(conn, "caches", "cache_name", cache_name);
+	} catch (...) {
+		conn.Query("ROLLBACK;");
+		throw;
 	}
+	auto commit_result = conn.Query("COMMIT;");
+	if (commit_result->HasError()) {
+		throw InternalException("Failed to commit cache deletion: %s", commit_result->GetError().c_str());
+	}
+	NoteCommit();
 }
 
 //===--------------------------------------------------------------------===//
 // State Operations
 //===--------------------------------------------------------------------===//
 
-void DuckSyncMetadataManager::InitializeState(const std::string &cache_name) {
-	if (!initialized_) {
-		throw InternalException("DuckSyncMetadataManager not initialized");
+void DuckSyncMetadataManager::AppendInitialState(Connection &conn, const std::string &cache_name) {
+	// Checked inside the INSERT, so it needs no separate read
+	auto stmt = conn.Prepare("INSERT INTO " + TableName("state") +
+	                         " (cache_name, refresh_count, version, deleted) SELECT $1, 0, " +
+	                         VersionSQL("state", "cache_name", 1, 2) + ", false WHERE NOT EXISTS (SELECT 1 FROM " +
+	                         CurrentRowsSQL("state", "cache_name") + " WHERE cache_name = $1)");
+	auto result = stmt->Execute(cache_name, Value::BIGINT(NextMetadataVersion()));
+	if (result->HasError()) {
+		throw InternalException("Failed to initialize state: %s", result->GetError().c_str());
 	}
+}
 
-	// Check if state already exists
-	CacheState existing;
-	if (GetState(cache_name, existing)) {
-		return; // Already initialized
-	}
+void DuckSyncMetadataManager::AppendState(Connection &conn, const CacheState &state, bool counts_refresh) {
+	// refresh_count is carried forward from the current version inside the INSERT, so there is no
+	// separate read or DELETE
+	auto insert_stmt = conn.Prepare(
+	    "INSERT INTO " + TableName("state") +
+	    " (cache_name, last_refresh, source_state_hash, expires_at, refresh_count, version, deleted) "
+	    "SELECT $1, $2::TIMESTAMP, $3, $4::TIMESTAMP, COALESCE((SELECT refresh_count FROM " +
+	    CurrentRowsSQL("state", "cache_name") + " WHERE cache_name = $1), 0) + " + (counts_refresh ? "1" : "0") +
+	    ", " + VersionSQL("state", "cache_name", 1, 5) + ", false");
 
-	Connection conn(*context_.db);
-	auto stmt = conn.Prepare("INSERT INTO " + TableName("state") + " (cache_name, refresh_count) VALUES ($1, 0)");
-	auto result = stmt->Execute(cache_name);
-	if (result->HasError()) {
-		throw InternalException("Failed to initialize state: %s", result->GetError().c_str());
+	Value last_refresh_val = state.HasLastRefresh() ? Value(state.last_refresh) : Value(LogicalType::VARCHAR);
+	Value state_hash_val = state.HasStateHash() ? Value(state.source_state_hash) : Value(LogicalType::VARCHAR);
+	Value expires_at_val = state.HasExpiresAt() ? Value(state.expires_at) : Value(LogicalType::VARCHAR);
+
+	auto insert_result = insert_stmt->Execute(state.cache_name, last_refresh_val, state_hash_val, expires_at_val,
+	                                          Value::BIGINT(NextMetadataVersion()));
+	if (insert_result->HasError()) {
+		throw InternalException("Failed to update state: %s", insert_result->GetError().c_str());
 	}
 }
 
-void DuckSyncMetadataManager::UpdateState(const CacheState &state) {
+void DuckSyncMetadataManager::UpdateState(const CacheState &state,
+                                          const std::unordered_map<std::string, TableSnapshot> *snapshots) {
 	if (!initialized_) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
 
-	Connection conn(*context_.db);
-
-	// Get current refresh_count before deleting
-	int64_t refresh_count = 0;
-	{
-		auto count_stmt = conn.Prepare("SELECT refresh_count FROM " + TableName("state") + " WHERE cache_name = $1");
-		vector<Value> count_params = {Value(state.cache_name)};
-		auto count_result = count_stmt->Execute(count_params, false);
-		if (!count_result->HasError()) {
-			auto &count_mat = count_result->Cast<MaterializedQueryResult>();
-			if (count_mat.RowCount() > 0 && !count_mat.GetValue(0, 0).IsNull()) {
-				refresh_count = count_mat.GetValue(0, 0).GetValue<int64_t>();
-			}
+	Connection conn(db_);
+	if (!snapshots) {
+		AppendState(conn, state);
+	} else {
+		// Snapshot set and state land in one DuckLake commit
+		auto begin_result = conn.Query("BEGIN TRANSACTION;");
+		if (begin_result->HasError()) {
+			throw InternalException("Failed to update state: %s", begin_result->GetError().c_str());
+		}
+		try {
+			AppendSnapshotSet(conn, state.cache_name, *snapshots);
+			AppendState(conn, state);
+		} catch (...) {
+			conn.Query("ROLLBACK;");
+			throw;
+		}
+		auto commit_result = conn.Query("COMMIT;");
+		if (commit_result->HasError()) {
+			throw InternalException("Failed to commit state update: %s", commit_result->GetError().c_str());
 		}
 	}
-
-	// DuckLake doesn't support ON CONFLICT, so delete then insert
-	auto delete_stmt = conn.Prepare("DELETE FROM " + TableName("state") + " WHERE cache_name = $1");
-	auto delete_result = delete_stmt->Execute(state.cache_name);
-	if (delete_result->HasError()) {
-		throw InternalException("Failed to delete state: %s", delete_result->GetError().c_str());
+	NoteCommit();
+
+	if (++writes_since_compaction_ >= COMPACT_EVERY_N_WRITES) {
+		writes_since_compaction_ = 0;
+		try {
+			CompactMetadata();
+		} catch (...) {
+			// Best effort: a concurrent writer on another node can conflict; the next round retries
+		}
 	}
+}
 
-	auto insert_stmt = conn.Prepare(
-	    "INSERT INTO " + TableName("state") +
-	    " (cache_name, last_refresh, source_state_hash, expires_at, refresh_count) VALUES ($1, $2, $3, $4, $5)");
+void DuckSyncMetadataManager::CompactMetadata() {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
 
-	Value last_refresh_val = state.HasLastRefresh() ? Value(state.last_refresh) : Value(LogicalType::VARCHAR);
-	Value state_hash_val = state.HasStateHash() ? Value(state.source_state_hash) : Value(LogicalType::VARCHAR);
-	Value expires_at_val = state.HasExpiresAt() ? Value(state.expires_at) : Value(LogicalType::VARCHAR);
-	Value refresh_count_val = Value::BIGINT(refresh_count + 1);
+	// Superseded versions and tombstones are invisible to readers; drop them all in one commit
+	std::vector<std::pair<std::string, std::string>> versioned_tables = {{"sources", "source_name"},
+	                                                                     {"caches", "cache_name"},
+	                                                                     {"state", "cache_name"},
+	                                                                     {"table_snapshots", "cache_name"}};
+	Connection conn(db_);
+	auto begin_result = conn.Query("BEGIN TRANSACTION;");
+	if (begin_result->HasError()) {
+		throw InternalException("Failed to compact metadata: %s", begin_result->GetError().c_str());
+	}
+	for (auto &entry : versioned_tables) {
+		auto &table = entry.first;
+		auto &key = entry.second;
+		std::ostringstream sql;
+		sql << "DELETE FROM " << TableName(table) << " WHERE deleted IS TRUE OR COALESCE(version, -1) < "
+		    << "(SELECT MAX(COALESCE(latest.version, -1)) FROM " << TableName(table) << " AS latest WHERE latest."
+		    << key << " = " << table << "." << key << ");";
+		auto result = conn.Query(sql.str());
+		if (result->HasError()) {
+			conn.Query("ROLLBACK;");
+			throw InternalException("Failed to compact %s: %s", table.c_str(), result->GetError().c_str());
+		}
+	}
+	// Lease rows only matter while a claim is live: drop released attempts (claims and release rows)
+	// and lapsed claims
+	auto leases = TableName("refresh_leases");
+	auto leases_result =
+	    conn.Query("DELETE FROM " + leases + " WHERE (released IS NOT TRUE AND expires_at < CURRENT_TIMESTAMP) OR "
+	               "owner_id IN (SELECT owner_id FROM " + leases + " AS release WHERE release.released IS TRUE);");
+	if (leases_result->HasError()) {
+		conn.Query("ROLLBACK;");
+		throw InternalException("Failed to compact refresh_leases: %s", leases_result->GetError().c_str());
+	}
 
-	auto insert_result =
-	    insert_stmt->Execute(state.cache_name, last_refresh_val, state_hash_val, expires_at_val, refresh_count_val);
-	if (insert_result->HasError()) {
-		throw InternalException("Failed to update state: %s", insert_result->GetError().c_str());
+	// usage_stats gains a row per node per flush. Rows from before yesterday become one row per cache (or
+	// source) and day, stamped with the day's midnight; rows already at midnight are such roll-ups.
+	// Rows of dropped caches are no longer reported and go too.
+	auto usage = TableName("usage_stats");
+	std::string rolled_up = "flushed_at < date_trunc('day', CURRENT_TIMESTAMP::TIMESTAMP) - INTERVAL 1 DAY AND "
+	                        "flushed_at <> date_trunc('day', flushed_at)";
+	std::vector<std::string> retention_statements = {
+	    "INSERT INTO " + usage + " SELECT cache_name, source_name, SUM(scan_hits), SUM(query_hits), "
+	    "SUM(passthrough_misses), SUM(rows_served), SUM(bytes_avoided), date_trunc('day', flushed_at) FROM " +
+	        usage + " WHERE " + rolled_up + " GROUP BY cache_name, source_name, date_trunc('day', flushed_at);",
+	    "DELETE FROM " + usage + " WHERE " + rolled_up + ";",
+	    "DELETE FROM " + usage + " WHERE cache_name IS NOT NULL AND cache_name NOT IN (SELECT cache_name FROM " +
+	        CurrentRowsSQL("caches", "cache_name") + ");"};
+	// refresh_history gains a row per refresh call; old rows go, but each cache keeps enough recent ones
+	// for its p50 refresh cost
+	auto history = TableName("refresh_history");
+	std::ostringstream history_sql;
+	history_sql << "DELETE FROM " << history << " WHERE started_at < CURRENT_TIMESTAMP::TIMESTAMP - INTERVAL "
+	            << HISTORY_RETENTION_DAYS << " DAY AND (SELECT COUNT(*) FROM " << history
+	            << " AS newer WHERE newer.cache_name = refresh_history.cache_name AND newer.started_at > "
+	            << "refresh_history.started_at) >= " << HISTORY_KEEP_PER_CACHE << ";";
+	retention_statements.push_back(history_sql.str());
+	for (auto &statement : retention_statements) {
+		auto result = conn.Query(statement);
+		if (result->HasError()) {
+			conn.Query("ROLLBACK;");
+			throw InternalException("Failed to compact usage history: %s", result->GetError().c_str());
+		}
 	}
+	auto commit_result = conn.Query("COMMIT;");
+	if (commit_result->HasError()) {
+		throw InternalException("Failed to compact metadata: %s", commit_result->GetError().c_str());
+	}
+	NoteCommit();
 }
 
 bool DuckSyncMetadataManager::GetState(const std::string &cache_name, CacheState &out) {
 	if (!initialized_) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
+	NoteRead();
 
-	Connection conn(*context_.db);
-	auto stmt = conn.Prepare("SELECT cache_name, last_refresh, source_state_hash, expires_at "
+	Connection conn(db_);
+	auto stmt = conn.Prepare("SELECT cache_name, last_refresh, source_state_hash, expires_at, refresh_count "
 	                         "FROM " +
-	                         TableName("state") + " WHERE cache_name = $1");
+	                         CurrentRowsSQL("state", "cache_name") + " WHERE cache_name = $1");
 	vector<Value> params = {Value(cache_name)};
 	auto result = stmt->Execute(params, false);
 	if (result->HasError()) {
@@ -467,42 +801,65 @@ bool DuckSyncMetadataManager::GetState(const std::string &cache_name, CacheState
 	auto expires_at = materialized.GetValue(3, 0);
 	out.expires_at = expires_at.IsNull() ? "" : expires_at.ToString();
 
+	auto refresh_count = materialized.GetValue(4, 0);
+	out.refresh_count = refresh_count.IsNull() ? 0 : refresh_count.GetValue<int64_t>();
+
 	return true;
 }
 
-void DuckSyncMetadataManager::SaveTableSnapshot(const std::string &cache_name, const std::string &source_table,
-                                                int64_t source_rows, int64_t source_bytes) {
-	if (!initialized_) {
-		throw InternalException("DuckSyncMetadataManager not initialized");
+void DuckSyncMetadataManager::AppendSnapshotSet(Connection &conn, const std::string &cache_name,
+                                                const std::unordered_map<std::string, TableSnapshot> &snapshots) {
+	if (snapshots.empty()) {
+		AppendTombstone(conn, "table_snapshots", "cache_name", cache_name);
+		return;
 	}
 
-	Connection conn(*context_.db);
-	auto delete_stmt =
-	    conn.Prepare("DELETE FROM " + TableName("table_snapshots") + " WHERE cache_name = $1 AND source_table = $2");
-	auto delete_result = delete_stmt->Execute(cache_name, source_table);
-	if (delete_result->HasError()) {
-		throw InternalException("Failed to delete existing table snapshot: %s", delete_result->GetError().c_str());
+	// The whole set shares one version, which supersedes the previous set in a single append
+	std::ostringstream sql;
+	sql << "INSERT INTO " << TableName("table_snapshots")
+	    << " (cache_name, source_table, source_rows, source_bytes, snapshot_at, version, deleted) "
+	    << "SELECT $1, source_table, source_rows, source_bytes, CURRENT_TIMESTAMP, "
+	    << VersionSQL("table_snapshots", "cache_name", 1, 2) << ", false FROM (VALUES ";
+	vector<Value> params = {Value(cache_name), Value::BIGINT(NextMetadataVersion())};
+	idx_t row = 0;
+	for (auto &entry : snapshots) {
+		auto param = params.size() + 1;
+		sql << (row++ > 0 ? ", " : "") << "($" << param << ", $" << param + 1 << ", $" << param + 2 << ")";
+		params.push_back(Value(entry.first));
+		params.push_back(Value::BIGINT(entry.second.rows));
+		params.push_back(Value::BIGINT(entry.second.bytes));
 	}
+	sql << ") AS ducksync_snapshot_set(source_table, source_rows, source_bytes)";
 
-	auto insert_stmt = conn.Prepare("INSERT INTO " + TableName("table_snapshots") +
-	                                " (cache_name, source_table, source_rows, source_bytes, snapshot_at) "
-	                                "VALUES ($1, $2, $3, $4, CURRENT_TIMESTAMP)");
-	auto insert_result = insert_stmt->Execute(cache_name, source_table, source_rows, source_bytes);
-	if (insert_result->HasError()) {
-		throw InternalException("Failed to save table snapshot: %s", insert_result->GetError().c_str());
+	auto stmt = conn.Prepare(sql.str());
+	auto result = stmt->Execute(params, false);
+	if (result->HasError()) {
+		throw InternalException("Failed to save table snapshots: %s", result->GetError().c_str());
 	}
 }
 
+void DuckSyncMetadataManager::SaveTableSnapshots(const std::string &cache_name,
+                                                 const std::unordered_map<std::string, TableSnapshot> &snapshots) {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+
+	Connection conn(db_);
+	AppendSnapshotSet(conn, cache_name, snapshots);
+	NoteCommit();
+}
+
 std::unordered_map<std::string, TableSnapshot>
 DuckSyncMetadataManager::GetTableSnapshot(const std::string &cache_name) {
 	if (!initialized_) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
+	NoteRead();
 
 	std::unordered_map<std::string, TableSnapshot> snapshots;
-	Connection conn(*context_.db);
-	auto stmt = conn.Prepare("SELECT source_table, source_rows, source_bytes FROM " + TableName("table_snapshots") +
-	                         " WHERE cache_name = $1");
+	Connection conn(db_);
+	auto stmt = conn.Prepare("SELECT source_table, source_rows, source_bytes FROM " +
+	                         CurrentRowsSQL("table_snapshots", "cache_name") + " WHERE cache_name = $1");
 	auto result = stmt->Execute(cache_name);
 	if (result->HasError()) {
 		throw InternalException("Failed to get table snapshots: %s", result->GetError().c_str());
@@ -519,17 +876,357 @@ DuckSyncMetadataManager::GetTableSnapshot(const std::string &cache_name) {
 	return snapshots;
 }
 
-void DuckSyncMetadataManager::DeleteTableSnapshots(const std::string &cache_name) {
+void DuckSyncMetadataManager::MarkEvicted(const std::string &cache_name) {
 	if (!initialized_) {
 		throw InternalException("DuckSyncMetadataManager not initialized");
 	}
 
-	Connection conn(*context_.db);
-	auto stmt = conn.Prepare("DELETE FROM " + TableName("table_snapshots") + " WHERE cache_name = $1");
-	auto result = stmt->Execute(cache_name);
+	CacheState evicted;
+	evicted.cache_name = cache_name;
+	Connection conn(db_);
+	auto begin_result = conn.Query("BEGIN TRANSACTION;");
+	if (begin_result->HasError()) {
+		throw InternalException("Failed to mark cache evicted: %s", begin_result->GetError().c_str());
+	}
+	try {
+		AppendTombstone(conn, "table_snapshots", "cache_name", cache_name);
+		AppendState(conn, evicted, false);
+	} catch (...) {
+		conn.Query("ROLLBACK;");
+		throw;
+	}
+	auto commit_result = conn.Query("COMMIT;");
+	if (commit_result->HasError()) {
+		throw InternalException("Failed to commit cache eviction: %s", commit_result->GetError().c_str());
+	}
+	NoteCommit();
+}
+
+//===--------------------------------------------------------------------===//
+// Refresh Lease Operations
+//===--------------------------------------------------------------------===//
+
+bool DuckSyncMetadataManager::TryAcquireRefreshLease(const std::string &cache_name, const std::string &owner_id,
+                                                     int64_t lease_seconds, std::string &holder) {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+
+	// DuckLake has no unique constraints, so every contender appends a claim and the earliest live
+	// claim wins. rowid is assigned by the catalog at commit, so all nodes agree on the order
+	// regardless of clock skew. Like the versioned tables, leases are only ever appended: expired
+	// claims are skipped by readers, released ones are marked by a later row, and CompactMetadata
+	// removes both.
+	AppendLeaseClaim(cache_name, owner_id, lease_seconds);
+
+	if (GetRefreshLeaseHolder(cache_name, holder) && holder == owner_id) {
+		return true;
+	}
+
+	// Lost the race, or our claim lapsed before it could be read back: withdraw it so it does not
+	// outlive the current leader. Never grant a lease that is not visibly ours.
+	ReleaseRefreshLease(cache_name, owner_id);
+	return false;
+}
+
+bool DuckSyncMetadataManager::RenewRefreshLease(const std::string &cache_name, const std::string &owner_id,
+                                                int64_t lease_seconds) {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+
+	// A renewal is another claim for the same owner. It lands before the previous claim expires, so
+	// it precedes every later contender and keeps the earliest live claim ours.
+	std::string holder;
+	if (!GetRefreshLeaseHolder(cache_name, holder) || holder != owner_id) {
+		return false;
+	}
+	AppendLeaseClaim(cache_name, owner_id, lease_seconds);
+	return true;
+}
+
+void DuckSyncMetadataManager::AppendLeaseClaim(const std::string &cache_name, const std::string &owner_id,
+                                               int64_t lease_seconds) {
+	Connection conn(db_);
+	auto stmt = conn.Prepare("INSERT INTO " + TableName("refresh_leases") +
+	                         " (cache_name, owner_id, acquired_at, expires_at, released) "
+	                         "VALUES ($1, $2, CURRENT_TIMESTAMP, CURRENT_TIMESTAMP + to_seconds($3), false)");
+	auto result = stmt->Execute(cache_name, owner_id, Value::BIGINT(lease_seconds));
+	if (result->HasError()) {
+		throw InternalException("Failed to claim refresh lease: %s", result->GetError().c_str());
+	}
+	NoteCommit();
+}
+
+bool DuckSyncMetadataManager::GetRefreshLeaseHolder(const std::string &cache_name, std::string &holder) {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+	NoteRead();
+
+	Connection conn(db_);
+	auto stmt = conn.Prepare("SELECT owner_id FROM " + TableName("refresh_leases") + " AS claim " +
+	                         "WHERE cache_name = $1 AND released IS NOT TRUE AND expires_at >= CURRENT_TIMESTAMP "
+	                         "AND NOT EXISTS (SELECT 1 FROM " + TableName("refresh_leases") + " AS release " +
+	                         "WHERE release.cache_name = claim.cache_name AND release.owner_id = claim.owner_id "
+	                         "AND release.released IS TRUE) ORDER BY rowid LIMIT 1");
+	vector<Value> params = {Value(cache_name)};
+	auto result = stmt->Execute(params, false);
+	if (result->HasError()) {
+		throw InternalException("Failed to get refresh lease: %s", result->GetError().c_str());
+	}
+
+	auto &materialized = result->Cast<MaterializedQueryResult>();
+	if (materialized.RowCount() == 0) {
+		return false;
+	}
+
+	holder = materialized.GetValue(0, 0).ToString();
+	return true;
+}
+
+void DuckSyncMetadataManager::ReleaseRefreshLease(const std::string &cache_name, const std::string &owner_id) {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+
+	// Owner ids are unique per refresh attempt, so one release row retires every claim of the attempt
+	Connection conn(db_);
+	auto stmt = conn.Prepare("INSERT INTO " + TableName("refresh_leases") +
+	                         " (cache_name, owner_id, acquired_at, expires_at, released) "
+	                         "VALUES ($1, $2, CURRENT_TIMESTAMP, NULL, true)");
+	auto result = stmt->Execute(cache_name, owner_id);
 	if (result->HasError()) {
-		throw InternalException("Failed to delete table snapshots: %s", result->GetError().c_str());
+		throw InternalException("Failed to release refresh lease: %s", result->GetError().c_str());
+	}
+	NoteCommit();
+}
+
+//===--------------------------------------------------------------------===//
+// Refresh History Operations
+//===--------------------------------------------------------------------===//
+
+void DuckSyncMetadataManager::AppendRefreshHistory(const RefreshHistoryEntry &entry) {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+
+	std::lock_guard<std::mutex> guard(history_lock_);
+	if (pending_history_.empty()) {
+		oldest_pending_ = std::chrono::steady_clock::now();
+	}
+	pending_history_.push_back(entry);
+
+	auto pending_for = std::chrono::steady_clock::now() - oldest_pending_;
+	if (pending_history_.size() >= HISTORY_BATCH_SIZE || pending_for >= std::chrono::seconds(HISTORY_FLUSH_SECONDS)) {
+		FlushRefreshHistoryLocked();
+	}
+}
+
+void DuckSyncMetadataManager::FlushRefreshHistory() {
+	if (!initialized_) {
+		return;
+	}
+	std::lock_guard<std::mutex> guard(history_lock_);
+	FlushRefreshHistoryLocked();
+}
+
+void DuckSyncMetadataManager::FlushRefreshHistoryLocked() {
+	if (pending_history_.empty()) {
+		return;
+	}
+
+	static constexpr idx_t HISTORY_COLUMNS = 16;
+	std::ostringstream sql;
+	sql << "INSERT INTO " << TableName("refresh_history")
+	    << " (cache_name, started_at, refresh_trigger, decision, result, message, total_ms, probe_ms, fetch_ms, "
+	       "write_ms, commit_ms, state_ms, rows_refreshed, bytes_written, files_created, peak_memory_bytes) VALUES ";
+
+	vector<Value> params;
+	for (idx_t row = 0; row < pending_history_.size(); row++) {
+		auto &entry = pending_history_[row];
+		sql << (row > 0 ? ", (" : "(");
+		for (idx_t col = 0; col < HISTORY_COLUMNS; col++) {
+			sql << (col > 0 ? ", $" : "$") << (row * HISTORY_COLUMNS + col + 1);
+		}
+		sql << ")";
+
+		params.push_back(Value(entry.cache_name));
+		params.push_back(entry.started_at.empty() ? Value(LogicalType::VARCHAR) : Value(entry.started_at));
+		params.push_back(Value(entry.trigger));
+		params.push_back(Value(entry.decision));
+		params.push_back(Value(entry.result));
+		params.push_back(Value(entry.message));
+		params.push_back(Value::DOUBLE(entry.total_ms));
+		params.push_back(Value::DOUBLE(entry.probe_ms));
+		params.push_back(Value::DOUBLE(entry.fetch_ms));
+		params.push_back(Value::DOUBLE(entry.write_ms));
+		params.push_back(Value::DOUBLE(entry.commit_ms));
+		params.push_back(Value::DOUBLE(entry.state_ms));
+		params.push_back(Value::BIGINT(entry.rows));
+		params.push_back(Value::BIGINT(entry.bytes_written));
+		params.push_back(Value::BIGINT(entry.files_created));
+		params.push_back(Value::BIGINT(entry.peak_memory_bytes));
+	}
+
+	// Drop the batch either way: a history outage must not grow the buffer without bound
+	pending_history_.clear();
+
+	Connection conn(db_);
+	auto stmt = conn.Prepare(sql.str());
+	if (stmt->HasError()) {
+		throw InternalException("Failed to prepare refresh history insert: %s", stmt->GetError().c_str());
+	}
+	auto result = stmt->Execute(params, false);
+	if (result->HasError()) {
+		throw InternalException("Failed to append refresh history: %s", result->GetError().c_str());
+	}
+	NoteCommit();
+}
+
+unique_ptr<MaterializedQueryResult> DuckSyncMetadataManager::SummarizeRefreshHistory(const std::string &cache_name) {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+
+	FlushRefreshHistory();
+
+	// Latency percentiles only cover calls that actually refreshed; skips are counted separately.
+	// Column order and types must match DuckSyncRefreshHistoryBind.
+	auto percentile = [](const std::string &expr, const std::string &quantile, const std::string &alias) {
+		return "quantile_cont(" + expr + ", " + quantile + ") FILTER (WHERE result = 'REFRESHED')::DOUBLE AS " +
+		       alias + ", ";
+	};
+
+	std::ostringstream sql;
+	sql << "SELECT cache_name, "
+	    << "COUNT(*) FILTER (WHERE result = 'REFRESHED') AS refreshes, "
+	    << "COUNT(*) FILTER (WHERE result = 'SKIPPED') AS skips, "
+	    << "COUNT(*) FILTER (WHERE result = 'ERROR') AS errors, " << percentile("total_ms", "0.5", "p50_total_ms")
+	    << percentile("total_ms", "0.95", "p95_total_ms") << "quantile_cont(probe_ms, 0.5)::DOUBLE AS p50_probe_ms, "
+	    << "quantile_cont(probe_ms, 0.95)::DOUBLE AS p95_probe_ms, " << percentile("fetch_ms", "0.5", "p50_fetch_ms")
+	    << percentile("fetch_ms", "0.95", "p95_fetch_ms")
+	    << percentile("write_ms + commit_ms", "0.5", "p50_write_ms")
+	    << percentile("write_ms + commit_ms", "0.95", "p95_write_ms")
+	    << percentile("rows_refreshed", "0.5", "p50_rows")
+	    << "(SUM(rows_refreshed) / NULLIF(SUM(fetch_ms + write_ms + commit_ms) / 1000.0, 0))::DOUBLE AS rows_per_sec, "
+	    << "MAX(peak_memory_bytes)::BIGINT AS max_peak_memory_bytes, "
+	    << "MAX(started_at)::TIMESTAMP AS last_started_at "
+	    << "FROM " << TableName("refresh_history") << " WHERE ($1 = '' OR cache_name = $1) "
+	    << "GROUP BY cache_name ORDER BY cache_name";
+
+	Connection conn(db_);
+	auto stmt = conn.Prepare(sql.str());
+	vector<Value> params = {Value(cache_name)};
+	auto result = stmt->Execute(params, false);
+	if (result->HasError()) {
+		throw InternalException("Failed to summarize refresh history: %s", result->GetError().c_str());
+	}
+	return unique_ptr<MaterializedQueryResult>(static_cast<MaterializedQueryResult *>(result.release()));
+}
+
+//===--------------------------------------------------------------------===//
+// Usage Statistics
+//===--------------------------------------------------------------------===//
+
+void DuckSyncMetadataManager::AppendUsageStats(const std::vector<UsageStatsEntry> &entries) {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+	if (entries.empty()) {
+		return;
+	}
+
+	static constexpr idx_t USAGE_COLUMNS = 7;
+	std::ostringstream sql;
+	sql << "INSERT INTO " << TableName("usage_stats")
+	    << " (cache_name, source_name, scan_hits, query_hits, passthrough_misses, rows_served, bytes_avoided, "
+	       "flushed_at) VALUES ";
+
+	vector<Value> params;
+	for (idx_t row = 0; row < entries.size(); row++) {
+		auto &entry = entries[row];
+		sql << (row > 0 ? ", (" : "(");
+		for (idx_t col = 0; col < USAGE_COLUMNS; col++) {
+			sql << (col > 0 ? ", $" : "$") << (row * USAGE_COLUMNS + col + 1);
+		}
+		sql << ", CURRENT_TIMESTAMP)";
+
+		params.push_back(entry.cache_name.empty() ? Value(LogicalType::VARCHAR) : Value(entry.cache_name));
+		params.push_back(Value(entry.source_name));
+		params.push_back(Value::BIGINT(entry.scan_hits));
+		params.push_back(Value::BIGINT(entry.query_hits));
+		params.push_back(Value::BIGINT(entry.passthrough_misses));
+		params.push_back(Value::BIGINT(entry.rows_served));
+		params.push_back(Value::BIGINT(entry.bytes_avoided));
+	}
+
+	Connection conn(db_);
+	auto stmt = conn.Prepare(sql.str());
+	if (stmt->HasError()) {
+		throw InternalException("Failed to prepare usage stats insert: %s", stmt->GetError().c_str());
+	}
+	auto result = stmt->Execute(params, false);
+	if (result->HasError()) {
+		throw InternalException("Failed to append usage stats: %s", result->GetError().c_str());
+	}
+	NoteCommit();
+}
+
+unique_ptr<MaterializedQueryResult> DuckSyncMetadataManager::SummarizeUsageStats() {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+
+	// Column order and types must match DuckSyncStatsInitGlobal
+	std::ostringstream sql;
+	sql << "SELECT cache_name, source_name, SUM(scan_hits)::BIGINT, SUM(query_hits)::BIGINT, "
+	    << "SUM(passthrough_misses)::BIGINT, SUM(rows_served)::BIGINT, SUM(bytes_avoided)::BIGINT "
+	    << "FROM " << TableName("usage_stats") << " GROUP BY cache_name, source_name "
+	    << "ORDER BY cache_name NULLS LAST, source_name";
+
+	Connection conn(db_);
+	auto result = conn.Query(sql.str());
+	if (result->HasError()) {
+		throw InternalException("Failed to summarize usage stats: %s", result->GetError().c_str());
+	}
+	return result;
+}
+
+std::unordered_map<std::string, CacheReads> DuckSyncMetadataManager::GetCacheReads() {
+	if (!initialized_) {
+		throw InternalException("DuckSyncMetadataManager not initialized");
+	}
+	NoteRead();
+
+	// Idle time is taken against the same clock flushed_at was written with
+	std::ostringstream sql;
+	sql << "SELECT s.cache_name, COALESCE(u.reads, 0)::BIGINT, u.last_read, "
+	    << "GREATEST(epoch(CURRENT_TIMESTAMP::TIMESTAMP) - "
+	    << "epoch(COALESCE(u.last_read, s.last_refresh, CURRENT_TIMESTAMP::TIMESTAMP)), 0) / 3600.0 "
+	    << "FROM " << CurrentRowsSQL("state", "cache_name") << " s LEFT JOIN ("
+	    << "SELECT cache_name, SUM(scan_hits + query_hits) AS reads, "
+	    << "MAX(flushed_at) FILTER (WHERE scan_hits + query_hits > 0) AS last_read "
+	    << "FROM " << TableName("usage_stats") << " WHERE cache_name IS NOT NULL GROUP BY cache_name"
+	    << ") u USING (cache_name)";
+
+	Connection conn(db_);
+	auto result = conn.Query(sql.str());
+	if (result->HasError()) {
+		throw InternalException("Failed to read cache usage: %s", result->GetError().c_str());
+	}
+	std::unordered_map<std::string, CacheReads> reads;
+	for (idx_t row = 0; row < result->RowCount(); row++) {
+		auto &entry = reads[result->GetValue(0, row).ToString()];
+		entry.reads = result->GetValue(1, row).GetValue<int64_t>();
+		auto last_read = result->GetValue(2, row);
+		if (!last_read.IsNull()) {
+			entry.has_last_read = true;
+			entry.last_read = last_read.GetValue<timestamp_t>();
+		}
+		entry.hours_idle = result->GetValue(3, row).GetValue<double>();
 	}
+	return reads;
 }
 
 } // namespace duckdb
@@ -1,17 +1,115 @@
 #include "query_router.hpp"
 #include "duckdb_compat.hpp"
+#include "refresh_orchestrator.hpp"
+#include "trace_recorder.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/string_util.hpp"
 #include "duckdb/function/replacement_scan.hpp"
 #include "duckdb/main/config.hpp"
 #include "duckdb/parser/tableref/basetableref.hpp"
+#include "duckdb/storage/object_cache.hpp"
 
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace duckdb {
 
 static const char *const DUCKSYNC_STATE_KEY = "ducksync_state";
 
+// States this thread holds, and whether exclusively; only the outermost lock of each is recorded
+static thread_local std::unordered_map<const std::shared_mutex *, bool> held_states;
+
+DuckSyncStateLock::DuckSyncStateLock(std::shared_mutex &mutex, Mode mode) : mutex_(&mutex) {
+	auto held = held_states.find(mutex_);
+	if (held != held_states.end()) {
+		if (mode == Mode::EXCLUSIVE && !held->second) {
+			throw InvalidInputException("DuckSync cannot be initialized from within another DuckSync call");
+		}
+		// Reads are not routed while this thread re-points the managers
+		holds_ = !(mode == Mode::ROUTING && held->second);
+		return;
+	}
+	switch (mode) {
+	case Mode::SHARED:
+	case Mode::ROUTING:
+		mutex.lock_shared();
+		break;
+	case Mode::EXCLUSIVE:
+		mutex.lock();
+		break;
+	}
+	exclusive_ = mode == Mode::EXCLUSIVE;
+	held_states.emplace(mutex_, exclusive_);
+	owns_ = true;
+	holds_ = true;
+}
+
+DuckSyncStateLock::~DuckSyncStateLock() {
+	unlock();
+}
+
+DuckSyncStateLock::DuckSyncStateLock(DuckSyncStateLock &&other) noexcept
+    : mutex_(other.mutex_), owns_(other.owns_), holds_(other.holds_), exclusive_(other.exclusive_) {
+	other.owns_ = false;
+	other.holds_ = false;
+}
+
+DuckSyncStateLock &DuckSyncStateLock::operator=(DuckSyncStateLock &&other) noexcept {
+	if (this != &other) {
+		unlock();
+		mutex_ = other.mutex_;
+		owns_ = other.owns_;
+		holds_ = other.holds_;
+		exclusive_ = other.exclusive_;
+		other.owns_ = false;
+		other.holds_ = false;
+	}
+	return *this;
+}
+
+void DuckSyncStateLock::unlock() {
+	holds_ = false;
+	if (!owns_) {
+		return;
+	}
+	owns_ = false;
+	held_states.erase(mutex_);
+	if (exclusive_) {
+		mutex_->unlock();
+	} else {
+		mutex_->unlock_shared();
+	}
+}
+
+DuckSyncManagers DuckSyncState::Managers() const {
+	DuckSyncManagers managers;
+	managers.metadata_manager = metadata_manager;
+	managers.storage_manager = storage_manager;
+	managers.usage_stats = usage_stats;
+	managers.maintenance = maintenance;
+	managers.memory_tier = memory_tier;
+	managers.local_mirror = local_mirror;
+	managers.storage_budget = storage_budget;
+	return managers;
+}
+
+bool DuckSyncState::StopBackground() {
+	// The scheduler first: its refreshes use the local mirror and the maintenance worker
+	bool joined = true;
+	if (scheduler && !scheduler->Stop()) {
+		joined = false;
+	}
+	if (local_mirror && !local_mirror->Stop()) {
+		joined = false;
+	}
+	if (maintenance && !maintenance->Stop()) {
+		joined = false;
+	}
+	return joined;
+}
+
 static bool CaseInsensitiveEquals(const string &left, const string &right) {
 	return StringUtil::Lower(left) == StringUtil::Lower(right);
 }
@@ -87,37 +185,144 @@ static bool LookupCacheForInput(DuckSyncMetadataManager &metadata_manager, Repla
 	return false;
 }
 
-static unique_ptr<TableRef> DuckSyncReplacementScan(ClientContext &context, ReplacementScanInput &input,
-                                                    optional_ptr<ReplacementScanData> data) {
-	(void)data;
-
-	auto &state = GetDuckSyncState(context);
-	if (!state.initialized || !state.metadata_manager || !state.storage_manager) {
+unique_ptr<TableRef> QueryRouter::ResolveTable(ClientContext &context, ReplacementScanInput &input) {
+	// No state until some connection called a DuckSync function; the lookup does not create it
+	auto shared_state = LookupDuckSyncState(*context.db);
+	if (!shared_state) {
+		return nullptr;
+	}
+	auto &state = *shared_state;
+	// A ducksync_init in progress elsewhere is waited for; its own queries are not routed
+	auto state_lock = state.RoutingLock();
+	if (!state_lock.owns_lock() || !state.initialized || !state.metadata_manager || !state.storage_manager) {
 		return nullptr;
 	}
+	// Held by the timer, which outlives the state lock when an evicted cache is rehydrated
+	auto latency = state.latency;
+	ScopedLatency lookup_timer(latency.get(), LatencyStage::SCAN_LOOKUP);
+	TraceScope trace(context, "replacement_scan");
+	trace.Set("table", input.table_name);
 
 	CacheDefinition cache;
 	if (!LookupCacheForInput(*state.metadata_manager, input, cache)) {
+		trace.Set("route", "none");
 		return nullptr;
 	}
+	trace.Set("cache", cache.cache_name);
 
 	CacheState cache_state;
-	if (!state.metadata_manager->GetState(cache.cache_name, cache_state) || !cache_state.HasLastRefresh()) {
+	bool has_state = state.metadata_manager->GetState(cache.cache_name, cache_state);
+	if (has_state && cache_state.IsEvicted()) {
+		// Dropped to fit the storage budget: rehydrate before routing the read. The refresh runs on copies
+		// of the managers, without holding the state.
+		trace.Set("rehydrated", "true");
+		RefreshStatus status;
+		{
+			auto managers = state.Managers();
+			state_lock.unlock();
+			RefreshOrchestrator orchestrator(context, *managers.metadata_manager, *managers.storage_manager,
+			                                 managers.maintenance.get(), managers.memory_tier.get(),
+			                                 managers.local_mirror.get(), managers.storage_budget.get());
+			status = orchestrator.Refresh(cache.cache_name, true, RefreshTrigger::REHYDRATE);
+		}
+		if (status.result == RefreshResult::ERROR) {
+			throw IOException("Failed to rehydrate evicted cache '" + cache.cache_name + "': " + status.message);
+		}
+		state_lock = state.RoutingLock();
+		if (!state_lock.owns_lock() || !state.metadata_manager || !state.storage_manager) {
+			return nullptr;
+		}
+		has_state = state.metadata_manager->GetState(cache.cache_name, cache_state);
+	}
+	if (!has_state || !cache_state.HasLastRefresh()) {
 		auto requested_name = ReplacementScan::GetFullPath(input);
 		throw InvalidInputException("DuckSync table '" + requested_name + "' is monitored by cache '" +
 		                            cache.cache_name + "' but is not yet cached. Run SELECT * FROM ducksync_refresh('" +
 		                            cache.cache_name + "'); or query it explicitly with ducksync_query(...).");
 	}
 
+	if (state.usage_stats) {
+		state.usage_stats->RecordScanHit(cache.cache_name, cache.source_name);
+	}
 	auto table_ref = make_uniq<BaseTableRef>();
+	if (state.memory_tier) {
+		HotTableRef hot;
+		if (state.memory_tier->Lookup(cache.cache_name, cache_state.last_refresh, hot)) {
+			ducksync::SetTableRefFields(*table_ref, hot.catalog, hot.schema, hot.table);
+			trace.Set("route", "memory_tier");
+			return std::move(table_ref);
+		}
+	}
+	if (state.local_mirror) {
+		HotTableRef mirrored;
+		if (state.local_mirror->Resolve(context, cache, state.storage_manager->GetDuckLakeName(),
+		                                cache_state.last_refresh, GetLocalMirrorPolicy(context), mirrored)) {
+			ducksync::SetTableRefFields(*table_ref, mirrored.catalog, mirrored.schema, mirrored.table);
+			trace.Set("route", "local_mirror");
+			return std::move(table_ref);
+		}
+	}
 	ducksync::SetTableRefFields(*table_ref, state.storage_manager->GetDuckLakeName(), cache.source_name,
 	                            cache.cache_name);
+	trace.Set("route", "ducklake");
 	return std::move(table_ref);
 }
 
+static unique_ptr<TableRef> DuckSyncReplacementScan(ClientContext &context, ReplacementScanInput &input,
+                                                    optional_ptr<ReplacementScanData> data) {
+	(void)data;
+	return QueryRouter::ResolveTable(context, input);
+}
+
+// Anchors the state to its database: the object cache is destroyed with the DatabaseInstance. The
+// state's background threads pin the database only while a run uses it, so they do not keep it open.
+class DuckSyncStateEntry : public ObjectCacheEntry {
+public:
+	DuckSyncStateEntry() : state(std::make_shared<DuckSyncState>()) {
+	}
+	~DuckSyncStateEntry() override;
+
+	static string ObjectType() {
+		return "ducksync_state";
+	}
+	string GetObjectType() override {
+		return ObjectType();
+	}
+	// Not evictable: the state must last as long as the database
+	optional_idx GetEstimatedCacheMemory() const override {
+		return optional_idx();
+	}
+
+	std::shared_ptr<DuckSyncState> state;
+};
+
+// Stopped states whose background thread closed the database; see ~DuckSyncStateEntry. Never destroyed,
+// since their managers reference the database that is gone.
+static std::mutex abandoned_states_lock;
+static std::vector<std::shared_ptr<DuckSyncState>> *abandoned_states =
+    new std::vector<std::shared_ptr<DuckSyncState>>();
+
+DuckSyncStateEntry::~DuckSyncStateEntry() {
+	if (state->StopBackground()) {
+		return;
+	}
+	// The last reference to the database was the pin of a background run, released on this thread: it
+	// cannot join itself and returns into its loop, so the stopped state is kept rather than destroyed
+	std::lock_guard<std::mutex> guard(abandoned_states_lock);
+	abandoned_states->push_back(std::move(state));
+}
+
 DuckSyncState &GetDuckSyncState(ClientContext &context) {
-	auto state = context.registered_state->GetOrCreate<DuckSyncState>(DUCKSYNC_STATE_KEY);
-	return *state;
+	auto entry = ObjectCache::GetObjectCache(context).GetOrCreate<DuckSyncStateEntry>(DUCKSYNC_STATE_KEY);
+	return *entry->state;
+}
+
+std::shared_ptr<DuckSyncState> LookupDuckSyncState(DatabaseInstance &db) {
+	auto entry = db.GetObjectCache().Get<DuckSyncStateEntry>(DUCKSYNC_STATE_KEY);
+	if (!entry) {
+		return nullptr;
+	}
+	return entry->state;
 }
 
 void QueryRouter::Register(DatabaseInstance &db) {
@@ -0,0 +1,126 @@
+#include "refresh_coordinator.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+namespace duckdb {
+
+struct InFlightRefresh {
+	std::mutex lock;
+	std::condition_variable finished_cv;
+	bool finished = false;
+	RefreshStatus status;
+};
+
+static std::mutex &InFlightLock() {
+	static std::mutex lock;
+	return lock;
+}
+
+static std::unordered_map<std::string, std::shared_ptr<InFlightRefresh>> &InFlightRefreshes() {
+	static std::unordered_map<std::string, std::shared_ptr<InFlightRefresh>> refreshes;
+	return refreshes;
+}
+
+RefreshStatus RefreshCoordinator::RunSingleFlight(const std::string &key,
+                                                  const std::function<RefreshStatus()> &refresh) {
+	std::shared_ptr<InFlightRefresh> flight;
+	bool leader = false;
+	{
+		std::lock_guard<std::mutex> guard(InFlightLock());
+		auto &refreshes = InFlightRefreshes();
+		auto entry = refreshes.find(key);
+		if (entry == refreshes.end()) {
+			flight = std::make_shared<InFlightRefresh>();
+			refreshes[key] = flight;
+			leader = true;
+		} else {
+			flight = entry->second;
+		}
+	}
+
+	if (!leader) {
+		std::unique_lock<std::mutex> wait_lock(flight->lock);
+		flight->finished_cv.wait(wait_lock, [&]() { return flight->finished; });
+		auto status = flight->status;
+		status.message = "Joined in-flight refresh: " + status.message;
+		return status;
+	}
+
+	RefreshStatus status;
+	try {
+		status = refresh();
+	} catch (const std::exception &e) {
+		status.result = RefreshResult::ERROR;
+		status.message = std::string("Refresh failed: ") + e.what();
+	}
+
+	// Unregister before publishing so a caller arriving after this point starts a fresh refresh
+	{
+		std::lock_guard<std::mutex> guard(InFlightLock());
+		InFlightRefreshes().erase(key);
+	}
+	{
+		std::lock_guard<std::mutex> guard(flight->lock);
+		flight->status = status;
+		flight->finished = true;
+	}
+	flight->finished_cv.notify_all();
+	return status;
+}
+
+std::string RefreshCoordinator::NewLeaseOwner() {
+	static const std::string process_id = []() {
+		std::random_device device;
+		std::mt19937_64 generator((static_cast<uint64_t>(device()) << 32) ^ device());
+		std::ostringstream hex;
+		hex << std::hex << std::setfill('0') << std::setw(16) << generator();
+		return hex.str();
+	}();
+	static std::atomic<uint64_t> sequence {0};
+	return process_id + "-" + std::to_string(++sequence);
+}
+
+RefreshLeaseHeartbeat::RefreshLeaseHeartbeat(DuckSyncMetadataManager &metadata_manager, std::string cache_name,
+                                             std::string owner_id, int64_t lease_seconds)
+    : metadata_manager_(metadata_manager), cache_name_(std::move(cache_name)), owner_id_(std::move(owner_id)),
+      lease_seconds_(lease_seconds) {
+	thread_ = std::thread([this]() { Run(); });
+}
+
+RefreshLeaseHeartbeat::~RefreshLeaseHeartbeat() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		stopping_ = true;
+	}
+	stop_cv_.notify_all();
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+}
+
+void RefreshLeaseHeartbeat::Run() {
+	// Renew well before expiry, so one slow or failed renewal does not lose the lease
+	auto interval = std::chrono::milliseconds(MaxValue<int64_t>(lease_seconds_ * 1000 / 3, 1));
+	std::unique_lock<std::mutex> guard(lock_);
+	while (!stop_cv_.wait_for(guard, interval, [this]() { return stopping_; })) {
+		guard.unlock();
+		try {
+			if (!metadata_manager_.RenewRefreshLease(cache_name_, owner_id_, lease_seconds_)) {
+				// Lapsed and taken over: the refresh still commits, but there is nothing left to renew
+				return;
+			}
+		} catch (...) {
+			// Retried at the next interval; the lease only lapses if renewals keep failing
+		}
+		guard.lock();
+	}
+}
+
+} // namespace duckdb
@@ -1,11 +1,20 @@
 #include "refresh_orchestrator.hpp"
+#include "refresh_coordinator.hpp"
+#include "ingest_channel.hpp"
+#include "trace_recorder.hpp"
 #include "duckdb/main/connection.hpp"
 #include "duckdb/main/client_context.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+#include <algorithm>
 #include <sstream>
 #include <chrono>
 #include <iomanip>
+#include <regex>
+#include <thread>
 #include <openssl/sha.h>
 
 namespace duckdb {
@@ -58,23 +67,123 @@ static ParsedMonitorTable ParseMonitorTableName(const std::string &monitor_table
 }
 
 template <typename SnapshotType>
-static void SaveSnapshots(DuckSyncMetadataManager &metadata_manager, const std::string &cache_name,
-                          const std::unordered_map<std::string, SnapshotType> &snapshots) {
-	metadata_manager.DeleteTableSnapshots(cache_name);
+static std::unordered_map<std::string, TableSnapshot>
+ToTableSnapshots(const std::unordered_map<std::string, SnapshotType> &snapshots) {
+	std::unordered_map<std::string, TableSnapshot> table_snapshots;
 	for (const auto &entry : snapshots) {
-		metadata_manager.SaveTableSnapshot(cache_name, entry.first, entry.second.rows, entry.second.bytes);
+		table_snapshots[entry.first] = TableSnapshot {entry.second.rows, entry.second.bytes};
 	}
+	return table_snapshots;
+}
+
+// Adds its own lifetime to one of the RefreshMetrics phase counters
+struct ScopedPhaseTimer {
+	// Phases are also spans of the refresh's trace when one is open
+	ScopedPhaseTimer(double &target_p, const char *phase)
+	    : target(target_p), span(phase), start(std::chrono::high_resolution_clock::now()) {
+	}
+	~ScopedPhaseTimer() {
+		target += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	double &target;
+	TraceScope span;
+	std::chrono::high_resolution_clock::time_point start;
+};
+
+std::string RefreshResultToString(RefreshResult result) {
+	switch (result) {
+	case RefreshResult::SKIPPED:
+		return "SKIPPED";
+	case RefreshResult::REFRESHED:
+		return "REFRESHED";
+	case RefreshResult::ERROR:
+		return "ERROR";
+	case RefreshResult::LEASE_BUSY:
+		return "LEASE_BUSY";
+	}
+	return "ERROR";
+}
+
+std::string GetSourceFunction(ClientContext &context) {
+	Value function;
+	if (context.TryGetCurrentSetting("ducksync_source_function", function) && !function.IsNull() &&
+	    !function.ToString().empty()) {
+		return KeywordHelper::WriteOptionallyQuoted(function.ToString());
+	}
+	return DEFAULT_SOURCE_FUNCTION;
+}
+
+std::string RefreshTriggerToString(RefreshTrigger trigger) {
+	switch (trigger) {
+	case RefreshTrigger::MANUAL:
+		return "manual";
+	case RefreshTrigger::QUERY:
+		return "query";
+	case RefreshTrigger::SCHEDULER:
+		return "scheduler";
+	case RefreshTrigger::REHYDRATE:
+		return "rehydrate";
+	}
+	return "manual";
 }
 
 RefreshOrchestrator::RefreshOrchestrator(ClientContext &context, DuckSyncMetadataManager &metadata_manager,
-                                         DuckSyncStorageManager &storage_manager)
-    : context_(context), metadata_manager_(metadata_manager), storage_manager_(storage_manager) {
+                                         DuckSyncStorageManager &storage_manager, MaintenanceWorker *maintenance,
+                                         MemoryTier *memory_tier, LocalMirror *local_mirror,
+                                         StorageBudget *storage_budget)
+    : context_(context), metadata_manager_(metadata_manager), storage_manager_(storage_manager),
+      maintenance_(maintenance), memory_tier_(memory_tier), local_mirror_(local_mirror),
+      storage_budget_(storage_budget), source_function_(GetSourceFunction(context)) {
 }
 
 RefreshOrchestrator::~RefreshOrchestrator() {
 }
 
-RefreshStatus RefreshOrchestrator::Refresh(const std::string &cache_name, bool force) {
+RefreshStatus RefreshOrchestrator::Refresh(const std::string &cache_name, bool force, RefreshTrigger trigger) {
+	// Forced refreshes get their own flight so they never inherit a concurrent smart check's SKIPPED
+	auto key = metadata_manager_.GetDuckLakeName() + "." + metadata_manager_.GetSchemaName() + "." + cache_name +
+	           (force ? "#force" : "");
+	TraceScope trace(context_, "refresh");
+	trace.Set("cache", cache_name);
+	trace.Set("trigger", RefreshTriggerToString(trigger));
+	trace.Set("force", force ? "true" : "false");
+	trace.Set("leader", "false");
+	auto result = RefreshCoordinator::RunSingleFlight(key, [&]() {
+		trace.Set("leader", "true");
+		// Only the leader records history; followers did no work of their own
+		auto started_at = Timestamp::ToString(Timestamp::GetCurrentTimestamp());
+		auto start_time = std::chrono::high_resolution_clock::now();
+		metrics_ = RefreshMetrics();
+		split_fallback_.clear();
+		auto commits_before = DuckSyncMetadataManager::ThreadCommitCount();
+
+		auto status = RefreshInternal(cache_name, force);
+		if (!split_fallback_.empty()) {
+			trace.Set("split_fallback", split_fallback_);
+		}
+		UpdateLocalCopies(cache_name, status);
+		EnforceStorageBudget(cache_name, status);
+		metrics_.metadata_commits = static_cast<int64_t>(DuckSyncMetadataManager::ThreadCommitCount() - commits_before);
+		status.metrics = metrics_;
+
+		auto total_ms =
+		    std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+		RecordHistory(cache_name, trigger, started_at, total_ms, status);
+		if (maintenance_ && status.result == RefreshResult::REFRESHED) {
+			maintenance_->NotifyRefresh(GetMaintenanceInterval());
+		}
+		return status;
+	});
+	trace.Set("result", RefreshResultToString(result.result));
+	trace.Set("decision", result.decision);
+	if (result.has_rows) {
+		trace.Set("rows", result.rows_refreshed);
+	}
+	return result;
+}
+
+RefreshStatus RefreshOrchestrator::RefreshInternal(const std::string &cache_name, bool force) {
 	RefreshStatus status;
 	auto start_time = std::chrono::high_resolution_clock::now();
 
@@ -84,6 +193,7 @@ RefreshStatus RefreshOrchestrator::Refresh(const std::string &cache_name, bool f
 		if (!metadata_manager_.GetCache(cache_name, cache)) {
 			status.result = RefreshResult::ERROR;
 			status.message = "Cache '" + cache_name + "' not found";
+			status.decision = "cache_not_found";
 			return status;
 		}
 
@@ -92,6 +202,7 @@ RefreshStatus RefreshOrchestrator::Refresh(const std::string &cache_name, bool f
 		if (!metadata_manager_.GetSource(cache.source_name, source)) {
 			status.result = RefreshResult::ERROR;
 			status.message = "Source '" + cache.source_name + "' not found";
+			status.decision = "source_not_found";
 			return status;
 		}
 
@@ -101,86 +212,37 @@ RefreshStatus RefreshOrchestrator::Refresh(const std::string &cache_name, bool f
 
 		// Step 4: Force / manual dispatch
 		if (force) {
-			int64_t rows = ExecuteRefresh(cache, source);
-			std::string state_hash;
-			if (cache.invalidation_mode == "last_altered" || cache.invalidation_mode == "two_stage") {
-				auto source_metadata = GetSourceTableMetadata(source.secret_name, cache.monitor_tables);
-				state_hash = GenerateStateHash(source_metadata);
-			}
-			if (cache.invalidation_mode == "two_stage") {
-				auto rows_bytes = GetSourceTableRowsAndBytes(cache.metadata_secret_name, cache.monitor_tables);
-				SaveSnapshots(metadata_manager_, cache_name, rows_bytes);
-			}
-			UpdateCacheState(cache_name, state_hash, cache);
-
-			auto end_time = std::chrono::high_resolution_clock::now();
-			auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-			status.result = RefreshResult::REFRESHED;
-			status.message = "Cache refreshed successfully";
-			status.rows_refreshed = rows;
-			status.has_rows = true;
-			status.duration_ms = static_cast<double>(duration.count());
-			status.has_duration = true;
-			return status;
+			return RefreshUnderLease(cache, source, state, force, "forced", start_time);
 		}
 
 		if (cache.invalidation_mode == "manual") {
 			status.result = RefreshResult::SKIPPED;
 			status.message = "Cache refresh skipped because invalidation_mode is manual";
+			status.decision = "manual_mode";
 			return status;
 		}
 
 		if (!has_state) {
-			int64_t rows = ExecuteRefresh(cache, source);
-			std::string state_hash;
-			if (cache.invalidation_mode == "last_altered" || cache.invalidation_mode == "two_stage") {
-				auto source_metadata = GetSourceTableMetadata(source.secret_name, cache.monitor_tables);
-				state_hash = GenerateStateHash(source_metadata);
-			}
-			if (cache.invalidation_mode == "two_stage") {
-				auto rows_bytes = GetSourceTableRowsAndBytes(cache.metadata_secret_name, cache.monitor_tables);
-				SaveSnapshots(metadata_manager_, cache_name, rows_bytes);
-			}
-			UpdateCacheState(cache_name, state_hash, cache);
-
-			auto end_time = std::chrono::high_resolution_clock::now();
-			auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-			status.result = RefreshResult::REFRESHED;
-			status.message = "Cache refreshed successfully";
-			status.rows_refreshed = rows;
-			status.has_rows = true;
-			status.duration_ms = static_cast<double>(duration.count());
-			status.has_duration = true;
+			return RefreshUnderLease(cache, source, state, force, "initial", start_time);
+		}
+
+		// Stays evicted until a read rehydrates it; a smart check would otherwise undo the eviction
+		if (state.IsEvicted()) {
+			status.result = RefreshResult::SKIPPED;
+			status.message = "Cache data was evicted to fit ducksync_storage_budget; the next read or a forced "
+			                 "refresh rehydrates it";
+			status.decision = "evicted";
 			return status;
 		}
 
 		if (IsTTLExpired(state, cache)) {
-			int64_t rows = ExecuteRefresh(cache, source);
-			std::string state_hash;
-			if (cache.invalidation_mode == "last_altered" || cache.invalidation_mode == "two_stage") {
-				auto source_metadata = GetSourceTableMetadata(source.secret_name, cache.monitor_tables);
-				state_hash = GenerateStateHash(source_metadata);
-			}
-			if (cache.invalidation_mode == "two_stage") {
-				auto rows_bytes = GetSourceTableRowsAndBytes(cache.metadata_secret_name, cache.monitor_tables);
-				SaveSnapshots(metadata_manager_, cache_name, rows_bytes);
-			}
-			UpdateCacheState(cache_name, state_hash, cache);
-
-			auto end_time = std::chrono::high_resolution_clock::now();
-			auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-			status.result = RefreshResult::REFRESHED;
-			status.message = "Cache refreshed successfully";
-			status.rows_refreshed = rows;
-			status.has_rows = true;
-			status.duration_ms = static_cast<double>(duration.count());
-			status.has_duration = true;
-			return status;
+			return RefreshUnderLease(cache, source, state, force, "ttl_expired", start_time);
 		}
 
 		if (cache.invalidation_mode == "ttl_only") {
 			status.result = RefreshResult::SKIPPED;
 			status.message = "Cache TTL is still valid, no refresh needed";
+			status.decision = "ttl_valid";
 			return status;
 		}
 
@@ -203,51 +265,25 @@ RefreshStatus RefreshOrchestrator::Refresh(const std::string &cache_name, bool f
 			if (!stage1_changed) {
 				status.result = RefreshResult::SKIPPED;
 				status.message = "Stage 1 rows/bytes snapshot unchanged, no refresh needed";
+				status.decision = "stage1_unchanged";
 				return status;
 			}
 
 			auto source_metadata = GetSourceTableMetadata(source.secret_name, cache.monitor_tables);
 			auto new_hash = GenerateStateHash(source_metadata);
 			if (state.HasStateHash() && new_hash == state.source_state_hash) {
-				SaveSnapshots(metadata_manager_, cache_name, current_snapshots);
+				metadata_manager_.SaveTableSnapshots(cache_name, ToTableSnapshots(current_snapshots));
 				status.result = RefreshResult::SKIPPED;
 				status.message = "Stage 1 changed but Stage 2 last_altered did not; skipping false positive refresh";
+				status.decision = "stage2_unchanged";
 				return status;
 			}
 
-			int64_t rows = ExecuteRefresh(cache, source);
-			auto refreshed_metadata = GetSourceTableMetadata(source.secret_name, cache.monitor_tables);
-			auto state_hash = GenerateStateHash(refreshed_metadata);
-			auto refreshed_snapshots = GetSourceTableRowsAndBytes(cache.metadata_secret_name, cache.monitor_tables);
-			SaveSnapshots(metadata_manager_, cache_name, refreshed_snapshots);
-			UpdateCacheState(cache_name, state_hash, cache);
-
-			auto end_time = std::chrono::high_resolution_clock::now();
-			auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-			status.result = RefreshResult::REFRESHED;
-			status.message = "Cache refreshed successfully";
-			status.rows_refreshed = rows;
-			status.has_rows = true;
-			status.duration_ms = static_cast<double>(duration.count());
-			status.has_duration = true;
-			return status;
+			return RefreshUnderLease(cache, source, state, force, "source_changed", start_time);
 		}
 
 		if (!state.HasStateHash()) {
-			int64_t rows = ExecuteRefresh(cache, source);
-			auto source_metadata = GetSourceTableMetadata(source.secret_name, cache.monitor_tables);
-			auto state_hash = GenerateStateHash(source_metadata);
-			UpdateCacheState(cache_name, state_hash, cache);
-
-			auto end_time = std::chrono::high_resolution_clock::now();
-			auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-			status.result = RefreshResult::REFRESHED;
-			status.message = "Cache refreshed successfully";
-			status.rows_refreshed = rows;
-			status.has_rows = true;
-			status.duration_ms = static_cast<double>(duration.count());
-			status.has_duration = true;
-			return status;
+			return RefreshUnderLease(cache, source, state, force, "missing_state_hash", start_time);
 		}
 
 		auto source_metadata = GetSourceTableMetadata(source.secret_name, cache.monitor_tables);
@@ -255,31 +291,328 @@ RefreshStatus RefreshOrchestrator::Refresh(const std::string &cache_name, bool f
 		if (new_hash == state.source_state_hash) {
 			status.result = RefreshResult::SKIPPED;
 			status.message = "Cache is fresh, no refresh needed";
+			status.decision = "fresh";
 			return status;
 		}
 
-		int64_t rows = ExecuteRefresh(cache, source);
-		auto refreshed_metadata = GetSourceTableMetadata(source.secret_name, cache.monitor_tables);
-		auto state_hash = GenerateStateHash(refreshed_metadata);
-		UpdateCacheState(cache_name, state_hash, cache);
-
-		auto end_time = std::chrono::high_resolution_clock::now();
-		auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-		status.result = RefreshResult::REFRESHED;
-		status.message = "Cache refreshed successfully";
-		status.rows_refreshed = rows;
-		status.has_rows = true;
-		status.duration_ms = static_cast<double>(duration.count());
-		status.has_duration = true;
+		return RefreshUnderLease(cache, source, state, force, "source_changed", start_time);
 
 	} catch (const std::exception &e) {
 		status.result = RefreshResult::ERROR;
 		status.message = std::string("Refresh failed: ") + e.what();
+		status.decision = "error";
 	}
 
 	return status;
 }
 
+RefreshStatus RefreshOrchestrator::RefreshUnderLease(const CacheDefinition &cache, const SourceDefinition &source,
+                                                     const CacheState &observed_state, bool force,
+                                                     const std::string &decision,
+                                                     std::chrono::high_resolution_clock::time_point start_time) {
+	RefreshStatus status;
+	auto lease_seconds = GetLeaseSeconds();
+	auto owner_id = RefreshCoordinator::NewLeaseOwner();
+
+	std::string holder;
+	auto wait_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(MaxValue<int64_t>(lease_seconds, 1));
+	auto poll_interval_ms = LEASE_POLL_INTERVAL_MS;
+	while (!metadata_manager_.TryAcquireRefreshLease(cache.cache_name, owner_id, lease_seconds, holder)) {
+		if (force || observed_state.HasLastRefresh()) {
+			// Another node is already refreshing; the current contents stay readable meanwhile
+			status.result = RefreshResult::LEASE_BUSY;
+			status.message = "Refresh already in progress by " + holder + ", serving current cache contents";
+			status.decision = "refresh_in_progress";
+			return status;
+		}
+
+		// Nothing to serve yet: wait for the leader to finish (or its lease to lapse) and re-check
+		while (metadata_manager_.GetRefreshLeaseHolder(cache.cache_name, holder)) {
+			if (std::chrono::steady_clock::now() >= wait_deadline) {
+				status.result = RefreshResult::LEASE_BUSY;
+				status.message = "Gave up after " + std::to_string(lease_seconds) + "s waiting for the refresh by " +
+				                 holder + "; the cache has no data yet";
+				status.decision = "lease_wait_timeout";
+				return status;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(poll_interval_ms));
+			poll_interval_ms = MinValue<int64_t>(poll_interval_ms * 2, MAX_LEASE_POLL_INTERVAL_MS);
+		}
+		CacheState current;
+		if (metadata_manager_.GetState(cache.cache_name, current) && current.HasLastRefresh()) {
+			status.result = RefreshResult::SKIPPED;
+			status.message = "Cache populated by a concurrent refresh";
+			status.decision = "concurrent_refresh";
+			return status;
+		}
+	}
+
+	try {
+		RefreshLeaseHeartbeat heartbeat(metadata_manager_, cache.cache_name, owner_id, lease_seconds);
+		// The leader may have finished between our smart check and taking the lease
+		CacheState current;
+		if (!force && metadata_manager_.GetState(cache.cache_name, current) &&
+		    current.last_refresh != observed_state.last_refresh) {
+			status.result = RefreshResult::SKIPPED;
+			status.message = "Cache was refreshed concurrently, no refresh needed";
+			status.decision = "concurrent_refresh";
+		} else {
+			status = ExecuteAndRecord(cache, source, start_time);
+			status.decision = decision;
+			CompactIfDue(cache, status);
+		}
+	} catch (...) {
+		// A failed release must not mask the refresh error; the claim then lapses on its own
+		try {
+			metadata_manager_.ReleaseRefreshLease(cache.cache_name, owner_id);
+		} catch (...) {
+		}
+		throw;
+	}
+	metadata_manager_.ReleaseRefreshLease(cache.cache_name, owner_id);
+	return status;
+}
+
+RefreshStatus RefreshOrchestrator::ExecuteAndRecord(const CacheDefinition &cache, const SourceDefinition &source,
+                                                    std::chrono::high_resolution_clock::time_point start_time) {
+	int64_t rows = ExecuteRefresh(cache, source);
+	std::string state_hash;
+	if (cache.invalidation_mode == "last_altered" || cache.invalidation_mode == "two_stage") {
+		auto source_metadata = GetSourceTableMetadata(source.secret_name, cache.monitor_tables);
+		state_hash = GenerateStateHash(source_metadata);
+	}
+	std::unordered_map<std::string, RowsBytesSnapshot> rows_bytes;
+	if (cache.invalidation_mode == "two_stage") {
+		rows_bytes = GetSourceTableRowsAndBytes(cache.metadata_secret_name, cache.monitor_tables);
+	}
+	{
+		ScopedPhaseTimer state_timer(metrics_.state_ms, "update_state");
+		if (cache.invalidation_mode == "two_stage") {
+			auto snapshots = ToTableSnapshots(rows_bytes);
+			UpdateCacheState(cache.cache_name, state_hash, cache, &snapshots);
+		} else {
+			UpdateCacheState(cache.cache_name, state_hash, cache);
+		}
+	}
+
+	auto end_time = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+	RefreshStatus status;
+	status.result = RefreshResult::REFRESHED;
+	status.message = "Cache refreshed successfully";
+	if (!split_fallback_.empty()) {
+		status.message += "; fetched as one stream: " + split_fallback_;
+	}
+	status.rows_refreshed = rows;
+	status.has_rows = true;
+	status.duration_ms = static_cast<double>(duration.count());
+	status.has_duration = true;
+	return status;
+}
+
+void RefreshOrchestrator::CompactIfDue(const CacheDefinition &cache, RefreshStatus &status) {
+	// Bloom-filtered files are already written at the target size, and merging would rewrite them
+	// without filters
+	if (!cache.bloom_filter_columns.empty()) {
+		return;
+	}
+
+	try {
+		// files_created/bytes_written are the live table's files right after the swap. Reading the policy
+		// can fail too (a bad ducksync_compaction_min_avg_file_size), which must not fail the refresh.
+		auto policy = GetCompactionPolicy(context_);
+		if (!policy.IsDue(metrics_.files_created, metrics_.bytes_written)) {
+			return;
+		}
+		ScopedPhaseTimer compact_timer(metrics_.write_ms, "compact");
+		storage_manager_.MergeAdjacentFiles(cache.cache_name, cache.source_name);
+		int64_t files = 0;
+		int64_t bytes = 0;
+		if (storage_manager_.GetTableFileStats(cache.cache_name, cache.source_name, files, bytes)) {
+			status.message += "; compacted " + std::to_string(metrics_.files_created) + " files into " +
+			                  std::to_string(files);
+		}
+	} catch (const std::exception &e) {
+		status.message += std::string("; file compaction failed: ") + e.what();
+	}
+}
+
+void RefreshOrchestrator::UpdateLocalCopies(const std::string &cache_name, RefreshStatus &status) {
+	if ((!memory_tier_ && !local_mirror_) || status.result == RefreshResult::ERROR) {
+		return;
+	}
+	auto memory_policy = GetMemoryTierPolicy(context_);
+	auto mirror_policy = GetLocalMirrorPolicy(context_);
+	if (!memory_tier_ && !mirror_policy.Enabled()) {
+		return;
+	}
+
+	CacheDefinition cache;
+	CacheState state;
+	try {
+		if (!metadata_manager_.GetCache(cache_name, cache) || !metadata_manager_.GetState(cache_name, state)) {
+			return;
+		}
+	} catch (const std::exception &) {
+		return;
+	}
+
+	if (memory_tier_ && memory_tier_->NeedsLoad(cache, state.last_refresh, memory_policy)) {
+		try {
+			ScopedPhaseTimer load_timer(metrics_.write_ms, "memory_tier_load");
+			auto table_name = storage_manager_.GetDuckLakeTableName(cache.cache_name, cache.source_name);
+			int64_t files = 0;
+			int64_t bytes = 0;
+			storage_manager_.GetTableFileStats(cache.cache_name, cache.source_name, files, bytes);
+			auto load =
+			    memory_tier_->Load(cache, table_name, state.last_refresh, memory_policy, static_cast<idx_t>(bytes));
+			switch (load) {
+			case MemoryTierLoad::LOADED:
+				status.message += "; loaded into memory tier";
+				break;
+			case MemoryTierLoad::OVER_BUDGET:
+				status.message += "; too large for ducksync_memory_tier_budget, served from DuckLake";
+				break;
+			case MemoryTierLoad::IN_PROGRESS:
+				break;
+			}
+		} catch (const std::exception &e) {
+			status.message += std::string("; memory tier load failed: ") + e.what();
+		}
+	}
+
+	// The download runs on the mirror's background thread, outside the refresh and its lease
+	if (local_mirror_ && local_mirror_->NeedsPopulate(cache.cache_name, state.last_refresh, mirror_policy)) {
+		local_mirror_->SchedulePopulate(cache, storage_manager_.GetDuckLakeName(), state.last_refresh, mirror_policy);
+		status.message += "; queued for local mirror";
+	}
+}
+
+void RefreshOrchestrator::EnforceStorageBudget(const std::string &cache_name, RefreshStatus &status) {
+	// Only a refresh that wrote new data can grow the total
+	if (!storage_budget_ || status.result != RefreshResult::REFRESHED) {
+		return;
+	}
+	auto policy = GetStorageBudgetPolicy(context_);
+	if (!policy.Enabled()) {
+		return;
+	}
+	try {
+		auto evicted = storage_budget_->Enforce(context_, policy, cache_name, GetLeaseSeconds());
+		if (!evicted.empty()) {
+			status.message += "; evicted " + StringUtil::Join(evicted, ", ") + " to fit ducksync_storage_budget";
+		}
+	} catch (const std::exception &e) {
+		status.message += std::string("; storage budget eviction failed: ") + e.what();
+	}
+}
+
+void RefreshOrchestrator::SampleMemory() {
+	auto used = BufferManager::GetBufferManager(*context_.db).GetUsedMemory();
+	metrics_.peak_memory_bytes = std::max(metrics_.peak_memory_bytes, used);
+}
+
+void RefreshOrchestrator::RecordHistory(const std::string &cache_name, RefreshTrigger trigger,
+                                        const std::string &started_at, double total_ms, const RefreshStatus &status) {
+	RefreshHistoryEntry entry;
+	entry.cache_name = cache_name;
+	entry.started_at = started_at;
+	entry.trigger = RefreshTriggerToString(trigger);
+	entry.decision = status.decision;
+	entry.result = RefreshResultToString(status.result);
+	entry.message = status.message;
+	entry.total_ms = total_ms;
+	entry.probe_ms = status.metrics.probe_ms;
+	entry.fetch_ms = status.metrics.fetch_ms;
+	entry.write_ms = status.metrics.write_ms;
+	entry.commit_ms = status.metrics.commit_ms;
+	entry.state_ms = status.metrics.state_ms;
+	entry.rows = status.has_rows ? status.rows_refreshed : 0;
+	entry.bytes_written = status.metrics.bytes_written;
+	entry.files_created = status.metrics.files_created;
+	entry.peak_memory_bytes = static_cast<int64_t>(status.metrics.peak_memory_bytes);
+
+	try {
+		metadata_manager_.AppendRefreshHistory(entry);
+	} catch (...) {
+		// History is diagnostic; never fail a refresh because it could not be recorded
+	}
+}
+
+int64_t RefreshOrchestrator::GetLeaseSeconds() {
+	Value lease_seconds;
+	if (context_.TryGetCurrentSetting("ducksync_refresh_lease_seconds", lease_seconds) && !lease_seconds.IsNull()) {
+		return lease_seconds.GetValue<int64_t>();
+	}
+	return DEFAULT_REFRESH_LEASE_SECONDS;
+}
+
+std::string RefreshOrchestrator::GetIngestTargetFileSize() {
+	Value target_file_size;
+	if (context_.TryGetCurrentSetting("ducksync_ingest_target_file_size", target_file_size) &&
+	    !target_file_size.IsNull()) {
+		return target_file_size.ToString();
+	}
+	return "";
+}
+
+idx_t RefreshOrchestrator::GetMaintenanceInterval() {
+	Value every_n;
+	if (context_.TryGetCurrentSetting("ducksync_maintenance_every_n_refreshes", every_n) && !every_n.IsNull()) {
+		return static_cast<idx_t>(MaxValue<int64_t>(every_n.GetValue<int64_t>(), 0));
+	}
+	return 0;
+}
+
+TableLayout RefreshOrchestrator::BuildTableLayout(const CacheDefinition &cache) {
+	TableLayout layout;
+	auto target_file_size = cache.target_file_size.empty() ? GetIngestTargetFileSize() : cache.target_file_size;
+	if (!target_file_size.empty()) {
+		layout.options.emplace_back("target_file_size", "'" + target_file_size + "'");
+	}
+	if (cache.row_group_size > 0) {
+		layout.options.emplace_back("parquet_row_group_size", std::to_string(cache.row_group_size));
+	}
+	if (!cache.compression.empty()) {
+		layout.options.emplace_back("parquet_compression", "'" + cache.compression + "'");
+	}
+	layout.partition_by = cache.partition_by;
+	return layout;
+}
+
+ParquetFileOptions RefreshOrchestrator::BuildParquetFileOptions(const CacheDefinition &cache,
+                                                                const vector<string> &names,
+                                                                const vector<LogicalType> &types) {
+	ParquetFileOptions options;
+	if (cache.row_group_size > 0) {
+		options.row_group_size = static_cast<idx_t>(cache.row_group_size);
+	}
+	options.compression = cache.compression;
+	options.target_file_size = cache.target_file_size.empty() ? GetIngestTargetFileSize() : cache.target_file_size;
+	for (auto &column : cache.bloom_filter_columns) {
+		for (idx_t i = 0; i < names.size(); i++) {
+			auto type = types[i].InternalType();
+			if (StringUtil::CIEquals(names[i], column) && type == PhysicalType::VARCHAR) {
+				options.string_bloom_filters = true;
+			}
+		}
+	}
+	return options;
+}
+
+void RefreshOrchestrator::CheckBloomFilterColumns(const CacheDefinition &cache, const vector<string> &names) {
+	for (auto &column : cache.bloom_filter_columns) {
+		bool found = false;
+		for (auto &name : names) {
+			found = found || StringUtil::CIEquals(name, column);
+		}
+		if (!found) {
+			throw InvalidInputException("bloom_filter_columns: column '%s' is not returned by the source query of '%s'",
+			                            column, cache.cache_name);
+		}
+	}
+}
+
 bool RefreshOrchestrator::IsTTLExpired(const CacheState &state, const CacheDefinition &cache) {
 	// If no TTL set, never expires
 	if (!cache.has_ttl) {
@@ -310,6 +643,7 @@ bool RefreshOrchestrator::IsTTLExpired(const CacheState &state, const CacheDefin
 std::unordered_map<std::string, std::string>
 RefreshOrchestrator::GetSourceTableMetadata(const std::string &secret_name,
                                             const std::vector<std::string> &monitor_tables) {
+	ScopedPhaseTimer probe_timer(metrics_.probe_ms, "probe_metadata");
 	std::unordered_map<std::string, std::string> metadata;
 	auto conn = MakeConnection(context_);
 
@@ -323,8 +657,8 @@ RefreshOrchestrator::GetSourceTableMetadata(const std::string &secret_name,
 		         << "AND table_name = ''" << EscapeSqlStringLiteral(parsed.table_name) << "''";
 
 		std::ostringstream query;
-		query << "SELECT * FROM snowflake_query('" << sf_query.str() << "', '" << EscapeSqlStringLiteral(secret_name)
-		      << "');";
+		query << "SELECT * FROM " << source_function_ << "('" << sf_query.str() << "', '"
+		      << EscapeSqlStringLiteral(secret_name) << "');";
 
 		auto result = conn.Query(query.str());
 		if (result->HasError()) {
@@ -347,6 +681,7 @@ RefreshOrchestrator::GetSourceTableMetadata(const std::string &secret_name,
 std::unordered_map<std::string, RowsBytesSnapshot>
 RefreshOrchestrator::GetSourceTableRowsAndBytes(const std::string &metadata_secret_name,
                                                 const std::vector<std::string> &monitor_tables) {
+	ScopedPhaseTimer probe_timer(metrics_.probe_ms, "probe_rows_bytes");
 	std::unordered_map<std::string, RowsBytesSnapshot> snapshots;
 	auto conn = MakeConnection(context_);
 
@@ -358,7 +693,7 @@ RefreshOrchestrator::GetSourceTableRowsAndBytes(const std::string &metadata_secr
 		                << parsed.database_name << "." << parsed.schema_name;
 
 		std::ostringstream query;
-		query << "SELECT * FROM snowflake_query('" << show_tables_sql.str() << "', '"
+		query << "SELECT * FROM " << source_function_ << "('" << show_tables_sql.str() << "', '"
 		      << EscapeSqlStringLiteral(metadata_secret_name) << "');";
 
 		auto result = conn.Query(query.str());
@@ -424,25 +759,178 @@ std::string RefreshOrchestrator::GenerateStateHash(const std::unordered_map<std:
 	return hex.str();
 }
 
-int64_t RefreshOrchestrator::ExecuteRefresh(const CacheDefinition &cache, const SourceDefinition &source) {
-	auto conn = MakeConnection(context_);
+// Wrap a Snowflake SQL statement in the source function
+static std::string SnowflakeQuerySQL(const std::string &function, const std::string &query,
+                                     const std::string &secret_name) {
+	return "SELECT * FROM " + function + "('" + EscapeSqlStringLiteral(query) + "', '" +
+	       EscapeSqlStringLiteral(secret_name) + "');";
+}
 
-	// Escape single quotes in source query for snowflake_query()
-	std::string escaped_query;
-	for (char c : cache.source_query) {
-		if (c == '\'') {
-			escaped_query += "''";
+// Split boundaries for an integer split column: stream i covers [bounds[i-1], bounds[i]), with the
+// first stream open below (and taking NULLs) and the last open above, so rows that arrive after
+// the bounds probe are still fetched exactly once.
+static vector<string> IntegerRangePredicates(const std::string &column, int64_t lo, int64_t hi, idx_t streams) {
+	auto span = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo);
+	if (span < streams) {
+		streams = static_cast<idx_t>(span) + 1;
+	}
+	auto step = span / streams + 1;
+
+	vector<string> predicates;
+	for (idx_t i = 0; i < streams; i++) {
+		auto lower = std::to_string(static_cast<int64_t>(static_cast<uint64_t>(lo) + i * step));
+		auto upper = std::to_string(static_cast<int64_t>(static_cast<uint64_t>(lo) + (i + 1) * step));
+		if (streams == 1) {
+			predicates.push_back("TRUE");
+		} else if (i == 0) {
+			predicates.push_back("(" + column + " < " + upper + " OR " + column + " IS NULL)");
+		} else if (i + 1 == streams) {
+			predicates.push_back(column + " >= " + lower);
 		} else {
-			escaped_query += c;
+			predicates.push_back(column + " >= " + lower + " AND " + column + " < " + upper);
 		}
 	}
+	return predicates;
+}
+
+// The split column as a quoted Snowflake identifier. A bare name resolves the way Snowflake resolves it
+// unquoted (upper case); a name given already quoted is kept as is.
+static std::string QuoteSplitColumn(const std::string &column) {
+	static const std::regex BARE_IDENTIFIER(R"([A-Za-z_][A-Za-z0-9_$]*)");
+	if (column.size() >= 2 && column.front() == '"' && column.back() == '"') {
+		return column;
+	}
+	if (std::regex_match(column, BARE_IDENTIFIER)) {
+		return KeywordHelper::WriteQuoted(StringUtil::Upper(column), '"');
+	}
+	return KeywordHelper::WriteQuoted(column, '"');
+}
+
+static std::string EscapeRegex(const std::string &text) {
+	static const std::string SPECIAL = "\\^$.|?*+()[]{}";
+	std::string escaped;
+	for (auto c : text) {
+		if (SPECIAL.find(c) != std::string::npos) {
+			escaped += '\\';
+		}
+		escaped += c;
+	}
+	return escaped;
+}
+
+// Pin every reference to a monitored table in the source query to one point in time, so that split
+// streams issued on separate connections read the same snapshot. Returns false when the query names
+// none of the monitored tables, in which case nothing can be pinned.
+static bool PinMonitoredTables(std::string &query, const vector<string> &monitor_tables, const std::string &at) {
+	bool pinned = false;
+	for (auto &table : monitor_tables) {
+		// Whole qualified name only: not part of a longer name, and not already time-travelled or a call
+		std::regex reference("(^|[^A-Za-z0-9_$.\"])(" + EscapeRegex(table) + ")" +
+		                         "(?![A-Za-z0-9_$.\"(])(?!\\s+(AT|BEFORE)\\s*\\()",
+		                     std::regex::icase);
+		auto rewritten = std::regex_replace(query, reference, "$1$2 AT(TIMESTAMP => " + at + ")");
+		pinned = pinned || rewritten != query;
+		query = std::move(rewritten);
+	}
+	return pinned;
+}
+
+static bool IsIntegerSplitValue(const Value &value) {
+	auto &type = value.type();
+	return type.IsIntegral() || (type.id() == LogicalTypeId::DECIMAL && DecimalType::GetScale(type) == 0);
+}
+
+idx_t RefreshOrchestrator::AutoParallelism(int64_t source_rows) {
+	if (source_rows <= 0) {
+		return 1;
+	}
+	auto streams = static_cast<idx_t>((source_rows + ROWS_PER_EXTRACT_STREAM - 1) / ROWS_PER_EXTRACT_STREAM);
+	return MinValue<idx_t>(MaxValue<idx_t>(streams, 1), MAX_AUTO_EXTRACT_STREAMS);
+}
+
+vector<string> RefreshOrchestrator::BuildSourceQueries(const CacheDefinition &cache, const SourceDefinition &source) {
+	if (cache.split_column.empty() || cache.parallelism == 1) {
+		return {SnowflakeQuerySQL(source_function_, cache.source_query, source.secret_name)};
+	}
+
+	// Snowflake rejects a trailing semicolon inside a subquery
+	auto source_query = cache.source_query;
+	StringUtil::RTrim(source_query);
+	while (!source_query.empty() && source_query.back() == ';') {
+		source_query.pop_back();
+		StringUtil::RTrim(source_query);
+	}
+	auto column = QuoteSplitColumn(cache.split_column);
+
+	// Bounds of the split column and the source's clock in one round-trip; the row count is only
+	// needed to pick the number of streams automatically
+	bool auto_streams = cache.parallelism <= 0;
+	std::ostringstream bounds_sql;
+	bounds_sql << "SELECT MIN(" << column << "), MAX(" << column << "), CURRENT_TIMESTAMP::VARCHAR"
+	           << (auto_streams ? ", COUNT(*)" : "") << " FROM (" << source_query << ") AS ducksync_split";
+	auto conn = MakeConnection(context_);
+	unique_ptr<MaterializedQueryResult> bounds;
+	{
+		ScopedPhaseTimer probe_timer(metrics_.probe_ms, "probe_split_bounds");
+		bounds = conn.Query(SnowflakeQuerySQL(source_function_, bounds_sql.str(), source.secret_name));
+	}
+	if (bounds->HasError()) {
+		throw IOException("Failed to probe split column " + cache.split_column + ": " + bounds->GetError());
+	}
+	if (bounds->RowCount() == 0) {
+		return {SnowflakeQuerySQL(source_function_, cache.source_query, source.secret_name)};
+	}
+
+	auto lo = bounds->GetValue(0, 0);
+	auto hi = bounds->GetValue(1, 0);
+	auto source_now = bounds->GetValue(2, 0);
+	idx_t streams = auto_streams ? AutoParallelism(bounds->GetValue(3, 0).GetValue<int64_t>())
+	                             : static_cast<idx_t>(cache.parallelism);
+	if (streams <= 1 || lo.IsNull() || hi.IsNull() || source_now.IsNull()) {
+		return {SnowflakeQuerySQL(source_function_, cache.source_query, source.secret_name)};
+	}
+
+	// Every stream reads the monitored tables as of the bounds probe. A query that names none of them
+	// cannot be pinned and is fetched as one stream, which is consistent by itself.
+	auto at = "'" + EscapeSqlStringLiteral(source_now.ToString()) + "'::TIMESTAMP_LTZ";
+	if (!PinMonitoredTables(source_query, cache.monitor_tables, at)) {
+		split_fallback_ = "the source query names no monitor_tables entry as listed, so the streams could not be "
+		                  "pinned to one snapshot";
+		return {SnowflakeQuerySQL(source_function_, cache.source_query, source.secret_name)};
+	}
+
+	// Key ranges for integer columns; hash buckets for anything else (strings, UUIDs, skewed keys
+	// out of BIGINT range)
+	vector<string> predicates;
+	Value lo_bigint;
+	Value hi_bigint;
+	string cast_error;
+	if (IsIntegerSplitValue(lo) && lo.DefaultTryCastAs(LogicalType::BIGINT, lo_bigint, &cast_error) &&
+	    hi.DefaultTryCastAs(LogicalType::BIGINT, hi_bigint, &cast_error)) {
+		predicates = IntegerRangePredicates(column, lo_bigint.GetValue<int64_t>(), hi_bigint.GetValue<int64_t>(),
+		                                    streams);
+	} else {
+		for (idx_t i = 0; i < streams; i++) {
+			predicates.push_back("MOD(ABS(HASH(" + column + ")), " + std::to_string(streams) + ") = " +
+			                     std::to_string(i));
+		}
+	}
+
+	vector<string> queries;
+	for (auto &predicate : predicates) {
+		auto range_query = "SELECT * FROM (" + source_query + ") AS ducksync_split WHERE " + predicate;
+		queries.push_back(SnowflakeQuerySQL(source_function_, range_query, source.secret_name));
+	}
+	return queries;
+}
+
+int64_t RefreshOrchestrator::ExecuteRefresh(const CacheDefinition &cache, const SourceDefinition &source) {
+	auto conn = MakeConnection(context_);
 
 	if (!storage_manager_.IsAttached()) {
 		throw IOException("DuckLake storage not attached");
 	}
 
-	std::string table_name = storage_manager_.GetDuckLakeTableName(cache.cache_name, cache.source_name);
-
 	// Create schema if needed
 	std::ostringstream create_schema;
 	create_schema << "CREATE SCHEMA IF NOT EXISTS " << storage_manager_.GetDuckLakeName() << "." << cache.source_name
@@ -452,29 +940,118 @@ int64_t RefreshOrchestrator::ExecuteRefresh(const CacheDefinition &cache, const
 		throw IOException("Failed to create schema: " + schema_result->GetError());
 	}
 
-	// Single Snowflake query: CREATE TABLE AS SELECT (no double fetch)
-	std::ostringstream create_table;
-	create_table << "CREATE OR REPLACE TABLE " << table_name << " AS "
-	             << "SELECT * FROM snowflake_query('" << escaped_query << "', '" << source.secret_name << "');";
+	// Snowflake queries streamed into DuckLake (no double fetch). Each producer thread pulls chunks
+	// only as fast as the writer drains them, so at most the ingest memory budget is held between
+	// fetch and write (sort_by aside, see below). Readers keep querying the previous version until the
+	// write commits.
+	auto table_layout = BuildTableLayout(cache);
+	auto channel = std::make_shared<IngestChannel>(GetIngestMemoryBudget(context_));
+	idx_t channel_id = 0;
+	int64_t rows = 0;
+	bool staged = true;
+	try {
+		channel->Start(*context_.db, BuildSourceQueries(cache, source));
+		channel_id = IngestChannelRegistry::Register(channel);
+
+		// Sorted writes give each row group a narrow min/max range, so zone maps can skip them. The sort
+		// is blocking: it drains the whole channel before the first row is written, so the ingest budget
+		// does not bound it. DuckDB's sort is bounded by memory_limit instead and spills the rest to
+		// temp_directory.
+		std::ostringstream scan_sql;
+		scan_sql << "SELECT * FROM ducksync_ingest_scan(" << channel_id << ")";
+		if (!cache.sort_by.empty()) {
+			scan_sql << " ORDER BY " << cache.sort_by;
+		}
 
-	auto create_result = conn.Query(create_table.str());
-	if (create_result->HasError()) {
-		throw IOException("Failed to create cache table: " + create_result->GetError());
+		// Unchanged columns: write straight into the live table in one transaction, so it keeps its
+		// identity and snapshot history. Bloom-filtered files bypass DuckLake's writer and are registered
+		// with the table instead, in the same kind of transaction.
+		staged = !storage_manager_.HasSameColumns(cache.cache_name, cache.source_name, channel->Names(),
+		                                          channel->Types());
+		if (!cache.bloom_filter_columns.empty()) {
+			CheckBloomFilterColumns(cache, channel->Names());
+			if (staged) {
+				storage_manager_.CreateStagingTable(cache.cache_name, cache.source_name, channel->Names(),
+				                                    channel->Types(), table_layout);
+			}
+			TraceScope write_span("write");
+			std::vector<std::string> files;
+			auto copy_start = std::chrono::high_resolution_clock::now();
+			rows = storage_manager_.WriteBloomFilteredFiles(cache.cache_name, cache.source_name, scan_sql.str(),
+			                                                BuildParquetFileOptions(cache, channel->Names(),
+			                                                                        channel->Types()),
+			                                                files);
+			metrics_.write_ms +=
+			    std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - copy_start)
+			        .count();
+			auto timings = staged ? storage_manager_.AddStagedFiles(cache.cache_name, cache.source_name, files)
+			                      : storage_manager_.ReplaceTableFiles(cache.cache_name, cache.source_name, files,
+			                                                           table_layout);
+			// Registering files with the staging table is part of the write; the swap below commits it
+			metrics_.write_ms += timings.write_ms + (staged ? timings.commit_ms : 0);
+			metrics_.commit_ms += staged ? 0 : timings.commit_ms;
+		} else if (!staged) {
+			TraceScope write_span("write");
+			auto timings = storage_manager_.ReplaceTableContents(cache.cache_name, cache.source_name, scan_sql.str(),
+			                                                     table_layout, rows);
+			metrics_.write_ms += timings.write_ms;
+			metrics_.commit_ms += timings.commit_ms;
+		} else {
+			storage_manager_.CreateStagingTable(cache.cache_name, cache.source_name, channel->Names(),
+			                                    channel->Types(), table_layout);
+			unique_ptr<MaterializedQueryResult> insert_result;
+			{
+				ScopedPhaseTimer write_timer(metrics_.write_ms, "write");
+				insert_result = conn.Query("INSERT INTO " +
+				                           storage_manager_.GetStagingTableName(cache.cache_name, cache.source_name) +
+				                           " " + scan_sql.str() + ";");
+			}
+			if (insert_result->HasError()) {
+				throw IOException("Failed to create cache table: " + insert_result->GetError());
+			}
+			if (insert_result->RowCount() > 0) {
+				rows = insert_result->GetValue(0, 0).GetValue<int64_t>();
+			}
+		}
+		channel->Finish();
+	} catch (...) {
+		channel->Cancel();
+		IngestChannelRegistry::Unregister(channel_id);
+		storage_manager_.DropStagingTable(cache.cache_name, cache.source_name);
+		throw;
+	}
+	IngestChannelRegistry::Unregister(channel_id);
+	// Fetch time overlaps the write; it is reported separately so a slow source stands out
+	metrics_.fetch_ms += channel->FetchMs();
+	metrics_.peak_memory_bytes = std::max(metrics_.peak_memory_bytes, channel->PeakBufferMemory());
+	SampleMemory();
+
+	if (staged) {
+		try {
+			auto swap_timings = storage_manager_.SwapStagedTable(cache.cache_name, cache.source_name);
+			metrics_.write_ms += swap_timings.write_ms;
+			metrics_.commit_ms += swap_timings.commit_ms;
+		} catch (...) {
+			storage_manager_.DropStagingTable(cache.cache_name, cache.source_name);
+			throw;
+		}
+		SampleMemory();
 	}
 
-	// Count rows from the local cache table (no Snowflake round-trip)
-	std::ostringstream count_sql;
-	count_sql << "SELECT COUNT(*) FROM " << table_name << ";";
-	auto count_result = conn.Query(count_sql.str());
-	if (!count_result->HasError() && count_result->RowCount() > 0) {
-		return count_result->GetValue(0, 0).GetValue<int64_t>();
+	// The refresh replaced every row, so the table's current files are exactly what it wrote
+	int64_t files = 0;
+	int64_t bytes = 0;
+	if (storage_manager_.GetTableFileStats(cache.cache_name, cache.source_name, files, bytes)) {
+		metrics_.files_created = files;
+		metrics_.bytes_written = bytes;
 	}
 
-	return 0;
+	return rows;
 }
 
 void RefreshOrchestrator::UpdateCacheState(const std::string &cache_name, const std::string &state_hash,
-                                           const CacheDefinition &cache) {
+                                           const CacheDefinition &cache,
+                                           const std::unordered_map<std::string, TableSnapshot> *snapshots) {
 	CacheState state;
 	state.cache_name = cache_name;
 	state.source_state_hash = state_hash;
@@ -496,7 +1073,7 @@ void RefreshOrchestrator::UpdateCacheState(const std::string &cache_name, const
 		}
 	}
 
-	metadata_manager_.UpdateState(state);
+	metadata_manager_.UpdateState(state, snapshots);
 }
 
 } // namespace duckdb
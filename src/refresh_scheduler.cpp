@@ -0,0 +1,321 @@
+#include "refresh_scheduler.hpp"
+#include "refresh_orchestrator.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/common/exception.hpp"
+#include <algorithm>
+#include <unordered_set>
+
+namespace duckdb {
+
+RefreshScheduler::RefreshScheduler(DatabaseInstance &db, DuckSyncMetadataManager &metadata_manager,
+                                   DuckSyncStorageManager &storage_manager, RefreshSchedulerConfig config,
+                                   MaintenanceWorker *maintenance, MemoryTier *memory_tier,
+                                   LocalMirror *local_mirror, StorageBudget *storage_budget)
+    : config_(config), db_(db.shared_from_this()), metadata_manager_(metadata_manager),
+      storage_manager_(storage_manager), maintenance_(maintenance), memory_tier_(memory_tier),
+      local_mirror_(local_mirror), storage_budget_(storage_budget), rng_(std::random_device()()) {
+	if (config_.worker_threads == 0) {
+		config_.worker_threads = 1;
+	}
+}
+
+RefreshScheduler::~RefreshScheduler() {
+	Stop();
+}
+
+void RefreshScheduler::Start() {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (running_) {
+		return;
+	}
+	stopping_ = false;
+	next_rescan_ = SchedulerClock::now();
+	for (idx_t i = 0; i < config_.worker_threads; i++) {
+		workers_.emplace_back(&RefreshScheduler::WorkerLoop, this);
+	}
+	running_ = true;
+}
+
+bool RefreshScheduler::Stop() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (!running_) {
+			return true;
+		}
+		stopping_ = true;
+	}
+	cv_.notify_all();
+
+	// Workers finish the refresh they are running before exiting
+	bool joined = true;
+	for (auto &worker : workers_) {
+		if (!worker.joinable()) {
+			continue;
+		}
+		if (worker.get_id() == std::this_thread::get_id()) {
+			worker.detach();
+			joined = false;
+		} else {
+			worker.join();
+		}
+	}
+	workers_.clear();
+
+	std::lock_guard<std::mutex> guard(lock_);
+	queue_ = decltype(queue_)();
+	schedules_.clear();
+	running_ = false;
+	return joined;
+}
+
+std::vector<ScheduledCacheInfo> RefreshScheduler::GetStatus() {
+	std::vector<ScheduledCacheInfo> rows;
+	std::lock_guard<std::mutex> guard(lock_);
+
+	auto now = SchedulerClock::now();
+	for (auto &entry : schedules_) {
+		auto &schedule = entry.second;
+		ScheduledCacheInfo info;
+		info.cache_name = entry.first;
+		info.running = schedule.running;
+		info.next_run_seconds = std::chrono::duration<double>(schedule.due - now).count();
+		info.runs = schedule.runs;
+		info.last_result = schedule.last_result;
+		info.last_message = schedule.last_message;
+		info.last_duration_ms = schedule.last_duration_ms;
+		info.has_last_run = schedule.has_last_run;
+		rows.push_back(info);
+	}
+
+	// Running caches first, then queued caches in deadline order
+	std::sort(rows.begin(), rows.end(), [](const ScheduledCacheInfo &left, const ScheduledCacheInfo &right) {
+		if (left.running != right.running) {
+			return left.running;
+		}
+		return left.next_run_seconds < right.next_run_seconds;
+	});
+	return rows;
+}
+
+void RefreshScheduler::WorkerLoop() {
+	std::unique_lock<std::mutex> lock(lock_);
+	while (!stopping_) {
+		auto now = SchedulerClock::now();
+		if (now >= next_rescan_) {
+			Rescan(lock);
+			continue;
+		}
+
+		if (queue_.empty()) {
+			cv_.wait_until(lock, next_rescan_);
+			continue;
+		}
+
+		auto top = queue_.top();
+		auto entry = schedules_.find(top.cache_name);
+		if (entry == schedules_.end() || entry->second.generation != top.generation || entry->second.running) {
+			// Superseded entry: the cache was dropped or rescheduled since this entry was pushed
+			queue_.pop();
+			continue;
+		}
+
+		if (top.due > now) {
+			cv_.wait_until(lock, std::min(top.due, next_rescan_));
+			continue;
+		}
+
+		queue_.pop();
+		RunCache(lock, top.cache_name);
+	}
+}
+
+void RefreshScheduler::Rescan(std::unique_lock<std::mutex> &lock) {
+	// Claim this rescan before releasing the lock so other workers do not repeat it
+	next_rescan_ = SchedulerClock::now() + std::chrono::seconds(config_.rescan_interval_seconds);
+
+	std::unordered_set<std::string> tracked;
+	for (auto &entry : schedules_) {
+		tracked.insert(entry.first);
+	}
+	lock.unlock();
+
+	// Catalog and state lookups run without holding the scheduler lock
+	std::vector<CacheDefinition> caches;
+	std::vector<std::pair<std::string, double>> discovered;
+	std::unordered_set<std::string> listed;
+	bool listed_all = false;
+	{
+		// Released before lock_ is taken again: the database may close with it
+		auto db = db_.lock();
+		try {
+			if (db) {
+				caches = metadata_manager_.ListCaches();
+				for (auto &cache : caches) {
+					listed.insert(cache.cache_name);
+					if (tracked.count(cache.cache_name)) {
+						continue;
+					}
+					double delay_seconds;
+					if (ComputeNextDelay(cache, delay_seconds)) {
+						discovered.emplace_back(cache.cache_name, delay_seconds);
+					}
+				}
+				listed_all = true;
+			}
+		} catch (...) {
+			// Metadata unavailable; keep the current schedule and retry at the next rescan
+		}
+	}
+
+	lock.lock();
+	if (!listed_all) {
+		return;
+	}
+	for (auto &entry : discovered) {
+		if (schedules_.count(entry.first)) {
+			continue;
+		}
+		auto &schedule = schedules_[entry.first];
+		Enqueue(entry.first, schedule, entry.second);
+	}
+
+	// Forget caches that were deleted; a running refresh drops its own entry when it completes
+	for (auto it = schedules_.begin(); it != schedules_.end();) {
+		if (!listed.count(it->first) && !it->second.running) {
+			it = schedules_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void RefreshScheduler::RunCache(std::unique_lock<std::mutex> &lock, const std::string &cache_name) {
+	auto run_start = SchedulerClock::now();
+	{
+		auto &schedule = schedules_[cache_name];
+		schedule.running = true;
+		schedule.last_run_start = run_start;
+	}
+	lock.unlock();
+
+	RefreshStatus status;
+	CacheDefinition cache;
+	bool schedulable = false;
+	double delay_seconds = static_cast<double>(config_.probe_interval_seconds);
+	try {
+		// Destroyed before lock_ is taken again, on success and failure alike: the database may close with it
+		auto db = db_.lock();
+		if (db) {
+			Connection conn(*db);
+			RefreshOrchestrator orchestrator(*conn.context, metadata_manager_, storage_manager_, maintenance_,
+			                                 memory_tier_, local_mirror_, storage_budget_);
+			status = orchestrator.Refresh(cache_name, false, RefreshTrigger::SCHEDULER);
+			if (metadata_manager_.GetCache(cache_name, cache)) {
+				schedulable = ComputeNextDelay(cache, delay_seconds);
+			}
+		} else {
+			status.message = "Database closed";
+		}
+	} catch (const std::exception &e) {
+		// Keep the cache scheduled; the minimum interval below throttles retries
+		status.result = RefreshResult::ERROR;
+		status.message = std::string("Scheduled refresh failed: ") + e.what();
+		schedulable = true;
+	}
+	auto elapsed_ms = std::chrono::duration<double, std::milli>(SchedulerClock::now() - run_start).count();
+
+	lock.lock();
+	auto entry = schedules_.find(cache_name);
+	if (entry == schedules_.end()) {
+		return;
+	}
+	auto &schedule = entry->second;
+	schedule.running = false;
+	schedule.has_last_run = true;
+	schedule.runs++;
+	schedule.last_result = RefreshResultToString(status.result);
+	schedule.last_message = status.message;
+	schedule.last_duration_ms = elapsed_ms;
+
+	if (!schedulable || stopping_) {
+		schedules_.erase(entry);
+		return;
+	}
+
+	// Enforce the minimum interval between two runs of the same cache
+	auto since_start = std::chrono::duration<double>(SchedulerClock::now() - schedule.last_run_start).count();
+	delay_seconds = std::max(delay_seconds, static_cast<double>(config_.min_refresh_interval_seconds) - since_start);
+	Enqueue(cache_name, schedule, delay_seconds);
+}
+
+bool RefreshScheduler::ComputeNextDelay(const CacheDefinition &cache, double &delay_seconds) {
+	if (cache.invalidation_mode == "manual") {
+		return false;
+	}
+	if (cache.invalidation_mode == "ttl_only" && !cache.has_ttl) {
+		// Nothing would ever trigger a refresh
+		return false;
+	}
+
+	CacheState state;
+	bool has_state = metadata_manager_.GetState(cache.cache_name, state);
+	if (has_state && state.IsEvicted()) {
+		// Rehydrated by its next read; picked up again by a later rescan
+		return false;
+	}
+	if (!has_state || !state.HasLastRefresh()) {
+		delay_seconds = 0;
+		return true;
+	}
+
+	double delay = static_cast<double>(config_.probe_interval_seconds);
+	if (cache.has_ttl) {
+		double until_expiry = state.HasExpiresAt() ? SecondsUntil(state.expires_at) : 0;
+		if (cache.invalidation_mode == "ttl_only") {
+			// Source changes are ignored in ttl_only mode, so probing before expiry is wasted work
+			delay = until_expiry;
+		} else {
+			delay = std::min(delay, until_expiry);
+		}
+	}
+	delay_seconds = std::max(delay, 0.0);
+	return true;
+}
+
+double RefreshScheduler::SecondsUntil(const std::string &timestamp) {
+	auto db = db_.lock();
+	if (!db) {
+		return 0;
+	}
+	Connection conn(*db);
+	auto result = conn.Query("SELECT (epoch_ms(TIMESTAMP '" + timestamp +
+	                         "') - epoch_ms(CURRENT_TIMESTAMP::TIMESTAMP)) / 1000.0;");
+	if (result->HasError() || result->RowCount() == 0 || result->GetValue(0, 0).IsNull()) {
+		return 0; // Err on the side of probing now
+	}
+	return result->GetValue(0, 0).GetValue<double>();
+}
+
+void RefreshScheduler::Enqueue(const std::string &cache_name, CacheSchedule &schedule, double delay_seconds) {
+	delay_seconds = ApplyJitter(std::max(delay_seconds, 0.0));
+	schedule.generation++;
+	schedule.due = SchedulerClock::now() + std::chrono::duration_cast<SchedulerClock::duration>(
+	                                           std::chrono::duration<double>(delay_seconds));
+	queue_.push(QueueEntry {schedule.due, cache_name, schedule.generation});
+	cv_.notify_one();
+}
+
+double RefreshScheduler::ApplyJitter(double delay_seconds) {
+	if (config_.jitter <= 0) {
+		return delay_seconds;
+	}
+	// Due-now caches are spread over a fraction of the minimum interval so a freshly started
+	// scheduler does not fire every never-refreshed cache at the same instant
+	double base = delay_seconds > 0 ? delay_seconds : static_cast<double>(config_.min_refresh_interval_seconds);
+	std::uniform_real_distribution<double> distribution(0.0, config_.jitter);
+	return delay_seconds + base * distribution(rng_);
+}
+
+} // namespace duckdb
@@ -0,0 +1,129 @@
+#include "source_emulator.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include <atomic>
+#include <mutex>
+#include <regex>
+#include <unordered_map>
+#include <vector>
+
+namespace duckdb {
+
+struct EmulatedTable {
+	std::string catalog;
+	std::string schema;
+	std::string name;
+	int64_t rows = 0;
+	int64_t bytes = 0;
+	timestamp_t last_altered;
+};
+
+// Row count and definition of a table when its last_altered was set
+struct SeenTable {
+	std::string signature;
+	timestamp_t last_altered;
+};
+
+// Process-wide, like the warehouse: every connection sees the same last_altered for a table
+static std::mutex emulator_lock;
+static std::unordered_map<std::string, SeenTable> seen_tables;
+static std::atomic<idx_t> emulated_queries {0};
+
+static const std::regex SHOW_TABLES_PATTERN(R"(^\s*SHOW\s+TABLES\s+LIKE\s+'((?:[^']|'')*)'\s+IN\s+SCHEMA\s+)"
+                                             R"(([A-Za-z_][A-Za-z0-9_$]*)\.([A-Za-z_][A-Za-z0-9_$]*)\s*;?\s*$)",
+                                             std::regex::icase);
+static const std::regex INFORMATION_SCHEMA_PATTERN(R"(\b([A-Za-z_][A-Za-z0-9_$]*)\.information_schema\.tables\b)",
+                                                   std::regex::icase);
+// Split streams pin their tables with AT(TIMESTAMP => ...); attached databases have no history to travel in
+static const std::regex TIME_TRAVEL_PATTERN(R"(\s+AT\(TIMESTAMP => '(?:[^']|'')*'::TIMESTAMP_LTZ\))");
+
+static std::string Quote(const std::string &text) {
+	return KeywordHelper::WriteQuoted(text, '\'');
+}
+
+static std::vector<EmulatedTable> ListTables(ClientContext &context, const std::string &database) {
+	Connection conn(*context.db);
+	auto result = conn.Query("SELECT schema_name, table_name, estimated_size, column_count, sql FROM duckdb_tables() "
+	                         "WHERE lower(database_name) = lower(" +
+	                         Quote(database) + ") ORDER BY schema_name, table_name");
+	if (result->HasError()) {
+		throw IOException("Emulated source: failed to list the tables of '" + database + "': " + result->GetError());
+	}
+
+	std::vector<EmulatedTable> tables;
+	auto now = Timestamp::GetCurrentTimestamp();
+	std::lock_guard<std::mutex> guard(emulator_lock);
+	for (idx_t row = 0; row < result->RowCount(); row++) {
+		EmulatedTable table;
+		table.catalog = StringUtil::Upper(database);
+		table.schema = StringUtil::Upper(result->GetValue(0, row).ToString());
+		table.name = StringUtil::Upper(result->GetValue(1, row).ToString());
+		auto rows = result->GetValue(2, row);
+		auto columns = result->GetValue(3, row);
+		table.rows = rows.IsNull() ? 0 : rows.GetValue<int64_t>();
+		table.bytes = table.rows * (columns.IsNull() ? 0 : columns.GetValue<int64_t>()) * 8;
+
+		// The definition covers column changes; the row count covers inserts and deletes
+		auto signature = std::to_string(table.rows) + "|" + result->GetValue(4, row).ToString();
+		auto &seen = seen_tables[table.catalog + "." + table.schema + "." + table.name];
+		if (seen.signature != signature) {
+			seen.signature = signature;
+			seen.last_altered = now;
+		}
+		table.last_altered = seen.last_altered;
+		tables.push_back(std::move(table));
+	}
+	return tables;
+}
+
+// Subquery with the columns of information_schema.tables the emulator answers. The typed NULL row
+// keeps the column types when the database has no tables.
+static std::string TablesRelation(const std::vector<EmulatedTable> &tables) {
+	std::string relation = "(SELECT * FROM (VALUES (NULL::VARCHAR, NULL::VARCHAR, NULL::VARCHAR, NULL::TIMESTAMP, "
+	                       "NULL::BIGINT, NULL::BIGINT)";
+	for (auto &table : tables) {
+		relation += ", (" + Quote(table.catalog) + ", " + Quote(table.schema) + ", " + Quote(table.name) +
+		            ", TIMESTAMP " + Quote(Timestamp::ToString(table.last_altered)) + ", " +
+		            std::to_string(table.rows) + ", " + std::to_string(table.bytes) + ")";
+	}
+	relation += ") AS ducksync_tables(table_catalog, table_schema, table_name, last_altered, row_count, bytes) "
+	            "WHERE table_name IS NOT NULL)";
+	return relation;
+}
+
+std::string SourceEmulator::Translate(ClientContext &context, const std::string &sql) {
+	emulated_queries.fetch_add(1, std::memory_order_relaxed);
+	std::smatch match;
+	if (std::regex_match(sql, match, SHOW_TABLES_PATTERN)) {
+		// The pattern is still a quoted literal, so it is spliced back as is; SHOW TABLES LIKE ignores case
+		return "SELECT table_name AS name, table_catalog AS database_name, table_schema AS schema_name, "
+		       "'TABLE' AS kind, row_count AS \"rows\", bytes FROM " +
+		       TablesRelation(ListTables(context, match[2].str())) +
+		       " AS ducksync_show WHERE table_schema = " + Quote(StringUtil::Upper(match[3].str())) +
+		       " AND table_name ILIKE '" + match[1].str() + "'";
+	}
+
+	// Anything else runs against the attached databases, with information_schema.tables substituted
+	std::string translated;
+	std::string rest = std::regex_replace(sql, TIME_TRAVEL_PATTERN, "");
+	while (std::regex_search(rest, match, INFORMATION_SCHEMA_PATTERN)) {
+		translated += match.prefix().str() + TablesRelation(ListTables(context, match[1].str()));
+		rest = match.suffix().str();
+	}
+	return translated + rest;
+}
+
+idx_t SourceEmulator::QueryCount() {
+	return emulated_queries.load(std::memory_order_relaxed);
+}
+
+void SourceEmulator::Reset() {
+	std::lock_guard<std::mutex> guard(emulator_lock);
+	seen_tables.clear();
+}
+
+} // namespace duckdb
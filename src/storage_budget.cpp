@@ -0,0 +1,157 @@
+#include "storage_budget.hpp"
+#include "refresh_coordinator.hpp"
+#include "cleanup_manager.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/common/exception.hpp"
+#include <algorithm>
+
+namespace duckdb {
+
+StorageBudgetPolicy GetStorageBudgetPolicy(ClientContext &context) {
+	StorageBudgetPolicy policy;
+	Value setting;
+	if (context.TryGetCurrentSetting("ducksync_storage_budget", setting) && !setting.IsNull()) {
+		auto budget = setting.ToString();
+		if (!budget.empty()) {
+			policy.budget_bytes = DBConfig::ParseMemoryLimit(budget);
+		}
+	}
+	return policy;
+}
+
+StorageBudget::StorageBudget(DuckSyncMetadataManager &metadata_manager, DuckSyncStorageManager &storage_manager)
+    : metadata_manager_(metadata_manager), storage_manager_(storage_manager) {
+}
+
+StorageBudget::~StorageBudget() {
+}
+
+double StorageBudget::Score(int64_t accesses, double hours_idle, double refresh_ms, int64_t size_bytes) {
+	auto size_mb = static_cast<double>(size_bytes) / (1024.0 * 1024.0);
+	return (1.0 + static_cast<double>(accesses)) * (1.0 + refresh_ms / 1000.0) /
+	       ((1.0 + hours_idle) * (1.0 + size_mb));
+}
+
+std::vector<CacheStorageInfo> StorageBudget::Collect(bool with_refresh_costs) {
+	// p50_total_ms is the fifth column of the summary
+	std::unordered_map<std::string, double> refresh_costs;
+	if (with_refresh_costs) {
+		auto summary = metadata_manager_.SummarizeRefreshHistory("");
+		for (idx_t row = 0; row < summary->RowCount(); row++) {
+			auto p50_total_ms = summary->GetValue(4, row);
+			if (!p50_total_ms.IsNull()) {
+				refresh_costs[summary->GetValue(0, row).ToString()] = p50_total_ms.GetValue<double>();
+			}
+		}
+	}
+
+	auto reads = metadata_manager_.GetCacheReads();
+	std::vector<CacheStorageInfo> infos;
+	for (auto &cache : metadata_manager_.ListCaches()) {
+		CacheStorageInfo info;
+		info.cache_name = cache.cache_name;
+		info.source_name = cache.source_name;
+
+		CacheState state;
+		info.evicted = metadata_manager_.GetState(cache.cache_name, state) && state.IsEvicted();
+		// An evicted cache still holds its dropped files until they pass the retention
+		storage_manager_.GetTableDiskUsage(cache.cache_name, cache.source_name, info.files, info.size_bytes,
+		                                   info.retained_bytes);
+
+		double hours_idle = 0;
+		auto read = reads.find(cache.cache_name);
+		if (read != reads.end()) {
+			info.accesses = read->second.reads;
+			info.has_last_access = read->second.has_last_read;
+			info.last_access = read->second.last_read;
+			hours_idle = read->second.hours_idle;
+		}
+		auto cost = refresh_costs.find(cache.cache_name);
+		info.refresh_ms = cost == refresh_costs.end() ? DEFAULT_REFRESH_COST_MS : cost->second;
+
+		info.score = Score(info.accesses, hours_idle, info.refresh_ms, info.size_bytes);
+		infos.push_back(std::move(info));
+	}
+	return infos;
+}
+
+std::vector<std::string> StorageBudget::Enforce(ClientContext &context, const StorageBudgetPolicy &policy,
+                                                const std::string &keep, int64_t lease_seconds) {
+	std::vector<std::string> evicted;
+	if (!policy.Enabled()) {
+		return evicted;
+	}
+	std::lock_guard<std::mutex> guard(enforce_lock_);
+
+	// Sizes alone decide whether anything goes; refresh costs are only read to rank the candidates
+	auto infos = Collect(false);
+	idx_t used = 0;
+	for (auto &info : infos) {
+		used += static_cast<idx_t>(info.size_bytes);
+	}
+	if (used <= policy.budget_bytes) {
+		return evicted;
+	}
+	infos = Collect();
+
+	std::sort(infos.begin(), infos.end(),
+	          [](const CacheStorageInfo &a, const CacheStorageInfo &b) { return a.score < b.score; });
+	for (auto &info : infos) {
+		if (used <= policy.budget_bytes) {
+			break;
+		}
+		if (info.cache_name == keep || info.evicted || info.size_bytes == 0) {
+			continue;
+		}
+		if (Evict(info.cache_name, info.source_name, lease_seconds)) {
+			// All of its files go once they pass the retention
+			used -= static_cast<idx_t>(info.size_bytes);
+			evicted.push_back(info.cache_name);
+		}
+	}
+
+	// DuckLake expires snapshots and deletes files catalog-wide, so this also frees what earlier refreshes
+	// of every cache left behind. The retentions still apply: time travel within them keeps working.
+	if (!evicted.empty()) {
+		try {
+			CleanupManager cleanup(context, metadata_manager_, storage_manager_);
+			cleanup.ExpireSnapshots(cleanup.EffectiveSnapshotRetention());
+			int64_t bytes_reclaimed = 0;
+			cleanup.CleanupOldFiles(cleanup.EffectiveFileRetention(), bytes_reclaimed);
+		} catch (const std::exception &) {
+			// The drops committed; the next maintenance run deletes the files
+		}
+	}
+	return evicted;
+}
+
+bool StorageBudget::Evict(const std::string &cache_name, const std::string &source_name, int64_t lease_seconds) {
+	// A cache being refreshed is about to be read; leave it and try the next one
+	auto owner_id = RefreshCoordinator::NewLeaseOwner();
+	std::string holder;
+	if (!metadata_manager_.TryAcquireRefreshLease(cache_name, owner_id, lease_seconds, holder)) {
+		return false;
+	}
+
+	bool evictable = false;
+	try {
+		CacheState state;
+		evictable = metadata_manager_.GetState(cache_name, state) && state.HasLastRefresh();
+		if (evictable) {
+			// State first: from here on readers rehydrate, and their refresh waits for this lease
+			metadata_manager_.MarkEvicted(cache_name);
+			storage_manager_.DropCacheTable(cache_name, source_name);
+		}
+	} catch (...) {
+		try {
+			metadata_manager_.ReleaseRefreshLease(cache_name, owner_id);
+		} catch (...) {
+		}
+		throw;
+	}
+	metadata_manager_.ReleaseRefreshLease(cache_name, owner_id);
+	return evictable;
+}
+
+} // namespace duckdb
@@ -2,36 +2,84 @@
 #include "duckdb/main/database.hpp"
 #include "duckdb/main/connection.hpp"
 #include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
 #include "duckdb/common/exception.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/uuid.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include <chrono>
 #include <sstream>
 
 namespace duckdb {
 
-DuckSyncStorageManager::DuckSyncStorageManager(ClientContext &context)
-    : context_(context), ducklake_attached_(false), ducklake_name_("ducksync") {
+bool CompactionPolicy::IsDue(int64_t file_count, int64_t total_bytes) const {
+	if (min_files <= 0 || file_count < min_files) {
+		return false;
+	}
+	return static_cast<idx_t>(total_bytes / file_count) < min_avg_file_bytes;
+}
+
+CompactionPolicy GetCompactionPolicy(ClientContext &context) {
+	CompactionPolicy policy;
+	Value setting;
+	if (context.TryGetCurrentSetting("ducksync_compaction_min_files", setting) && !setting.IsNull()) {
+		policy.min_files = setting.GetValue<int64_t>();
+	}
+	auto min_avg_file_size = std::string(DEFAULT_COMPACTION_MIN_AVG_FILE_SIZE);
+	if (context.TryGetCurrentSetting("ducksync_compaction_min_avg_file_size", setting) && !setting.IsNull()) {
+		min_avg_file_size = setting.ToString();
+	}
+	policy.min_avg_file_bytes = DBConfig::ParseMemoryLimit(min_avg_file_size);
+	return policy;
+}
+
+// Single-quoted SQL string literal
+static std::string Quote(const std::string &text) {
+	return KeywordHelper::WriteQuoted(text, '\'');
+}
+
+DuckSyncStorageManager::DuckSyncStorageManager(DatabaseInstance &db)
+    : db_(db), ducklake_attached_(false), ducklake_name_("ducksync") {
 }
 
 DuckSyncStorageManager::~DuckSyncStorageManager() {
 }
 
+// CREATE OR REPLACE TABLE with the given result columns
+static std::string CreateTableSQL(const std::string &table_name, const vector<string> &names,
+                                  const vector<LogicalType> &types) {
+	std::ostringstream create_table;
+	create_table << "CREATE OR REPLACE TABLE " << table_name << " (";
+	for (idx_t i = 0; i < types.size(); i++) {
+		if (i > 0) {
+			create_table << ", ";
+		}
+		create_table << KeywordHelper::WriteQuoted(names[i], '"') << " " << types[i].ToString();
+	}
+	create_table << ");";
+	return create_table.str();
+}
+
 Connection DuckSyncStorageManager::GetConnection() {
-	return Connection(*context_.db);
+	return Connection(db_);
 }
 
-void DuckSyncStorageManager::SetupStorage(const std::string &pg_connection_string, const std::string &data_path) {
+void DuckSyncStorageManager::SetupStorage(ClientContext &context, const std::string &pg_connection_string,
+                                          const std::string &data_path) {
 	config_.pg_connection_string = pg_connection_string;
 	config_.data_path = data_path;
 
-	AttachDuckLake();
+	AttachDuckLake(context);
 }
 
-void DuckSyncStorageManager::UseExistingCatalog(const std::string &catalog_name) {
+void DuckSyncStorageManager::UseExistingCatalog(ClientContext &context, const std::string &catalog_name) {
 	if (ducklake_attached_) {
 		return;
 	}
 
 	// Install required extensions (DuckLake + Snowflake)
-	InstallRequiredExtensions();
+	InstallRequiredExtensions(context);
 
 	auto conn = GetConnection();
 
@@ -52,18 +100,22 @@ void DuckSyncStorageManager::UseExistingCatalog(const std::string &catalog_name)
 	ducklake_attached_ = true;
 }
 
-void DuckSyncStorageManager::InstallRequiredExtensions() {
+void DuckSyncStorageManager::InstallRequiredExtensions(ClientContext &context) {
 	auto conn = GetConnection();
 
-	// Install and load Snowflake extension
-	auto sf_install = conn.Query("INSTALL snowflake FROM community;");
-	if (sf_install->HasError()) {
-		throw IOException("Failed to install Snowflake extension: " + sf_install->GetError());
-	}
+	// Install and load Snowflake extension, unless turned off for use without a warehouse
+	Value install_snowflake;
+	if (!context.TryGetCurrentSetting("ducksync_install_snowflake", install_snowflake) ||
+	    install_snowflake.IsNull() || install_snowflake.GetValue<bool>()) {
+		auto sf_install = conn.Query("INSTALL snowflake FROM community;");
+		if (sf_install->HasError()) {
+			throw IOException("Failed to install Snowflake extension: " + sf_install->GetError());
+		}
 
-	auto sf_load = conn.Query("LOAD snowflake;");
-	if (sf_load->HasError()) {
-		throw IOException("Failed to load Snowflake extension: " + sf_load->GetError());
+		auto sf_load = conn.Query("LOAD snowflake;");
+		if (sf_load->HasError()) {
+			throw IOException("Failed to load Snowflake extension: " + sf_load->GetError());
+		}
 	}
 
 	// Install and load DuckLake extension
@@ -78,13 +130,13 @@ void DuckSyncStorageManager::InstallRequiredExtensions() {
 	}
 }
 
-void DuckSyncStorageManager::AttachDuckLake() {
+void DuckSyncStorageManager::AttachDuckLake(ClientContext &context) {
 	if (ducklake_attached_) {
 		return;
 	}
 
 	// Install required extensions (DuckLake + Snowflake)
-	InstallRequiredExtensions();
+	InstallRequiredExtensions(context);
 
 	auto conn = GetConnection();
 
@@ -137,114 +189,381 @@ bool DuckSyncStorageManager::TableExists(const std::string &cache_name, const st
 	return count > 0;
 }
 
-void DuckSyncStorageManager::CreateCacheTable(const std::string &cache_name, const std::string &source_name,
-                                              const std::string &query_result) {
+std::string DuckSyncStorageManager::GetStagingTableName(const std::string &cache_name,
+                                                        const std::string &source_name) {
+	return GetDuckLakeTableName("__ducksync_stage_" + cache_name, source_name);
+}
+
+// Runs statements as one transaction; the last one (COMMIT) is timed as the commit. On failure the
+// transaction is rolled back and the live table is untouched.
+static StagedSwapTimings RunTimedTransaction(Connection &conn, const std::vector<std::string> &statements,
+                                             const std::string &error_context, int64_t *rows = nullptr,
+                                             idx_t rows_statement = 0) {
+	StagedSwapTimings timings;
+	for (idx_t i = 0; i < statements.size(); i++) {
+		auto statement_start = std::chrono::high_resolution_clock::now();
+		auto result = conn.Query(statements[i]);
+		if (result->HasError()) {
+			conn.Query("ROLLBACK;");
+			throw IOException(error_context + ": " + result->GetError());
+		}
+		if (rows && i == rows_statement && result->RowCount() > 0) {
+			*rows = result->GetValue(0, 0).GetValue<int64_t>();
+		}
+		auto elapsed =
+		    std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - statement_start);
+		if (i + 1 == statements.size()) {
+			timings.commit_ms = elapsed.count();
+		} else {
+			timings.write_ms += elapsed.count();
+		}
+	}
+	return timings;
+}
+
+void DuckSyncStorageManager::CreateStagingTable(const std::string &cache_name, const std::string &source_name,
+                                                const vector<string> &names, const vector<LogicalType> &types,
+                                                const TableLayout &layout) {
 	if (!ducklake_attached_) {
 		throw IOException("DuckLake not attached");
 	}
 
 	auto conn = GetConnection();
+	auto staging_name = GetStagingTableName(cache_name, source_name);
+	// Partitioning and table options must be in place before the first row is written; they carry
+	// over on rename. One commit, so a failure leaves no half-configured staging table behind.
+	std::vector<std::string> statements = {"BEGIN TRANSACTION;", CreateTableSQL(staging_name, names, types)};
+	if (!layout.partition_by.empty()) {
+		statements.push_back(PartitionSQL(staging_name, layout.partition_by));
+	}
+	for (auto &option : layout.options) {
+		statements.push_back(SetOptionSQL("__ducksync_stage_" + cache_name, source_name, option.first, option.second));
+	}
+	statements.push_back("COMMIT;");
+	RunTimedTransaction(conn, statements, "Failed to create staging table");
+}
 
-	// Create schema if it doesn't exist
-	std::ostringstream create_schema;
-	create_schema << "CREATE SCHEMA IF NOT EXISTS " << ducklake_name_ << "." << source_name << ";";
-	auto schema_result = conn.Query(create_schema.str());
-	if (schema_result->HasError()) {
-		throw IOException("Failed to create schema: " + schema_result->GetError());
+std::string DuckSyncStorageManager::PartitionSQL(const std::string &table_name,
+                                                 const std::vector<std::string> &partition_by) {
+	std::ostringstream sql;
+	sql << "ALTER TABLE " << table_name << " SET PARTITIONED BY (";
+	for (idx_t i = 0; i < partition_by.size(); i++) {
+		sql << (i > 0 ? ", " : "") << partition_by[i];
 	}
+	sql << ");";
+	return sql.str();
+}
 
-	// Create or replace the cache table
-	std::string table_name = GetDuckLakeTableName(cache_name, source_name);
+std::string DuckSyncStorageManager::SetOptionSQL(const std::string &table_name, const std::string &source_name,
+                                                 const std::string &option, const std::string &value_sql) const {
+	std::ostringstream sql;
+	sql << "CALL " << KeywordHelper::WriteOptionallyQuoted(ducklake_name_) << ".set_option(" << Quote(option) << ", "
+	    << value_sql << ", schema => " << Quote(source_name) << ", table_name => " << Quote(table_name) << ");";
+	return sql.str();
+}
 
-	std::ostringstream create_table;
-	create_table << "CREATE OR REPLACE TABLE " << table_name << " AS " << query_result << ";";
+std::string DuckSyncStorageManager::AddDataFileSQL(const std::string &table_name, const std::string &source_name,
+                                                   const std::string &file) const {
+	std::ostringstream sql;
+	sql << "CALL ducklake_add_data_files(" << Quote(ducklake_name_) << ", " << Quote(table_name) << ", "
+	    << Quote(file) << ", schema => " << Quote(source_name) << ");";
+	return sql.str();
+}
+
+int64_t DuckSyncStorageManager::WriteBloomFilteredFiles(const std::string &cache_name, const std::string &source_name,
+                                                        const std::string &select_sql,
+                                                        const ParquetFileOptions &options,
+                                                        std::vector<std::string> &files) {
+	if (!ducklake_attached_) {
+		throw IOException("DuckLake not attached");
+	}
+
+	auto conn = GetConnection();
+	auto directory = GetDataPath(conn) + source_name + "/" + cache_name + "/ducksync_bloom_" +
+	                 UUID::ToString(UUID::GenerateRandomUUID());
+	auto file_size = options.target_file_size.empty() ? std::string(DEFAULT_BLOOM_FILE_SIZE) : options.target_file_size;
+
+	// Every value of a row group fits the dictionary, so each column chunk stays dictionary-encoded.
+	// COPY only takes these limits for the whole file; the string page limit, which costs the most
+	// writer memory, is only raised when a Bloom filter column needs it.
+	std::ostringstream copy_sql;
+	copy_sql << "COPY (" << select_sql << ") TO " << Quote(directory) << " (FORMAT parquet, ROW_GROUP_SIZE "
+	         << options.row_group_size << ", DICTIONARY_SIZE_LIMIT " << options.row_group_size;
+	if (options.string_bloom_filters) {
+		copy_sql << ", STRING_DICTIONARY_PAGE_SIZE_LIMIT " << MAX_STRING_DICTIONARY_PAGE_BYTES;
+	}
+	copy_sql << ", BLOOM_FILTER_FALSE_POSITIVE_RATIO " << BLOOM_FILTER_FALSE_POSITIVE_RATIO << ", FILE_SIZE_BYTES "
+	         << Quote(file_size) << ", FILENAME_PATTERN 'part_{i}'";
+	if (!options.compression.empty()) {
+		copy_sql << ", COMPRESSION " << Quote(options.compression);
+	}
+	copy_sql << ");";
+
+	auto copy_result = conn.Query(copy_sql.str());
+	if (copy_result->HasError()) {
+		throw IOException("Failed to write cache files: " + copy_result->GetError());
+	}
+	int64_t rows = copy_result->RowCount() > 0 ? copy_result->GetValue(0, 0).GetValue<int64_t>() : 0;
+
+	auto listed = conn.Query("SELECT file FROM glob(" + Quote(directory + "/*.parquet") + ") ORDER BY file;");
+	if (listed->HasError()) {
+		throw IOException("Failed to list written cache files: " + listed->GetError());
+	}
+	files.clear();
+	for (idx_t row = 0; row < listed->RowCount(); row++) {
+		files.push_back(listed->GetValue(0, row).ToString());
+	}
+	return rows;
+}
+
+StagedSwapTimings DuckSyncStorageManager::AddStagedFiles(const std::string &cache_name, const std::string &source_name,
+                                                         const std::vector<std::string> &files) {
+	if (!ducklake_attached_) {
+		throw IOException("DuckLake not attached");
+	}
+
+	// All files land in the staging table in one commit; on failure the files are orphans that
+	// ducksync_cleanup removes once the file retention has passed
+	auto conn = GetConnection();
+	std::vector<std::string> statements = {"BEGIN TRANSACTION;"};
+	for (auto &file : files) {
+		statements.push_back(AddDataFileSQL("__ducksync_stage_" + cache_name, source_name, file));
+	}
+	statements.push_back("COMMIT;");
+	return RunTimedTransaction(conn, statements, "Failed to register cache files with DuckLake");
+}
+
+std::string DuckSyncStorageManager::GetDataPath(Connection &conn) {
+	auto result = conn.Query("SELECT value FROM __ducklake_metadata_" + ducklake_name_ +
+	                         ".ducklake_metadata WHERE key = 'data_path';");
+	if (result->HasError() || result->RowCount() == 0 || result->GetValue(0, 0).IsNull()) {
+		throw IOException("Could not determine the DuckLake data path of " + ducklake_name_);
+	}
+	auto data_path = result->GetValue(0, 0).ToString();
+	if (!data_path.empty() && data_path.back() != '/') {
+		data_path += "/";
+	}
+	return data_path;
+}
+
+bool DuckSyncStorageManager::HasSameColumns(const std::string &cache_name, const std::string &source_name,
+                                            const vector<string> &names, const vector<LogicalType> &types) {
+	if (!ducklake_attached_) {
+		return false;
+	}
+
+	auto conn = GetConnection();
+	auto result = conn.Query("SELECT * FROM " + GetDuckLakeTableName(cache_name, source_name) + " LIMIT 0;");
+	// No live table yet (first refresh)
+	if (result->HasError()) {
+		return false;
+	}
+	return result->names == names && result->types == types;
+}
+
+// Partition key as written in partition_by, lower-cased and without spaces, for comparison
+static std::string NormalizePartitionKey(const std::string &key) {
+	std::string normalized;
+	for (auto c : StringUtil::Lower(key)) {
+		if (!StringUtil::CharacterIsSpace(c)) {
+			normalized += c;
+		}
+	}
+	return normalized;
+}
 
-	auto result = conn.Query(create_table.str());
+bool DuckSyncStorageManager::GetPartitionKeys(Connection &conn, const std::string &cache_name,
+                                              const std::string &source_name, std::vector<std::string> &keys) {
+	// The current partition spec of the live table, from the DuckLake catalog tables
+	auto metadata = "__ducklake_metadata_" + ducklake_name_;
+	std::ostringstream sql;
+	sql << "SELECT c.column_name, pc.transform FROM " << metadata << ".ducklake_partition_info pi "
+	    << "JOIN " << metadata << ".ducklake_partition_column pc USING (partition_id, table_id) "
+	    << "JOIN " << metadata << ".ducklake_column c ON c.table_id = pc.table_id AND c.column_id = pc.column_id "
+	    << "AND c.end_snapshot IS NULL "
+	    << "JOIN " << metadata << ".ducklake_table t ON t.table_id = pi.table_id AND t.end_snapshot IS NULL "
+	    << "JOIN " << metadata << ".ducklake_schema s ON s.schema_id = t.schema_id AND s.end_snapshot IS NULL "
+	    << "WHERE pi.end_snapshot IS NULL AND s.schema_name = " << Quote(source_name)
+	    << " AND t.table_name = " << Quote(cache_name) << " ORDER BY pc.partition_key_index;";
+	auto result = conn.Query(sql.str());
 	if (result->HasError()) {
-		throw IOException("Failed to create cache table: " + result->GetError());
+		return false;
+	}
+	keys.clear();
+	for (idx_t row = 0; row < result->RowCount(); row++) {
+		auto column = result->GetValue(0, row).ToString();
+		auto transform = result->GetValue(1, row).ToString();
+		keys.push_back(NormalizePartitionKey(transform == "identity" ? column : transform + "(" + column + ")"));
 	}
+	return true;
 }
 
-void DuckSyncStorageManager::WriteQueryResult(const std::string &cache_name, const std::string &source_name,
-                                              MaterializedQueryResult &result) {
+StagedSwapTimings DuckSyncStorageManager::ReplaceTableContents(const std::string &cache_name,
+                                                               const std::string &source_name,
+                                                               const std::string &select_sql,
+                                                               const TableLayout &layout, int64_t &rows) {
 	if (!ducklake_attached_) {
 		throw IOException("DuckLake not attached");
 	}
 
 	auto conn = GetConnection();
+	std::string table_name = GetDuckLakeTableName(cache_name, source_name);
+	// Readers keep seeing the previous snapshot until this commit lands; layout changes are part of it
+	std::vector<std::string> statements = {"BEGIN TRANSACTION;"};
+	for (auto &option : layout.options) {
+		statements.push_back(SetOptionSQL(cache_name, source_name, option.first, option.second));
+	}
+	// Only repartition when the cache's partition_by no longer matches the table: every ALTER is a
+	// schema change in the catalog. If the spec cannot be read, set it as a precaution.
+	std::vector<std::string> desired;
+	for (auto &key : layout.partition_by) {
+		desired.push_back(NormalizePartitionKey(key));
+	}
+	std::vector<std::string> current;
+	if (!GetPartitionKeys(conn, cache_name, source_name, current) || current != desired) {
+		if (!layout.partition_by.empty()) {
+			statements.push_back(PartitionSQL(table_name, layout.partition_by));
+		} else if (!current.empty()) {
+			statements.push_back("ALTER TABLE " + table_name + " RESET PARTITIONED BY;");
+		}
+	}
+	statements.push_back("DELETE FROM " + table_name + ";");
+	auto insert_index = statements.size();
+	statements.push_back("INSERT INTO " + table_name + " " + select_sql + ";");
+	statements.push_back("COMMIT;");
 
-	// Create schema if it doesn't exist
-	std::ostringstream create_schema;
-	create_schema << "CREATE SCHEMA IF NOT EXISTS " << ducklake_name_ << "." << source_name << ";";
-	auto schema_result = conn.Query(create_schema.str());
-	if (schema_result->HasError()) {
-		throw IOException("Failed to create schema: " + schema_result->GetError());
+	rows = 0;
+	return RunTimedTransaction(conn, statements, "Failed to write refreshed cache table", &rows, insert_index);
+}
+
+StagedSwapTimings DuckSyncStorageManager::ReplaceTableFiles(const std::string &cache_name,
+                                                            const std::string &source_name,
+                                                            const std::vector<std::string> &files,
+                                                            const TableLayout &layout) {
+	if (!ducklake_attached_) {
+		throw IOException("DuckLake not attached");
 	}
 
+	// Same transaction shape as ReplaceTableContents, with the written files registered instead of an
+	// INSERT. Bloom-filtered caches are never partitioned, so the partition spec is left alone.
+	auto conn = GetConnection();
 	std::string table_name = GetDuckLakeTableName(cache_name, source_name);
+	std::vector<std::string> statements = {"BEGIN TRANSACTION;"};
+	for (auto &option : layout.options) {
+		statements.push_back(SetOptionSQL(cache_name, source_name, option.first, option.second));
+	}
+	statements.push_back("DELETE FROM " + table_name + ";");
+	for (auto &file : files) {
+		statements.push_back(AddDataFileSQL(cache_name, source_name, file));
+	}
+	statements.push_back("COMMIT;");
+	return RunTimedTransaction(conn, statements, "Failed to register refreshed cache files with DuckLake");
+}
 
-	// Build CREATE TABLE statement based on result columns
-	std::ostringstream create_table;
-	create_table << "CREATE OR REPLACE TABLE " << table_name << " (";
+StagedSwapTimings DuckSyncStorageManager::SwapStagedTable(const std::string &cache_name,
+                                                          const std::string &source_name) {
+	if (!ducklake_attached_) {
+		throw IOException("DuckLake not attached");
+	}
 
-	auto &types = result.types;
-	auto &names = result.names;
+	auto conn = GetConnection();
+	std::string table_name = GetDuckLakeTableName(cache_name, source_name);
+	std::string staging_name = GetStagingTableName(cache_name, source_name);
+
+	// First refresh, a changed source schema or files DuckLake's writer must not rewrite: the old
+	// layout cannot hold the new rows. The staging table is left for DropStagingTable on failure.
+	std::vector<std::string> statements = {"BEGIN TRANSACTION;", "DROP TABLE IF EXISTS " + table_name + ";",
+	                                       "ALTER TABLE " + staging_name + " RENAME TO " + cache_name + ";",
+	                                       "COMMIT;"};
+	return RunTimedTransaction(conn, statements, "Failed to swap in refreshed cache table");
+}
 
-	for (idx_t i = 0; i < types.size(); i++) {
-		if (i > 0)
-			create_table << ", ";
-		create_table << "\"" << names[i] << "\" " << types[i].ToString();
+void DuckSyncStorageManager::DropStagingTable(const std::string &cache_name, const std::string &source_name) {
+	if (!ducklake_attached_) {
+		return;
 	}
-	create_table << ");";
 
-	auto create_result = conn.Query(create_table.str());
-	if (create_result->HasError()) {
-		throw IOException("Failed to create cache table: " + create_result->GetError());
-	}
-
-	// Insert data from result
-	if (result.RowCount() == 0) {
-		return; // No data to insert
-	}
-
-	std::ostringstream insert_sql;
-	insert_sql << "INSERT INTO " << table_name << " VALUES ";
-
-	bool first_row = true;
-	for (idx_t row = 0; row < result.RowCount(); row++) {
-		if (!first_row)
-			insert_sql << ", ";
-		insert_sql << "(";
-
-		for (idx_t col = 0; col < types.size(); col++) {
-			if (col > 0)
-				insert_sql << ", ";
-			auto val = result.GetValue(col, row);
-			if (val.IsNull()) {
-				insert_sql << "NULL";
-			} else if (types[col].IsNumeric()) {
-				insert_sql << val.ToString();
-			} else {
-				// Escape single quotes
-				std::string str_val = val.ToString();
-				std::ostringstream escaped;
-				for (char c : str_val) {
-					if (c == '\'')
-						escaped << "''";
-					else
-						escaped << c;
-				}
-				insert_sql << "'" << escaped.str() << "'";
-			}
-		}
-		insert_sql << ")";
-		first_row = false;
+	auto conn = GetConnection();
+	conn.Query("DROP TABLE IF EXISTS " + GetStagingTableName(cache_name, source_name) + ";");
+}
+
+void DuckSyncStorageManager::DropCacheTable(const std::string &cache_name, const std::string &source_name) {
+	if (!ducklake_attached_) {
+		return;
 	}
-	insert_sql << ";";
 
-	auto insert_result = conn.Query(insert_sql.str());
-	if (insert_result->HasError()) {
-		throw IOException("Failed to insert data into cache table: " + insert_result->GetError());
+	auto conn = GetConnection();
+	auto result = conn.Query("DROP TABLE IF EXISTS " + GetDuckLakeTableName(cache_name, source_name) + ";");
+	if (result->HasError()) {
+		throw IOException("Failed to drop cache table " + cache_name + ": " + result->GetError());
+	}
+}
+
+bool DuckSyncStorageManager::GetTableFileStats(const std::string &cache_name, const std::string &source_name,
+                                               int64_t &file_count, int64_t &total_bytes) {
+	if (!ducklake_attached_) {
+		return false;
+	}
+
+	auto conn = GetConnection();
+	std::ostringstream sql;
+	sql << "SELECT COUNT(*), COALESCE(SUM(data_file_size_bytes), 0)::BIGINT FROM ducklake_list_files("
+	    << Quote(ducklake_name_) << ", " << Quote(cache_name) << ", schema => " << Quote(source_name) << ");";
+
+	auto result = conn.Query(sql.str());
+	if (result->HasError() || result->RowCount() == 0) {
+		return false;
+	}
+
+	file_count = result->GetValue(0, 0).GetValue<int64_t>();
+	total_bytes = result->GetValue(1, 0).GetValue<int64_t>();
+	return true;
+}
+
+bool DuckSyncStorageManager::GetTableDiskUsage(const std::string &cache_name, const std::string &source_name,
+                                               int64_t &file_count, int64_t &total_bytes, int64_t &retained_bytes) {
+	if (!ducklake_attached_) {
+		return false;
+	}
+
+	// Files stay in the catalog, with an end snapshot, until expired snapshots no longer reference them.
+	// Matching every table_id by name also covers the versions of the table dropped by evictions.
+	auto conn = GetConnection();
+	auto metadata = "__ducklake_metadata_" + ducklake_name_;
+	std::ostringstream sql;
+	sql << "SELECT COUNT(*), COALESCE(SUM(file_size_bytes), 0)::BIGINT, "
+	    << "COALESCE(SUM(file_size_bytes) FILTER (WHERE end_snapshot IS NOT NULL), 0)::BIGINT FROM ("
+	    << "SELECT table_id, file_size_bytes, end_snapshot FROM " << metadata << ".ducklake_data_file UNION ALL "
+	    << "SELECT table_id, file_size_bytes, end_snapshot FROM " << metadata << ".ducklake_delete_file"
+	    << ") WHERE table_id IN (SELECT t.table_id FROM " << metadata << ".ducklake_table t JOIN " << metadata
+	    << ".ducklake_schema s ON s.schema_id = t.schema_id WHERE s.schema_name = " << Quote(source_name)
+	    << " AND t.table_name = " << Quote(cache_name) << ");";
+
+	auto result = conn.Query(sql.str());
+	if (result->HasError() || result->RowCount() == 0) {
+		return false;
+	}
+
+	file_count = result->GetValue(0, 0).GetValue<int64_t>();
+	total_bytes = result->GetValue(1, 0).GetValue<int64_t>();
+	retained_bytes = result->GetValue(2, 0).GetValue<int64_t>();
+	return true;
+}
+
+bool DuckSyncStorageManager::HasRemoteDataPath() {
+	auto conn = GetConnection();
+	return FileSystem::IsRemoteFile(GetDataPath(conn));
+}
+
+void DuckSyncStorageManager::MergeAdjacentFiles(const std::string &cache_name, const std::string &source_name) {
+	auto conn = GetConnection();
+	std::ostringstream sql;
+	sql << "CALL ducklake_merge_adjacent_files(" << Quote(ducklake_name_) << ", " << Quote(cache_name)
+	    << ", schema => " << Quote(source_name) << ");";
+
+	auto result = conn.Query(sql.str());
+	if (result->HasError()) {
+		throw IOException("Failed to merge data files of " + cache_name + ": " + result->GetError());
 	}
 }
 
@@ -0,0 +1,240 @@
+#include "trace_recorder.hpp"
+#include "metadata_manager.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include "duckdb/common/types/uuid.hpp"
+#include "duckdb/main/client_context.hpp"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace duckdb {
+
+static std::string EscapeJSON(const std::string &value) {
+	std::string escaped;
+	escaped.reserve(value.size() + 2);
+	escaped += '"';
+	for (char c : value) {
+		switch (c) {
+		case '"':
+			escaped += "\\\"";
+			break;
+		case '\\':
+			escaped += "\\\\";
+			break;
+		case '\n':
+			escaped += "\\n";
+			break;
+		case '\r':
+			escaped += "\\r";
+			break;
+		case '\t':
+			escaped += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				char buffer[8];
+				snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned char>(c));
+				escaped += buffer;
+			} else {
+				escaped += c;
+			}
+		}
+	}
+	escaped += '"';
+	return escaped;
+}
+
+std::string TraceSpan::ToJSON() const {
+	std::ostringstream json;
+	json << "{\"trace_id\":" << EscapeJSON(trace_id) << ",\"span_id\":" << span_id << ",\"parent_id\":";
+	if (parent_id == 0) {
+		json << "null";
+	} else {
+		json << parent_id;
+	}
+	json << ",\"name\":" << EscapeJSON(name) << ",\"started_at\":" << EscapeJSON(Timestamp::ToString(started_at))
+	     << ",\"duration_ms\":" << duration_ms << ",\"metadata_reads\":" << metadata_reads
+	     << ",\"metadata_commits\":" << metadata_commits << ",\"attributes\":{";
+	for (idx_t i = 0; i < attributes.size(); i++) {
+		if (i > 0) {
+			json << ",";
+		}
+		json << EscapeJSON(attributes[i].first) << ":" << EscapeJSON(attributes[i].second);
+	}
+	json << "}}";
+	return json.str();
+}
+
+//===--------------------------------------------------------------------===//
+// TraceRecorder
+//===--------------------------------------------------------------------===//
+
+static std::mutex trace_lock;
+static std::vector<TraceSpan> trace_ring;
+static idx_t trace_next = 0; // slot the next span overwrites once the ring is full
+
+// The ducksync_trace_file output stays open between spans and is reopened when the setting changes.
+// Lines are buffered until an outermost span ends, so a finished operation is complete on disk.
+static std::mutex trace_file_lock;
+static std::string trace_file_path;
+static std::ofstream trace_file;
+
+static void AppendToTraceFile(const std::string &file, const std::string &line, bool flush) {
+	std::lock_guard<std::mutex> guard(trace_file_lock);
+	if (file != trace_file_path) {
+		if (trace_file.is_open()) {
+			trace_file.close();
+		}
+		trace_file.clear();
+		trace_file.open(file, std::ios::app);
+		trace_file_path = file;
+	}
+	// A bad path must not fail the traced query; the span is still kept in the ring
+	if (!trace_file) {
+		return;
+	}
+	trace_file << line << "\n";
+	if (flush) {
+		trace_file.flush();
+	}
+}
+
+void TraceRecorder::Record(TraceSpan span, const std::string &file, bool outermost) {
+	if (!file.empty()) {
+		AppendToTraceFile(file, span.ToJSON(), outermost);
+	}
+	std::lock_guard<std::mutex> guard(trace_lock);
+	if (trace_ring.size() < CAPACITY) {
+		trace_ring.push_back(std::move(span));
+	} else {
+		trace_ring[trace_next] = std::move(span);
+		trace_next = (trace_next + 1) % CAPACITY;
+	}
+}
+
+std::vector<TraceSpan> TraceRecorder::Snapshot() {
+	std::lock_guard<std::mutex> guard(trace_lock);
+	std::vector<TraceSpan> spans;
+	spans.reserve(trace_ring.size());
+	for (idx_t i = 0; i < trace_ring.size(); i++) {
+		spans.push_back(trace_ring[(trace_next + i) % trace_ring.size()]);
+	}
+	return spans;
+}
+
+void TraceRecorder::Clear() {
+	std::lock_guard<std::mutex> guard(trace_lock);
+	trace_ring.clear();
+	trace_next = 0;
+}
+
+//===--------------------------------------------------------------------===//
+// TraceScope
+//===--------------------------------------------------------------------===//
+
+// Innermost open span of the calling thread
+static thread_local TraceScope *current_trace_scope = nullptr;
+
+static std::atomic<int64_t> next_span_id {1};
+
+TraceScope::TraceScope(ClientContext &context, const char *name) {
+	if (current_trace_scope) {
+		auto parent = current_trace_scope->Link();
+		Open(parent.trace_id, parent.span_id, parent.file, name);
+		return;
+	}
+	Value setting;
+	if (!context.TryGetCurrentSetting("ducksync_trace", setting) || setting.IsNull() ||
+	    !setting.GetValue<bool>()) {
+		return;
+	}
+	std::string file;
+	if (context.TryGetCurrentSetting("ducksync_trace_file", setting) && !setting.IsNull()) {
+		file = setting.ToString();
+	}
+	Open(UUID::ToString(UUID::GenerateRandomUUID()), 0, file, name);
+}
+
+TraceScope::TraceScope(const char *name) {
+	if (current_trace_scope) {
+		auto parent = current_trace_scope->Link();
+		Open(parent.trace_id, parent.span_id, parent.file, name);
+	}
+}
+
+TraceScope::TraceScope(const TraceLink &link, const char *name) {
+	if (!link.trace_id.empty()) {
+		Open(link.trace_id, link.span_id, link.file, name);
+	}
+}
+
+void TraceScope::Open(const std::string &trace_id, int64_t parent_id, const std::string &file, const char *name) {
+	active_ = true;
+	file_ = file;
+	span_.trace_id = trace_id;
+	span_.span_id = next_span_id.fetch_add(1, std::memory_order_relaxed);
+	span_.parent_id = parent_id;
+	span_.name = name;
+	span_.started_at = Timestamp::GetCurrentTimestamp();
+	reads_before_ = DuckSyncMetadataManager::ThreadReadCount();
+	commits_before_ = DuckSyncMetadataManager::ThreadCommitCount();
+	start_ = std::chrono::steady_clock::now();
+	previous_ = current_trace_scope;
+	current_trace_scope = this;
+}
+
+TraceScope::~TraceScope() {
+	Stop();
+}
+
+void TraceScope::Stop() {
+	if (!active_) {
+		return;
+	}
+	active_ = false;
+	current_trace_scope = previous_;
+	span_.duration_ms =
+	    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+	span_.metadata_reads = static_cast<int64_t>(DuckSyncMetadataManager::ThreadReadCount() - reads_before_);
+	span_.metadata_commits = static_cast<int64_t>(DuckSyncMetadataManager::ThreadCommitCount() - commits_before_);
+	TraceRecorder::Record(std::move(span_), file_, previous_ == nullptr);
+}
+
+void TraceScope::Set(const std::string &key, const std::string &value) {
+	if (!active_) {
+		return;
+	}
+	for (auto &attribute : span_.attributes) {
+		if (attribute.first == key) {
+			attribute.second = value;
+			return;
+		}
+	}
+	span_.attributes.emplace_back(key, value);
+}
+
+void TraceScope::Set(const std::string &key, const char *value) {
+	if (active_) {
+		Set(key, std::string(value));
+	}
+}
+
+void TraceScope::Set(const std::string &key, int64_t value) {
+	if (active_) {
+		Set(key, std::to_string(value));
+	}
+}
+
+TraceLink TraceScope::Link() const {
+	TraceLink link;
+	if (active_) {
+		link.trace_id = span_.trace_id;
+		link.span_id = span_.span_id;
+		link.file = file_;
+	}
+	return link;
+}
+
+} // namespace duckdb
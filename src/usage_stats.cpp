@@ -0,0 +1,141 @@
+#include "usage_stats.hpp"
+#include "duckdb/common/exception.hpp"
+#include <chrono>
+#include <vector>
+
+namespace duckdb {
+
+UsageStats::UsageStats(DuckSyncMetadataManager &metadata_manager, DuckSyncStorageManager &storage_manager)
+    : metadata_manager_(metadata_manager), storage_manager_(storage_manager) {
+}
+
+UsageStats::~UsageStats() {
+}
+
+int64_t UsageStats::NowMicros() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
+UsageStats::Counters &UsageStats::Slot(std::unordered_map<std::string, std::unique_ptr<Counters>> &slots,
+                                       const std::string &key, const std::string &source_name) {
+	{
+		std::shared_lock<std::shared_mutex> guard(lock_);
+		auto entry = slots.find(key);
+		if (entry != slots.end()) {
+			return *entry->second;
+		}
+	}
+	// Slots are never removed, so the reference stays valid after the lock is released
+	std::unique_lock<std::shared_mutex> guard(lock_);
+	auto &slot = slots[key];
+	if (!slot) {
+		slot = make_uniq<Counters>(source_name);
+	}
+	return *slot;
+}
+
+void UsageStats::RecordScanHit(const std::string &cache_name, const std::string &source_name) {
+	auto &slot = Slot(caches_, cache_name, source_name);
+	slot.scan_hits.fetch_add(1, std::memory_order_relaxed);
+	slot.last_read_us.store(NowMicros(), std::memory_order_relaxed);
+	dirty_.store(true, std::memory_order_relaxed);
+}
+
+void UsageStats::RecordQueryHit(const std::string &cache_name, const std::string &source_name) {
+	auto &slot = Slot(caches_, cache_name, source_name);
+	slot.query_hits.fetch_add(1, std::memory_order_relaxed);
+	slot.last_read_us.store(NowMicros(), std::memory_order_relaxed);
+	dirty_.store(true, std::memory_order_relaxed);
+}
+
+void UsageStats::RecordPassthrough(const std::string &source_name) {
+	Slot(passthrough_, source_name, source_name).passthrough_misses.fetch_add(1, std::memory_order_relaxed);
+	dirty_.store(true, std::memory_order_relaxed);
+}
+
+void UsageStats::RecordRowsServed(const std::string &cache_name, const std::string &source_name, int64_t rows) {
+	Slot(caches_, cache_name, source_name).rows_served.fetch_add(rows, std::memory_order_relaxed);
+	dirty_.store(true, std::memory_order_relaxed);
+}
+
+void UsageStats::LocalReads(const std::string &cache_name, int64_t &reads, int64_t &last_read_us) {
+	std::shared_lock<std::shared_mutex> guard(lock_);
+	auto entry = caches_.find(cache_name);
+	if (entry == caches_.end()) {
+		reads = 0;
+		last_read_us = 0;
+		return;
+	}
+	auto &slot = *entry->second;
+	reads = slot.scan_hits.load(std::memory_order_relaxed) + slot.query_hits.load(std::memory_order_relaxed);
+	last_read_us = slot.last_read_us.load(std::memory_order_relaxed);
+}
+
+void UsageStats::Flush() {
+	std::lock_guard<std::mutex> flush_guard(flush_lock_);
+	if (!dirty_.exchange(false, std::memory_order_relaxed)) {
+		return;
+	}
+
+	// Each slot's counts since its last flush; a record racing with this lands in the next flush
+	struct Taken {
+		Counters *slot;
+		UsageStatsEntry totals;
+		UsageStatsEntry entry;
+	};
+	std::vector<Taken> taken;
+	auto take = [&](const std::string &key, Counters &slot, bool passthrough) {
+		Taken row;
+		row.slot = &slot;
+		row.totals.scan_hits = slot.scan_hits.load(std::memory_order_relaxed);
+		row.totals.query_hits = slot.query_hits.load(std::memory_order_relaxed);
+		row.totals.passthrough_misses = slot.passthrough_misses.load(std::memory_order_relaxed);
+		row.totals.rows_served = slot.rows_served.load(std::memory_order_relaxed);
+		row.entry.cache_name = passthrough ? "" : key;
+		row.entry.source_name = slot.source_name;
+		row.entry.scan_hits = row.totals.scan_hits - slot.flushed.scan_hits;
+		row.entry.query_hits = row.totals.query_hits - slot.flushed.query_hits;
+		row.entry.passthrough_misses = row.totals.passthrough_misses - slot.flushed.passthrough_misses;
+		row.entry.rows_served = row.totals.rows_served - slot.flushed.rows_served;
+		if (row.entry.scan_hits || row.entry.query_hits || row.entry.passthrough_misses || row.entry.rows_served) {
+			taken.push_back(std::move(row));
+		}
+	};
+	{
+		std::shared_lock<std::shared_mutex> guard(lock_);
+		for (auto &entry : caches_) {
+			take(entry.first, *entry.second, false);
+		}
+		for (auto &entry : passthrough_) {
+			take(entry.first, *entry.second, true);
+		}
+	}
+	if (taken.empty()) {
+		return;
+	}
+
+	std::vector<UsageStatsEntry> entries;
+	try {
+		for (auto &row : taken) {
+			auto hits = row.entry.scan_hits + row.entry.query_hits;
+			int64_t file_count = 0;
+			int64_t total_bytes = 0;
+			if (hits > 0 && storage_manager_.GetTableFileStats(row.entry.cache_name, row.entry.source_name,
+			                                                    file_count, total_bytes)) {
+				row.entry.bytes_avoided = hits * total_bytes;
+			}
+			entries.push_back(row.entry);
+		}
+		metadata_manager_.AppendUsageStats(entries);
+	} catch (...) {
+		dirty_.store(true, std::memory_order_relaxed);
+		throw;
+	}
+	for (auto &row : taken) {
+		row.slot->flushed = row.totals;
+	}
+}
+
+} // namespace duckdb
@@ -0,0 +1,117 @@
+#!/bin/bash
+# test/bench_bloom_filters.sh
+#
+# PURPOSE
+# =======
+# Shows how many row groups an equality lookup on a high-cardinality key has
+# to scan in a cache created with bloom_filter_columns, against the same cache
+# without them.
+#
+# HOW
+# ===
+# A shuffled ORDERS table is generated in a DuckDB database that stands in for
+# the warehouse (ducksync_source_function = 'ducksync_emulated_query'). Two
+# caches over it are created in a local DuckLake catalog and refreshed through
+# DuckSync: orders_plain, written by DuckLake, and orders_bloom, created with
+# bloom_filter_columns := ['order_id', 'email_hash']. Keys are shuffled, so
+# min/max zone maps cannot prune; only Bloom filters can. parquet_bloom_probe()
+# reports, per row group of each cache file, whether the filter rules a value
+# out. The lookups at the end read the cache tables directly from DuckLake.
+#
+# Requires: built DuckDB with DuckSync; the ducklake extension is installed on
+# first run. No Snowflake or PostgreSQL needed.
+# Usage: bash test/bench_bloom_filters.sh [rows] [lookups]
+
+DUCKDB="$(dirname "$0")/../build/release/duckdb"
+ROWS="${1:-2000000}"
+LOOKUPS="${2:-50}"
+WORKDIR="$(mktemp -d /tmp/ducksync_bloom_bench.XXXXXX)"
+trap 'rm -rf "$WORKDIR"' EXIT
+
+if [ ! -f "$DUCKDB" ]; then
+    echo "ERROR: build/release/duckdb not found. Run 'make release' first."
+    exit 1
+fi
+
+echo "DuckSync Bloom filter benchmark: ${ROWS} rows, ${LOOKUPS} lookups per key"
+echo ""
+
+ATTACH_LAKE="INSTALL ducklake; LOAD ducklake;
+ATTACH 'ducklake:${WORKDIR}/lake.ducklake' AS bench_lake (DATA_PATH '${WORKDIR}/data/');
+ATTACH '${WORKDIR}/warehouse.duckdb' AS BENCH_SRC;"
+
+"$DUCKDB" "${WORKDIR}/warehouse.duckdb" -c "
+CREATE SCHEMA PUBLIC;
+CREATE TABLE PUBLIC.ORDERS AS
+SELECT i AS order_id,
+       'SKU-' || (i % 50000) AS sku,
+       sha256(i::VARCHAR) AS email_hash,
+       random() * 100 AS amount
+FROM range(${ROWS}) t(i)
+ORDER BY random();
+" || exit 1
+
+# Both caches are written by refreshes, exactly as a deployment would write them
+"$DUCKDB" -c "
+${ATTACH_LAKE}
+SET ducksync_install_snowflake = false;
+SET ducksync_source_function = 'ducksync_emulated_query';
+SELECT * FROM ducksync_init('bench_lake');
+SELECT * FROM ducksync_add_source('bench', 'snowflake', 'unused');
+SELECT * FROM ducksync_create_cache('orders_plain', 'bench', 'SELECT * FROM BENCH_SRC.PUBLIC.ORDERS',
+    ['BENCH_SRC.PUBLIC.ORDERS'], row_group_size := 122880);
+SELECT * FROM ducksync_create_cache('orders_bloom', 'bench', 'SELECT * FROM BENCH_SRC.PUBLIC.ORDERS',
+    ['BENCH_SRC.PUBLIC.ORDERS'], row_group_size := 122880, bloom_filter_columns := ['order_id', 'email_hash']);
+SELECT * FROM ducksync_refresh('orders_plain');
+SELECT * FROM ducksync_refresh('orders_bloom');
+" > /dev/null || exit 1
+
+list_files() {
+    "$DUCKDB" -csv -noheader -c "${ATTACH_LAKE}
+SELECT data_file FROM ducklake_list_files('bench_lake', '$1', schema => 'bench');" | grep '\.parquet$'
+}
+
+# One parquet_bloom_probe per cache file and key column, over every probe value
+probe_union() {
+    local separator=""
+    for cache in orders_plain orders_bloom; do
+        for file in $(list_files "$cache"); do
+            for column in order_id email_hash; do
+                printf "%sSELECT '%s' AS cache, '%s' AS key_column, '%s' AS file, p.%s::VARCHAR AS probe, b.*
+    FROM probes p, parquet_bloom_probe('%s', '%s', p.%s) b\n" \
+                    "$separator" "$cache" "$column" "$file" "$column" "$file" "$column" "$column"
+                separator="    UNION ALL "
+            done
+        done
+    done
+}
+
+"$DUCKDB" -c "
+${ATTACH_LAKE}
+CREATE TEMP TABLE probes AS
+SELECT order_id, email_hash FROM BENCH_SRC.PUBLIC.ORDERS USING SAMPLE ${LOOKUPS} ROWS;
+
+.mode box
+SELECT 'orders_plain' AS cache, COUNT(*) AS files, SUM(data_file_size_bytes) AS bytes
+FROM ducklake_list_files('bench_lake', 'orders_plain', schema => 'bench')
+UNION ALL
+SELECT 'orders_bloom', COUNT(*), SUM(data_file_size_bytes)
+FROM ducklake_list_files('bench_lake', 'orders_bloom', schema => 'bench');
+
+-- Row groups that an equality lookup still has to read, averaged over the probes
+WITH probed AS (
+$(probe_union)
+)
+SELECT cache, key_column,
+       COUNT(*) FILTER (WHERE NOT bloom_filter_excludes) / COUNT(DISTINCT probe) AS row_groups_scanned,
+       COUNT(DISTINCT (file, row_group_id)) AS row_groups_total
+FROM probed
+GROUP BY ALL ORDER BY key_column, cache DESC;
+
+-- Constant predicates are pushed into the Parquet scan, where the filters are probed
+.timer on
+SELECT COUNT(*) FROM bench_lake.bench.orders_plain WHERE email_hash = sha256('4242');
+SELECT COUNT(*) FROM bench_lake.bench.orders_bloom WHERE email_hash = sha256('4242');
+SELECT COUNT(*) FROM bench_lake.bench.orders_plain WHERE order_id IN (17, 4242, 99999);
+SELECT COUNT(*) FROM bench_lake.bench.orders_bloom WHERE order_id IN (17, 4242, 99999);
+"
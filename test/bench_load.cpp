@@ -0,0 +1,390 @@
+// test/bench_load.cpp
+//
+// PURPOSE
+// =======
+// Drives the serving paths from many concurrent clients, to find where they stop scaling. All
+// connections share the database's DuckSyncState, so its reader/writer lock, metadata access and
+// refresh leases are the first suspects.
+//
+// HOW
+// ===
+// One process holds a local DuckLake catalog with T cached tables (BENCH_SRC.PUBLIC.T_<i>), and one
+// uncached table, in a DuckDB database standing in for the warehouse (ducksync_source_function =
+// ducksync_emulated_query, see SourceEmulator). For each client count K, K threads each open their
+// own Connection, served by the one ducksync_init of the setup, and issue a weighted random mix of:
+//   scan     SELECT ... FROM T_<i>, routed by the replacement scan
+//   hit      ducksync_query over a cached table
+//   miss     ducksync_query over the uncached table, passed through to the source
+//   refresh  ducksync_refresh, a smart check that normally skips
+//   force    ducksync_refresh(force := true), which takes the lease and rewrites the cache
+// for a fixed time. Optional Quack clients run the same mix at the same time through quack_query()
+// against ducksync_serve, each from its own DuckDB instance.
+//
+// Per (K, client kind, operation) one JSON object reports throughput, p50/p90/p99/max latency,
+// errors and the metadata lookups made while binding on the client's thread. A summary per K
+// reports total QPS, scaling efficiency (QPS per client relative to the first client count) and
+// contention: refreshes that joined another client's in-flight refresh, refreshes skipped because
+// the lease was held, and transaction conflicts. The first error of a round goes to stderr.
+//
+// Requires: the ducklake extension, and quack for Quack clients (installed on first use).
+// Build: make bench-load, or cmake --build build/release --target ducksync_load_bench
+// Usage: ducksync_load_bench [clients=1,4,16,64] [mix=scan:70,hit:20,miss:5,refresh:4,force:1]
+//                            [seconds=10] [quack_clients=0] [tables=8]
+
+#include "ducksync_extension.hpp"
+#include "latency_stats.hpp"
+#include "metadata_manager.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_util.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+using namespace duckdb;
+
+static const char *const BENCH_DIR = "ducksync_load_bench_tmp";
+static const char *const QUACK_URI = "quack:localhost:19557";
+static const char *const QUACK_TOKEN = "ducksync_load_bench";
+static constexpr idx_t TABLE_ROWS = 10000;
+
+enum class LoadOp : uint8_t { SCAN, HIT, MISS, REFRESH, FORCE, COUNT };
+static constexpr idx_t OP_COUNT = static_cast<idx_t>(LoadOp::COUNT);
+
+static const char *LoadOpName(LoadOp op) {
+	switch (op) {
+	case LoadOp::SCAN:
+		return "scan";
+	case LoadOp::HIT:
+		return "hit";
+	case LoadOp::MISS:
+		return "miss";
+	case LoadOp::REFRESH:
+		return "refresh";
+	case LoadOp::FORCE:
+		return "force";
+	case LoadOp::COUNT:
+		break;
+	}
+	return "unknown";
+}
+
+struct OpCounters {
+	LatencyHistogram latency;
+	std::atomic<uint64_t> errors {0};
+	std::atomic<uint64_t> metadata_reads {0};
+};
+
+// Connections and Quack clients are reported apart
+struct ClientKindStats {
+	std::array<OpCounters, OP_COUNT> ops;
+};
+
+struct RoundStats {
+	ClientKindStats connections;
+	ClientKindStats quack;
+	std::atomic<uint64_t> single_flight_joins {0};
+	std::atomic<uint64_t> lease_busy {0};
+	std::atomic<uint64_t> conflicts {0};
+	std::mutex error_lock;
+	std::string first_error;
+};
+
+static void Run(Connection &con, const std::string &sql) {
+	auto result = con.Query(sql);
+	if (result->HasError()) {
+		throw std::runtime_error(sql + ": " + result->GetError());
+	}
+}
+
+static std::string OpSQL(LoadOp op, idx_t table) {
+	auto index = std::to_string(table);
+	switch (op) {
+	case LoadOp::SCAN:
+		return "SELECT COUNT(*), SUM(bucket) FROM T_" + index;
+	case LoadOp::HIT:
+		return "SELECT * FROM ducksync_query('SELECT COUNT(*), SUM(bucket) FROM BENCH_SRC.PUBLIC.T_" + index +
+		       "', 'bench')";
+	case LoadOp::MISS:
+		return "SELECT * FROM ducksync_query('SELECT COUNT(*), SUM(bucket) FROM BENCH_SRC.PUBLIC.UNCACHED', 'bench')";
+	case LoadOp::REFRESH:
+		return "SELECT * FROM ducksync_refresh('cache_" + index + "')";
+	case LoadOp::FORCE:
+		return "SELECT * FROM ducksync_refresh('cache_" + index + "', force := true)";
+	case LoadOp::COUNT:
+		break;
+	}
+	throw std::logic_error("unknown operation");
+}
+
+// The statement as a Quack client sends it to the serving process
+static std::string QuackSQL(const std::string &sql) {
+	return std::string("SELECT * FROM quack_query('") + QUACK_URI + "', '" + StringUtil::Replace(sql, "'", "''") +
+	       "', token := '" + QUACK_TOKEN + "')";
+}
+
+// Times one statement into counters; errors and refresh outcomes feed the contention counts
+static void Execute(Connection &con, const std::string &sql, LoadOp op, OpCounters &counters, RoundStats &stats) {
+	auto reads_before = DuckSyncMetadataManager::ThreadReadCount();
+	auto start = std::chrono::steady_clock::now();
+	auto result = con.Query(sql);
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	counters.latency.Record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+	counters.metadata_reads.fetch_add(DuckSyncMetadataManager::ThreadReadCount() - reads_before,
+	                                  std::memory_order_relaxed);
+
+	if (result->HasError()) {
+		counters.errors.fetch_add(1, std::memory_order_relaxed);
+		auto &error = result->GetError();
+		if (StringUtil::Contains(StringUtil::Lower(error), "conflict")) {
+			stats.conflicts.fetch_add(1, std::memory_order_relaxed);
+		}
+		std::lock_guard<std::mutex> guard(stats.error_lock);
+		if (stats.first_error.empty()) {
+			stats.first_error = std::string(LoadOpName(op)) + ": " + error;
+		}
+		return;
+	}
+	if ((op == LoadOp::REFRESH || op == LoadOp::FORCE) && result->RowCount() > 0) {
+		auto message = result->GetValue(1, 0).ToString();
+		if (StringUtil::StartsWith(message, "Joined in-flight refresh")) {
+			stats.single_flight_joins.fetch_add(1, std::memory_order_relaxed);
+		} else if (result->GetValue(0, 0).ToString() == "LEASE_BUSY") {
+			stats.lease_busy.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+struct LoadConfig {
+	std::vector<idx_t> client_counts = {1, 4, 16, 64};
+	std::array<double, OP_COUNT> weights = {70, 20, 5, 4, 1};
+	idx_t seconds = 10;
+	idx_t quack_clients = 0;
+	idx_t tables = 8;
+};
+
+// Start line shared by all clients of a round, so setup does not count towards the measured time
+struct RoundControl {
+	std::atomic<idx_t> ready {0};
+	std::atomic<bool> go {false};
+	std::atomic<bool> stop {false};
+};
+
+static void RunClient(DuckDB &db, idx_t client, bool quack, const LoadConfig &config, RoundControl &control,
+                      RoundStats &stats) {
+	auto &kind = quack ? stats.quack : stats.connections;
+	// Quack clients are remote processes in production: their own instance, talking to the server only
+	unique_ptr<DuckDB> client_db;
+	if (quack) {
+		client_db = make_uniq<DuckDB>(nullptr);
+	}
+	Connection con(quack ? *client_db : db);
+	if (quack) {
+		Run(con, "INSTALL quack");
+		Run(con, "LOAD quack");
+	}
+
+	std::mt19937_64 rng(1000003 * client + (quack ? 1 : 0));
+	std::discrete_distribution<idx_t> pick_op(config.weights.begin(), config.weights.end());
+	control.ready.fetch_add(1);
+	while (!control.go.load()) {
+		std::this_thread::yield();
+	}
+	while (!control.stop.load(std::memory_order_relaxed)) {
+		auto op = static_cast<LoadOp>(pick_op(rng));
+		auto sql = OpSQL(op, static_cast<idx_t>(rng() % config.tables));
+		Execute(con, quack ? QuackSQL(sql) : sql, op, kind.ops[static_cast<idx_t>(op)], stats);
+	}
+}
+
+static void PrintOp(idx_t clients, const char *kind, const char *op, OpCounters &counters, double seconds) {
+	auto summary = counters.latency.Summarize();
+	if (summary.count == 0) {
+		return;
+	}
+	printf("{\"benchmark\":\"load\",\"clients\":%llu,\"client\":\"%s\",\"op\":\"%s\",\"ops\":%llu,\"qps\":%.1f,"
+	       "\"errors\":%llu,\"metadata_reads_per_op\":%.2f,\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,"
+	       "\"p99_ms\":%.3f,\"max_ms\":%.3f}\n",
+	       static_cast<unsigned long long>(clients), kind, op, static_cast<unsigned long long>(summary.count),
+	       seconds > 0 ? summary.count / seconds : 0.0,
+	       static_cast<unsigned long long>(counters.errors.load()),
+	       static_cast<double>(counters.metadata_reads.load()) / summary.count, summary.mean_ms, summary.p50_ms,
+	       summary.p90_ms, summary.p99_ms, summary.max_ms);
+}
+
+// Returns the QPS of the connection clients
+static double RunRound(DuckDB &db, idx_t clients, const LoadConfig &config, double baseline_qps_per_client) {
+	auto stats = make_uniq<RoundStats>();
+	RoundControl control;
+	std::vector<std::thread> threads;
+	std::vector<std::string> failures(clients + config.quack_clients);
+	for (idx_t i = 0; i < clients + config.quack_clients; i++) {
+		threads.emplace_back([&, i]() {
+			try {
+				RunClient(db, i, i >= clients, config, control, *stats);
+			} catch (const std::exception &e) {
+				failures[i] = e.what();
+				control.ready.fetch_add(1);
+			}
+		});
+	}
+	while (control.ready.load() < threads.size()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	auto start = std::chrono::steady_clock::now();
+	control.go.store(true);
+	std::this_thread::sleep_for(std::chrono::seconds(config.seconds));
+	control.stop.store(true);
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	for (auto &failure : failures) {
+		if (!failure.empty()) {
+			throw std::runtime_error("client setup failed: " + failure);
+		}
+	}
+
+	uint64_t connection_ops = 0;
+	uint64_t quack_ops = 0;
+	for (idx_t op = 0; op < OP_COUNT; op++) {
+		auto name = LoadOpName(static_cast<LoadOp>(op));
+		PrintOp(clients, "connection", name, stats->connections.ops[op], seconds);
+		PrintOp(clients, "quack", name, stats->quack.ops[op], seconds);
+		connection_ops += stats->connections.ops[op].latency.Summarize().count;
+		quack_ops += stats->quack.ops[op].latency.Summarize().count;
+	}
+
+	auto qps = seconds > 0 ? connection_ops / seconds : 0.0;
+	auto per_client = qps / clients;
+	auto baseline = baseline_qps_per_client > 0 ? baseline_qps_per_client : per_client;
+	printf("{\"benchmark\":\"load\",\"clients\":%llu,\"quack_clients\":%llu,\"summary\":true,\"seconds\":%.2f,"
+	       "\"qps\":%.1f,\"quack_qps\":%.1f,\"scaling_efficiency\":%.3f,\"single_flight_joins\":%llu,"
+	       "\"lease_busy\":%llu,\"conflicts\":%llu}\n",
+	       static_cast<unsigned long long>(clients), static_cast<unsigned long long>(config.quack_clients), seconds,
+	       qps, seconds > 0 ? quack_ops / seconds : 0.0, baseline > 0 ? per_client / baseline : 0.0,
+	       static_cast<unsigned long long>(stats->single_flight_joins.load()),
+	       static_cast<unsigned long long>(stats->lease_busy.load()),
+	       static_cast<unsigned long long>(stats->conflicts.load()));
+	fflush(stdout);
+	if (!stats->first_error.empty()) {
+		fprintf(stderr, "ducksync_load_bench: %llu clients, first error: %s\n",
+		        static_cast<unsigned long long>(clients), stats->first_error.c_str());
+	}
+	return per_client;
+}
+
+static void Setup(Connection &con, const LoadConfig &config) {
+	Run(con, "INSTALL ducklake");
+	Run(con, "LOAD ducklake");
+	Run(con, std::string("ATTACH 'ducklake:") + BENCH_DIR + "/bench.ducklake' AS bench_lake (DATA_PATH '" +
+	             BENCH_DIR + "/data/')");
+	Run(con, std::string("ATTACH '") + BENCH_DIR + "/source.duckdb' AS BENCH_SRC");
+	Run(con, "CREATE SCHEMA BENCH_SRC.PUBLIC");
+	auto rows = " AS SELECT range AS id, range % 100 AS bucket FROM range(" + std::to_string(TABLE_ROWS) + ")";
+	Run(con, "CREATE TABLE BENCH_SRC.PUBLIC.UNCACHED" + rows);
+	// Global, so the connections opened by the clients inherit them
+	Run(con, "SET GLOBAL ducksync_install_snowflake = false");
+	Run(con, "SET GLOBAL ducksync_source_function = 'ducksync_emulated_query'");
+	Run(con, "SELECT * FROM ducksync_init('bench_lake')");
+	Run(con, "SELECT * FROM ducksync_add_source('bench', 'snowflake', 'bench_secret', passthrough_enabled := true)");
+	for (idx_t i = 0; i < config.tables; i++) {
+		auto table = "BENCH_SRC.PUBLIC.T_" + std::to_string(i);
+		Run(con, "CREATE TABLE " + table + rows);
+		Run(con, "SELECT * FROM ducksync_create_cache('cache_" + std::to_string(i) + "', 'bench', 'SELECT * FROM " +
+		             table + "', ['" + table + "'], 3600)");
+		auto refresh = con.Query("SELECT result, message FROM ducksync_refresh('cache_" + std::to_string(i) + "')");
+		if (refresh->HasError() || refresh->GetValue(0, 0).ToString() != "REFRESHED") {
+			throw std::runtime_error("initial refresh of cache_" + std::to_string(i) + " failed: " +
+			                         (refresh->HasError() ? refresh->GetError() : refresh->GetValue(1, 0).ToString()));
+		}
+	}
+	if (config.quack_clients > 0) {
+		Run(con, std::string("SELECT * FROM ducksync_serve('") + QUACK_URI + "', token := '" + QUACK_TOKEN + "')");
+	}
+}
+
+static LoadConfig ParseArgs(int argc, char **argv) {
+	LoadConfig config;
+	if (argc > 1) {
+		config.client_counts.clear();
+		for (auto &count : StringUtil::Split(argv[1], ",")) {
+			config.client_counts.push_back(std::stoull(count));
+			if (config.client_counts.back() == 0) {
+				throw std::invalid_argument("client counts must be positive");
+			}
+		}
+	}
+	if (argc > 2) {
+		config.weights.fill(0);
+		for (auto &entry : StringUtil::Split(argv[2], ",")) {
+			auto parts = StringUtil::Split(entry, ":");
+			idx_t op = 0;
+			while (op < OP_COUNT && parts.size() == 2 && parts[0] != LoadOpName(static_cast<LoadOp>(op))) {
+				op++;
+			}
+			if (parts.size() != 2 || op == OP_COUNT) {
+				throw std::invalid_argument("bad mix entry '" + entry +
+				                            "'; expected scan|hit|miss|refresh|force:weight");
+			}
+			config.weights[op] = std::stod(parts[1]);
+		}
+	}
+	if (argc > 3) {
+		config.seconds = std::stoull(argv[3]);
+	}
+	if (argc > 4) {
+		config.quack_clients = std::stoull(argv[4]);
+	}
+	if (argc > 5) {
+		config.tables = std::stoull(argv[5]);
+	}
+	double total_weight = 0;
+	for (auto weight : config.weights) {
+		total_weight += weight;
+	}
+	if (total_weight <= 0 || config.seconds == 0 || config.tables == 0) {
+		throw std::invalid_argument("the mix, seconds and tables must be positive");
+	}
+	return config;
+}
+
+int main(int argc, char **argv) {
+	try {
+		auto config = ParseArgs(argc, argv);
+		auto fs = FileSystem::CreateLocal();
+		if (fs->DirectoryExists(BENCH_DIR)) {
+			fs->RemoveDirectory(BENCH_DIR);
+		}
+		fs->CreateDirectory(BENCH_DIR);
+		{
+			DuckDB db(nullptr);
+			db.LoadStaticExtension<DucksyncExtension>();
+			Connection setup(db);
+			Setup(setup, config);
+
+			double baseline_qps_per_client = 0;
+			for (auto clients : config.client_counts) {
+				auto per_client = RunRound(db, clients, config, baseline_qps_per_client);
+				if (baseline_qps_per_client == 0) {
+					baseline_qps_per_client = per_client;
+				}
+			}
+			if (config.quack_clients > 0) {
+				Run(setup, std::string("SELECT * FROM ducksync_stop('") + QUACK_URI + "')");
+			}
+		}
+		fs->RemoveDirectory(BENCH_DIR);
+	} catch (const std::exception &e) {
+		fprintf(stderr, "ducksync_load_bench: %s\n", e.what());
+		fprintf(stderr, "Usage: ducksync_load_bench [clients=1,4,16,64] [mix=scan:70,hit:20,miss:5,refresh:4,force:1] "
+		                "[seconds=10] [quack_clients=0] [tables=8]\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,185 @@
+// test/bench_refresh.cpp
+//
+// PURPOSE
+// =======
+// Measures refresh throughput and the cost of the invalidation check, per invalidation mode and
+// source size, without a Snowflake account.
+//
+// HOW
+// ===
+// The warehouse is emulated: ducksync_source_function is set to ducksync_emulated_query, which runs
+// source queries against a DuckDB database attached as BENCH_SRC and answers the SHOW TABLES and
+// information_schema.tables probes from its catalog (see SourceEmulator). For each row count N, a
+// fresh local DuckLake catalog and a source table BENCH_SRC.PUBLIC.EVENTS with N generated rows are
+// created. Then, for each invalidation mode, a cache over the table goes through
+// RefreshOrchestrator::Refresh three times:
+//   initial    the first load (forced for manual mode, which never refreshes on its own)
+//   unchanged  a smart refresh with the source untouched: the cost of deciding to skip
+//   changed    a smart refresh after appending N/10 rows to the source
+// Each step prints one JSON object to stdout with its result and decision, rows/s and bytes/s
+// written to DuckLake, peak buffer memory, and the metadata reads and commits and source queries
+// it made. Modes share the source table, so later modes load the rows appended by earlier ones.
+//
+// Requires: the ducklake extension (installed on first use).
+// Build: make bench-refresh, or cmake --build build/release --target ducksync_refresh_bench
+// Usage: ducksync_refresh_bench [row_counts=1000,1000000,100000000] [modes=last_altered,two_stage,ttl_only,manual]
+// The 100M-row size needs several GB of disk in ducksync_refresh_bench_tmp and takes minutes per mode.
+
+#include "ducksync_extension.hpp"
+#include "metadata_manager.hpp"
+#include "query_router.hpp"
+#include "refresh_orchestrator.hpp"
+#include "source_emulator.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/client_context.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+
+using namespace duckdb;
+
+static const char *const BENCH_DIR = "ducksync_refresh_bench_tmp";
+static const char *const SOURCE_TABLE = "BENCH_SRC.PUBLIC.EVENTS";
+static const char *const INVALIDATION_MODES[] = {"last_altered", "two_stage", "ttl_only", "manual"};
+
+static void Run(Connection &con, const std::string &sql) {
+	auto result = con.Query(sql);
+	if (result->HasError()) {
+		throw std::runtime_error(sql + ": " + result->GetError());
+	}
+}
+
+// Source rows [start, end): integer, decimal, string and timestamp columns
+static std::string GeneratedRows(idx_t start, idx_t end) {
+	return "SELECT range AS id, range % 1000 AS customer_id, ((range * 7919) % 100000) / 100.0 AS amount, "
+	       "'kind_' || (range % 97) AS kind, TIMESTAMP '2024-01-01' + to_seconds(range % 31536000) AS created_at "
+	       "FROM range(" +
+	       std::to_string(start) + ", " + std::to_string(end) + ")";
+}
+
+static void BenchStep(RefreshOrchestrator &orchestrator, const std::string &cache_name, const std::string &mode,
+                      const char *step, idx_t source_rows, bool force) {
+	auto reads_before = DuckSyncMetadataManager::ThreadReadCount();
+	auto queries_before = SourceEmulator::QueryCount();
+	auto start = std::chrono::steady_clock::now();
+	auto status = orchestrator.Refresh(cache_name, force);
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (status.result == RefreshResult::ERROR) {
+		throw std::runtime_error(cache_name + " " + step + ": " + status.message);
+	}
+
+	auto &metrics = status.metrics;
+	printf("{\"benchmark\":\"refresh\",\"source_rows\":%llu,\"mode\":\"%s\",\"step\":\"%s\",\"result\":\"%s\","
+	       "\"decision\":\"%s\",\"rows_refreshed\":%lld,\"seconds\":%.4f,\"rows_per_sec\":%.1f,"
+	       "\"bytes_written\":%lld,\"bytes_per_sec\":%.1f,\"peak_memory_bytes\":%llu,\"metadata_reads\":%llu,"
+	       "\"metadata_commits\":%lld,\"source_queries\":%llu}\n",
+	       static_cast<unsigned long long>(source_rows), mode.c_str(), step,
+	       RefreshResultToString(status.result).c_str(), status.decision.c_str(),
+	       static_cast<long long>(status.rows_refreshed), seconds,
+	       seconds > 0 ? static_cast<double>(status.rows_refreshed) / seconds : 0.0,
+	       static_cast<long long>(metrics.bytes_written),
+	       seconds > 0 ? static_cast<double>(metrics.bytes_written) / seconds : 0.0,
+	       static_cast<unsigned long long>(metrics.peak_memory_bytes),
+	       static_cast<unsigned long long>(DuckSyncMetadataManager::ThreadReadCount() - reads_before),
+	       static_cast<long long>(metrics.metadata_commits),
+	       static_cast<unsigned long long>(SourceEmulator::QueryCount() - queries_before));
+	fflush(stdout);
+}
+
+static void BenchRowCount(FileSystem &fs, idx_t row_count, const std::vector<std::string> &modes) {
+	// A fresh catalog and source per size, so every run starts from the same layout
+	if (fs.DirectoryExists(BENCH_DIR)) {
+		fs.RemoveDirectory(BENCH_DIR);
+	}
+	fs.CreateDirectory(BENCH_DIR);
+	SourceEmulator::Reset();
+
+	DuckDB db(nullptr);
+	db.LoadStaticExtension<DucksyncExtension>();
+	Connection con(db);
+	Run(con, "INSTALL ducklake");
+	Run(con, "LOAD ducklake");
+	Run(con, std::string("ATTACH 'ducklake:") + BENCH_DIR + "/bench.ducklake' AS bench_lake (DATA_PATH '" +
+	             BENCH_DIR + "/data/')");
+	Run(con, std::string("ATTACH '") + BENCH_DIR + "/source.duckdb' AS BENCH_SRC");
+	Run(con, "CREATE SCHEMA BENCH_SRC.PUBLIC");
+	Run(con, std::string("CREATE TABLE ") + SOURCE_TABLE + " AS " + GeneratedRows(0, row_count));
+	Run(con, "SET ducksync_install_snowflake = false");
+	Run(con, "SET ducksync_source_function = 'ducksync_emulated_query'");
+	Run(con, "SELECT * FROM ducksync_init('bench_lake')");
+
+	auto &context = *con.context;
+	auto &state = GetDuckSyncState(context);
+	SourceDefinition source;
+	source.source_name = "bench";
+	source.driver_type = "snowflake";
+	source.secret_name = "bench_secret";
+	state.metadata_manager->CreateSource(source);
+
+	RefreshOrchestrator orchestrator(context, *state.metadata_manager, *state.storage_manager);
+	auto next_id = row_count;
+	for (auto &mode : modes) {
+		CacheDefinition cache;
+		cache.cache_name = "events_" + mode;
+		cache.source_name = source.source_name;
+		cache.source_query = std::string("SELECT * FROM ") + SOURCE_TABLE;
+		cache.monitor_tables.push_back(SOURCE_TABLE);
+		cache.invalidation_mode = mode;
+		if (mode == "two_stage") {
+			cache.metadata_secret_name = source.secret_name;
+		}
+		if (mode == "ttl_only") {
+			cache.has_ttl = true;
+			cache.ttl_seconds = 3600;
+		}
+		state.metadata_manager->CreateCache(cache);
+
+		BenchStep(orchestrator, cache.cache_name, mode, "initial", row_count, mode == "manual");
+		BenchStep(orchestrator, cache.cache_name, mode, "unchanged", row_count, false);
+		auto appended = MaxValue<idx_t>(row_count / 10, 1);
+		Run(con, std::string("INSERT INTO ") + SOURCE_TABLE + " " + GeneratedRows(next_id, next_id + appended));
+		next_id += appended;
+		BenchStep(orchestrator, cache.cache_name, mode, "changed", row_count, false);
+	}
+}
+
+int main(int argc, char **argv) {
+	std::vector<idx_t> row_counts = {1000, 1000000, 100000000};
+	std::vector<std::string> modes(std::begin(INVALIDATION_MODES), std::end(INVALIDATION_MODES));
+	try {
+		if (argc > 1) {
+			row_counts.clear();
+			for (auto &count : StringUtil::Split(argv[1], ",")) {
+				row_counts.push_back(std::stoull(count));
+			}
+		}
+		if (argc > 2) {
+			modes = StringUtil::Split(argv[2], ",");
+			for (auto &mode : modes) {
+				if (std::find(std::begin(INVALIDATION_MODES), std::end(INVALIDATION_MODES), mode) ==
+				    std::end(INVALIDATION_MODES)) {
+					throw std::invalid_argument("unknown invalidation mode '" + mode + "'");
+				}
+			}
+		}
+
+		auto fs = FileSystem::CreateLocal();
+		for (auto row_count : row_counts) {
+			if (row_count == 0) {
+				throw std::invalid_argument("row counts must be positive");
+			}
+			BenchRowCount(*fs, row_count, modes);
+		}
+		fs->RemoveDirectory(BENCH_DIR);
+	} catch (const std::exception &e) {
+		fprintf(stderr, "ducksync_refresh_bench: %s\n", e.what());
+		fprintf(stderr, "Usage: ducksync_refresh_bench [row_counts=1000,1000000,100000000] "
+		                "[modes=last_altered,two_stage,ttl_only,manual]\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,213 @@
+// test/bench_replacement_scan.cpp
+//
+// PURPOSE
+// =======
+// Measures how long the replacement scan takes to resolve a table reference to a cache, and how
+// that grows with the number of caches. Every plain read of a table name goes through it, including
+// reads of tables DuckSync does not cache.
+//
+// HOW
+// ===
+// For each cache count N, a fresh local DuckLake catalog (a DuckDB file; no PostgreSQL or Snowflake)
+// gets N synthetic caches with M monitor tables each (BENCH_DB.PUBLIC.T_<cache>_<table>), all
+// marked as refreshed. QueryRouter::ResolveTable, the replacement scan, is then timed for:
+//   cache_name  the cache read by name (a direct cache lookup)
+//   full_path   a monitored table read as BENCH_DB.PUBLIC.T_<cache>_<table>
+//   suffix      a monitored table read by its bare name, matched on the last path part
+//   miss        a table no cache monitors
+// Targets are drawn at random with a fixed seed, so runs are comparable. Each (N, case) pair prints
+// one JSON object to stdout with throughput and p50/p90/p99/max latency in microseconds.
+//
+// Requires: the ducklake extension (installed on first use).
+// Build: make bench, or cmake --build build/release --target ducksync_bench
+// Usage: ducksync_bench [cache_counts=10,100,1000] [monitor_tables=4] [iterations=2000]
+
+#include "ducksync_extension.hpp"
+#include "latency_stats.hpp"
+#include "query_router.hpp"
+#include "duckdb.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include "duckdb/function/replacement_scan.hpp"
+#include "duckdb/main/client_context.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+using namespace duckdb;
+
+static const char *const BENCH_DIR = "ducksync_bench_tmp";
+static constexpr idx_t WARMUP_ITERATIONS = 50;
+
+enum class LookupCase { CACHE_NAME, FULL_PATH, SUFFIX, MISS };
+
+static const char *LookupCaseName(LookupCase lookup_case) {
+	switch (lookup_case) {
+	case LookupCase::CACHE_NAME:
+		return "cache_name";
+	case LookupCase::FULL_PATH:
+		return "full_path";
+	case LookupCase::SUFFIX:
+		return "suffix";
+	case LookupCase::MISS:
+		return "miss";
+	}
+	return "unknown";
+}
+
+static void Run(Connection &con, const std::string &sql) {
+	auto result = con.Query(sql);
+	if (result->HasError()) {
+		throw std::runtime_error(sql + ": " + result->GetError());
+	}
+}
+
+static std::string MonitorTable(idx_t cache, idx_t table) {
+	return "T_" + std::to_string(cache) + "_" + std::to_string(table);
+}
+
+// N caches with M monitor tables each, all with a last refresh so the scan routes them
+static void CreateCaches(DuckSyncState &state, idx_t cache_count, idx_t monitor_tables) {
+	SourceDefinition source;
+	source.source_name = "bench";
+	source.driver_type = "snowflake";
+	source.secret_name = "bench_secret";
+	state.metadata_manager->CreateSource(source);
+
+	auto now = Timestamp::ToString(Timestamp::GetCurrentTimestamp());
+	for (idx_t i = 0; i < cache_count; i++) {
+		CacheDefinition cache;
+		cache.cache_name = "bench_cache_" + std::to_string(i);
+		cache.source_name = source.source_name;
+		cache.source_query = "SELECT 1";
+		for (idx_t j = 0; j < monitor_tables; j++) {
+			cache.monitor_tables.push_back("BENCH_DB.PUBLIC." + MonitorTable(i, j));
+		}
+		state.metadata_manager->CreateCache(cache);
+
+		CacheState cache_state;
+		cache_state.cache_name = cache.cache_name;
+		cache_state.last_refresh = now;
+		cache_state.refresh_count = 1;
+		state.metadata_manager->UpdateState(cache_state);
+	}
+}
+
+static void BenchCase(ClientContext &context, LookupCase lookup_case, idx_t cache_count, idx_t monitor_tables,
+                      idx_t iterations) {
+	std::mt19937_64 rng(42);
+	LatencyHistogram histogram;
+	idx_t resolved = 0;
+	double total_seconds = 0;
+
+	for (idx_t iteration = 0; iteration < WARMUP_ITERATIONS + iterations; iteration++) {
+		auto cache = static_cast<idx_t>(rng() % cache_count);
+		auto table = static_cast<idx_t>(rng() % monitor_tables);
+		std::string catalog_name;
+		std::string schema_name;
+		std::string table_name;
+		switch (lookup_case) {
+		case LookupCase::CACHE_NAME:
+			table_name = "bench_cache_" + std::to_string(cache);
+			break;
+		case LookupCase::FULL_PATH:
+			catalog_name = "BENCH_DB";
+			schema_name = "PUBLIC";
+			table_name = MonitorTable(cache, table);
+			break;
+		case LookupCase::SUFFIX:
+			table_name = MonitorTable(cache, table);
+			break;
+		case LookupCase::MISS:
+			table_name = "NOT_CACHED_" + std::to_string(cache);
+			break;
+		}
+		ReplacementScanInput input(catalog_name, schema_name, table_name);
+
+		auto start = std::chrono::steady_clock::now();
+		auto ref = QueryRouter::ResolveTable(context, input);
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		if (iteration < WARMUP_ITERATIONS) {
+			continue;
+		}
+		histogram.Record(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+		total_seconds += std::chrono::duration<double>(elapsed).count();
+		if (ref) {
+			resolved++;
+		}
+	}
+
+	auto summary = histogram.Summarize();
+	printf("{\"benchmark\":\"replacement_scan\",\"case\":\"%s\",\"caches\":%llu,\"monitor_tables\":%llu,"
+	       "\"iterations\":%llu,\"resolved\":%llu,\"ops_per_sec\":%.1f,\"mean_us\":%.1f,\"p50_us\":%.1f,"
+	       "\"p90_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}\n",
+	       LookupCaseName(lookup_case), static_cast<unsigned long long>(cache_count),
+	       static_cast<unsigned long long>(monitor_tables), static_cast<unsigned long long>(iterations),
+	       static_cast<unsigned long long>(resolved), total_seconds > 0 ? iterations / total_seconds : 0.0,
+	       summary.mean_ms * 1000.0, summary.p50_ms * 1000.0, summary.p90_ms * 1000.0, summary.p99_ms * 1000.0,
+	       summary.max_ms * 1000.0);
+	fflush(stdout);
+}
+
+static void BenchCacheCount(FileSystem &fs, idx_t cache_count, idx_t monitor_tables, idx_t iterations) {
+	// A fresh catalog per size, so every run starts from the same metadata layout
+	if (fs.DirectoryExists(BENCH_DIR)) {
+		fs.RemoveDirectory(BENCH_DIR);
+	}
+	fs.CreateDirectory(BENCH_DIR);
+
+	DuckDB db(nullptr);
+	db.LoadStaticExtension<DucksyncExtension>();
+	Connection con(db);
+	Run(con, "INSTALL ducklake");
+	Run(con, "LOAD ducklake");
+	Run(con, std::string("ATTACH 'ducklake:") + BENCH_DIR + "/bench.ducklake' AS bench_lake (DATA_PATH '" +
+	             BENCH_DIR + "/data/')");
+	Run(con, "SET ducksync_install_snowflake = false");
+	Run(con, "SELECT * FROM ducksync_init('bench_lake')");
+
+	auto &context = *con.context;
+	CreateCaches(GetDuckSyncState(context), cache_count, monitor_tables);
+	for (auto lookup_case : {LookupCase::CACHE_NAME, LookupCase::FULL_PATH, LookupCase::SUFFIX, LookupCase::MISS}) {
+		BenchCase(context, lookup_case, cache_count, monitor_tables, iterations);
+	}
+}
+
+int main(int argc, char **argv) {
+	std::vector<idx_t> cache_counts = {10, 100, 1000};
+	idx_t monitor_tables = 4;
+	idx_t iterations = 2000;
+	try {
+		if (argc > 1) {
+			cache_counts.clear();
+			for (auto &count : StringUtil::Split(argv[1], ",")) {
+				cache_counts.push_back(std::stoull(count));
+			}
+		}
+		if (argc > 2) {
+			monitor_tables = std::stoull(argv[2]);
+		}
+		if (argc > 3) {
+			iterations = std::stoull(argv[3]);
+		}
+		if (monitor_tables == 0 || iterations == 0) {
+			throw std::invalid_argument("monitor_tables and iterations must be positive");
+		}
+
+		auto fs = FileSystem::CreateLocal();
+		for (auto cache_count : cache_counts) {
+			if (cache_count == 0) {
+				throw std::invalid_argument("cache counts must be positive");
+			}
+			BenchCacheCount(*fs, cache_count, monitor_tables, iterations);
+		}
+		fs->RemoveDirectory(BENCH_DIR);
+	} catch (const std::exception &e) {
+		fprintf(stderr, "ducksync_bench: %s\n", e.what());
+		fprintf(stderr, "Usage: ducksync_bench [cache_counts=10,100,1000] [monitor_tables=4] [iterations=2000]\n");
+		return 1;
+	}
+	return 0;
+}
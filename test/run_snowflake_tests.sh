@@ -353,11 +353,13 @@ SELECT 'TS10_CACHED_COUNT=' || CAST(cnt AS VARCHAR) FROM ducksync_query(
     'sf'
 );
 SELECT 'TS11_SNAPSHOT_COUNT=' || CAST(COUNT(*) AS VARCHAR)
-FROM ducksync.ducksync.table_snapshots
-WHERE cache_name = 'customers_ts';
+FROM (FROM ducksync.ducksync.table_snapshots WHERE cache_name = 'customers_ts'
+      QUALIFY rank() OVER (ORDER BY version DESC NULLS LAST) = 1)
+WHERE deleted IS NOT TRUE;
 SELECT 'TS11_SOURCE_TABLE=' || source_table
-FROM ducksync.ducksync.table_snapshots
-WHERE cache_name = 'customers_ts'
+FROM (FROM ducksync.ducksync.table_snapshots WHERE cache_name = 'customers_ts'
+      QUALIFY rank() OVER (ORDER BY version DESC NULLS LAST) = 1)
+WHERE deleted IS NOT TRUE
 ORDER BY source_table;
 " 2>&1)
 